@@ -30,14 +30,20 @@
 #define NUM_PAGES   1
 #endif
 
+#include <string.h>
 #include <utest/utest.h>
 #include <unity/unity.h>
+
+// the storage class under test, the host build uses the simulated flash
+#ifndef FLASH_STORAGE_TYPE
 #include <NRF52FlashStorage.h>
+#define FLASH_STORAGE_TYPE NRF52FlashStorage
+#endif
 
 using namespace utest::v1;
 
 control_t TestStorage(const size_t n) {
-    NRF52FlashStorage flashStorage;
+    FLASH_STORAGE_TYPE flashStorage;
 
     uint32_t location = (uint32_t) (0x3000 - 0x40 + 16 * n);
     const uint8_t writeData[16] = {0xA1, 0xB2, 0xC3, 0xD4,
@@ -61,7 +67,7 @@ control_t TestStorage(const size_t n) {
 }
 
 void TestStorageErasePages() {
-    NRF52FlashStorage flashStorage;
+    FLASH_STORAGE_TYPE flashStorage;
     uint32_t location = 0;
     uint8_t writeByte = 0x5A;
     uint8_t readByte1 = 0x00;
@@ -93,7 +99,7 @@ void TestStorageErasePages() {
 }
 
 void TestStorageWriteSubsequentBytes() {
-    NRF52FlashStorage flashStorage;
+    FLASH_STORAGE_TYPE flashStorage;
     uint32_t location = 0x00;
     const uint8_t writeData[16] = {0xA1, 0xB2, 0xC3, 0xD4,
                                    0xE5, 0xF6, 0x07, 0x18,
@@ -122,7 +128,7 @@ void TestStorageWriteSubsequentBytes() {
 }
 
 void TestStorageWriteAboveEndAddress() {
-    NRF52FlashStorage flashStorage;
+    FLASH_STORAGE_TYPE flashStorage;
     uint32_t location;
     const uint8_t writeByte = 0xEA;
     uint8_t readByte = 0x00;
@@ -143,7 +149,7 @@ void TestStorageWriteAboveEndAddress() {
  * @note    This test fails, if only one page is reserved
  */
 void TestStorageWriteOverPageBoarder() {
-    NRF52FlashStorage flashStorage;
+    FLASH_STORAGE_TYPE flashStorage;
     uint32_t location = 0x1000 - 0x08;
     const uint8_t writeData[16] = {0xA1, 0xB2, 0xC3, 0xD4,
                                    0xE5, 0xF6, 0x07, 0x18,
@@ -165,7 +171,7 @@ void TestStorageWriteOverPageBoarder() {
 
 
 void TestStorageWriteOverUpperBound() {
-    NRF52FlashStorage flashStorage;
+    FLASH_STORAGE_TYPE flashStorage;
     uint16_t length = 0x20;
     uint32_t location = (uint32_t) NUM_PAGES * 0x1000 - (length >> 1);
     uint8_t writeData[length];
@@ -189,8 +195,8 @@ void TestStorageWriteOverUpperBound() {
  * @note this test fails if the number of pages < 3
  */
 void TestStorageWriteBigBuffer() {
-    NRF52FlashStorage flashStorage;
-    uint16_t length = 0x200;
+    FLASH_STORAGE_TYPE flashStorage;
+    const uint16_t length = 0x200;
     uint32_t location = (uint32_t) 0x2000 - (length >> 1);
     uint8_t writeData[length];
     uint8_t readData[length];
@@ -207,4 +213,75 @@ void TestStorageWriteBigBuffer() {
                                          "data read does not match written data");
 }
 
+/*!
+ * @note this test fails if the number of pages < 4
+ */
+void TestStorageWriteLargeTransfer() {
+    FLASH_STORAGE_TYPE flashStorage;
+    static uint8_t data[0x2100];
+    const uint32_t location = 0x0FFE;
+
+    for (uint32_t i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t) ((i * 7) ^ (i >> 8));
+    }
+    TEST_ASSERT_TRUE(flashStorage.erasePage(0, 4));
+    TEST_ASSERT_TRUE_MESSAGE(flashStorage.writeData(location, data, sizeof(data)),
+                             "failed to write multiple pages");
+
+    memset(data, 0, sizeof(data));
+    TEST_ASSERT_TRUE_MESSAGE(flashStorage.readData(location, data, sizeof(data)),
+                             "failed to read multiple pages");
+    for (uint32_t i = 0; i < sizeof(data); i++) {
+        TEST_ASSERT_EQUAL_HEX8_MESSAGE((uint8_t) ((i * 7) ^ (i >> 8)), data[i],
+                                       "data read does not match written data");
+    }
+
+    // lengths that wrap around the address space are refused
+    TEST_ASSERT_TRUE_MESSAGE(!flashStorage.writeData(location, data, 0xFFFFFFFF), "wrapping write succeeded");
+    TEST_ASSERT_TRUE_MESSAGE(!flashStorage.readData(location, data, 0xFFFFFFFF), "wrapping read succeeded");
+
+    TEST_ASSERT_TRUE(flashStorage.erasePage(0, 4));
+}
+
+static volatile bool asyncDone;
+static fs_ret_t asyncResult;
+
+static void asyncCallback(void *context, fs_ret_t result) {
+    (void) context;
+    asyncResult = result;
+    asyncDone = true;
+}
+
+void TestStorageWriteEraseAsync() {
+    FLASH_STORAGE_TYPE flashStorage;
+    uint32_t location = 0x3802;
+    const uint8_t expected[16] = {0xA1, 0xB2, 0xC3, 0xD4,
+                                  0xE5, 0xF6, 0x07, 0x18,
+                                  0x29, 0x3A, 0x4B, 0x5C,
+                                  0x6D, 0x7E, 0x8F, 0x90};
+    uint8_t writeData[16];
+    uint8_t readData[16];
+
+    memcpy(writeData, expected, sizeof(writeData));
+    asyncDone = false;
+    TEST_ASSERT_TRUE_MESSAGE(flashStorage.writeDataAsync(location, (const unsigned char *) writeData,
+                                                         sizeof(writeData), asyncCallback, NULL),
+                             "failed to queue write");
+    // the data has been copied, the buffer can be reused right away
+    memset(writeData, 0, sizeof(writeData));
+    while (!asyncDone) /* wait */;
+    TEST_ASSERT_EQUAL_MESSAGE(FS_SUCCESS, asyncResult, "write failed");
+    TEST_ASSERT_TRUE_MESSAGE(flashStorage.readData(location, (unsigned char *) readData, sizeof(readData)),
+                             "failed to read from storage");
+    TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(expected, readData, sizeof(expected),
+                                         "data read does not match written data");
+
+    asyncDone = false;
+    TEST_ASSERT_TRUE_MESSAGE(flashStorage.erasePageAsync(3, 1, asyncCallback, NULL),
+                             "failed to queue erase");
+    while (!asyncDone) /* wait */;
+    TEST_ASSERT_EQUAL_MESSAGE(FS_SUCCESS, asyncResult, "erase failed");
+    TEST_ASSERT_TRUE_MESSAGE(flashStorage.isErased(location, sizeof(readData)), "page not erased");
+}
+
 #endif //UBIRCH_MBED_NRF52_STORAGE_ADVANCEDFLASHSTORAGETESTS_H
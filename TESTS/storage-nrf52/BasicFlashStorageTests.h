@@ -26,14 +26,21 @@
 #ifndef UBIRCH_MBED_NRF52_STORAGE_BASICFLASHSTORAGETESTS_H
 #define UBIRCH_MBED_NRF52_STORAGE_BASICFLASHSTORAGETESTS_H
 
+#include <stdio.h>
 #include <unity/unity.h>
 
+// the storage class under test, the host build uses the simulated flash
+#ifndef FLASH_STORAGE_TYPE
+#include <NRF52FlashStorage.h>
+#define FLASH_STORAGE_TYPE NRF52FlashStorage
+#endif
+
 #ifndef NUM_PAGES
 #define NUM_PAGES   1
 #endif
 
 void TestStorageWriteWord() {
-    NRF52FlashStorage flashStorage;
+    FLASH_STORAGE_TYPE flashStorage;
     const uint32_t writeData = 0xA1B2C3D4;
     uint32_t readData = 0x000000;
 
@@ -45,7 +52,7 @@ void TestStorageWriteWord() {
 }
 
 void TestStorageWriteMultipleWords() {
-    NRF52FlashStorage flashStorage;
+    FLASH_STORAGE_TYPE flashStorage;
     const uint8_t writeData[8] = {0xA1, 0xB2, 0xC3, 0xD4,
                                   0xE5, 0xF6, 0x07, 0x18};
     uint8_t readData[8] = {0x00, 0x00, 0x00, 0x00,
@@ -60,7 +67,7 @@ void TestStorageWriteMultipleWords() {
 }
 
 void TestStorageWriteSingleByte() {
-    NRF52FlashStorage flashStorage;
+    FLASH_STORAGE_TYPE flashStorage;
     const uint8_t writeData = 0x2C;
     uint8_t readData = 0x00;
 
@@ -72,7 +79,7 @@ void TestStorageWriteSingleByte() {
 }
 
 void TestStorageWriteHalfWord() {
-    NRF52FlashStorage flashStorage;
+    FLASH_STORAGE_TYPE flashStorage;
     const uint8_t writeData[4] = {0xA1, 0xB2, 0xC3, 0xD4};
     const uint8_t readDataExpected[4] = {0xA1, 0xB2, 0x00, 0x00};
     uint8_t readData[4] = {0x00, 0x00, 0x00, 0x00};
@@ -86,7 +93,7 @@ void TestStorageWriteHalfWord() {
 }
 
 void TestStorageWriteThreeBytes() {
-    NRF52FlashStorage flashStorage;
+    FLASH_STORAGE_TYPE flashStorage;
     const uint8_t writeData[3] = {0xB4, 0xC3, 0xD1};
     uint8_t readData[3] = {0x00, 0x00, 0x00};
 
@@ -99,7 +106,7 @@ void TestStorageWriteThreeBytes() {
 }
 
 void TestStorageWriteWordAndHalfWord() {
-    NRF52FlashStorage flashStorage;
+    FLASH_STORAGE_TYPE flashStorage;
     const uint8_t writeData[8] = {0xA1, 0xB2, 0xC3, 0xD4,
                                   0xE5, 0xF6, 0x07, 0x18};
     const uint8_t readDataExpected[8] = {0xA1, 0xB2, 0xC3, 0xD4,
@@ -116,7 +123,7 @@ void TestStorageWriteWordAndHalfWord() {
 }
 
 void TestStorageWriteBuffer() {
-    NRF52FlashStorage flashStorage;
+    FLASH_STORAGE_TYPE flashStorage;
     uint8_t writeData[12 * 4];
     uint8_t readData[12 * 4];
 
@@ -135,7 +142,7 @@ void TestStorageWriteBuffer() {
 }
 
 void TestStorageWriteFailOnUsedFlash() {
-    NRF52FlashStorage flashStorage;
+    FLASH_STORAGE_TYPE flashStorage;
 
     const uint32_t writeData = 0xA1B2C3D4;
     const uint32_t writeData2 = 0x4D3C2B1A;
@@ -158,7 +165,7 @@ void TestStorageWriteFailOnUsedFlash() {
 }
 
 void TestStorageWriteNonAligned() {
-    NRF52FlashStorage flashStorage;
+    FLASH_STORAGE_TYPE flashStorage;
     const uint32_t writeData = 0xA1B2C3D4;
     uint32_t readData = 0x000000;
 
@@ -170,4 +177,227 @@ void TestStorageWriteNonAligned() {
 
 }
 
+void TestStorageBlankCheck() {
+    FLASH_STORAGE_TYPE flashStorage;
+    const uint8_t writeData[3] = {0x5A, 0xFF, 0xA5};
+
+    TEST_ASSERT_TRUE_MESSAGE(flashStorage.isErased(0x1F0, 0x20), "erased area is not blank");
+    TEST_ASSERT_TRUE_MESSAGE(flashStorage.writeData(0x203, (const unsigned char *) writeData, sizeof(writeData)),
+                             "failed to write to storage");
+
+    TEST_ASSERT_TRUE_MESSAGE(flashStorage.isErased(0x200, 3), "blank head reported as not blank");
+    TEST_ASSERT_TRUE_MESSAGE(!flashStorage.isErased(0x200, 4), "written byte not detected");
+    TEST_ASSERT_TRUE_MESSAGE(flashStorage.isErased(0x206, 0x1A), "blank tail reported as not blank");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0x13, flashStorage.findFirstNonBlank(0x1F0, 0x20),
+                                     "wrong position of the first non-blank byte");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(1, flashStorage.findFirstNonBlank(0x204, 0x10),
+                                     "wrong position of the first non-blank byte");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0x20, flashStorage.findFirstNonBlank(0x206, 0x20),
+                                     "wrong length of a blank area");
+}
+
+void TestStorageMap() {
+    FLASH_STORAGE_TYPE flashStorage;
+    const uint8_t writeData[7] = {0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD};
+    const uint32_t size = flashStorage.getEndAddress() - flashStorage.getStartAddress();
+
+    TEST_ASSERT_TRUE_MESSAGE(flashStorage.writeData(0x231, (const unsigned char *) writeData, sizeof(writeData)),
+                             "failed to write to storage");
+
+    const uint8_t *mapped = flashStorage.map(0x231, sizeof(writeData));
+    TEST_ASSERT_TRUE_MESSAGE(mapped != NULL, "failed to map storage");
+    TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(writeData, mapped, sizeof(writeData),
+                                         "mapped data does not match written data");
+
+    TEST_ASSERT_TRUE_MESSAGE(flashStorage.map(size - 4, 4) != NULL, "failed to map the end of the storage");
+    TEST_ASSERT_TRUE_MESSAGE(flashStorage.map(size - 4, 5) == NULL, "mapped area beyond the storage");
+}
+
+void TestStorageUpdateData() {
+    FLASH_STORAGE_TYPE flashStorage;
+    const uint8_t neighbour[4] = {0x11, 0x22, 0x33, 0x44};
+    const uint8_t first[8] = {0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8};
+    const uint8_t cleared[8] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08};
+    const uint8_t changed[4] = {0xA0, 0xB0, 0xC0, 0xD0};
+    const uint8_t expected[8] = {0x01, 0x02, 0xA0, 0xB0, 0xC0, 0xD0, 0x07, 0x08};
+    uint8_t readData[8];
+
+    TEST_ASSERT_TRUE(flashStorage.writeData(0x2FC, neighbour, sizeof(neighbour)));
+
+    // blank area
+    TEST_ASSERT_TRUE_MESSAGE(flashStorage.updateData(0x300, first, sizeof(first)), "failed to update blank area");
+    TEST_ASSERT_TRUE(flashStorage.readData(0x300, readData, sizeof(readData)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(first, readData, sizeof(first), "data read does not match update");
+
+    // only bits cleared
+    TEST_ASSERT_TRUE_MESSAGE(flashStorage.updateData(0x300, cleared, sizeof(cleared)), "failed to clear bits");
+    TEST_ASSERT_TRUE(flashStorage.readData(0x300, readData, sizeof(readData)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(cleared, readData, sizeof(cleared), "data read does not match update");
+
+    // bits set again, the page is rewritten and the rest of it is kept
+    TEST_ASSERT_TRUE_MESSAGE(flashStorage.updateData(0x302, changed, sizeof(changed)), "failed to rewrite page");
+    TEST_ASSERT_TRUE(flashStorage.readData(0x300, readData, sizeof(readData)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(expected, readData, sizeof(expected), "data read does not match update");
+    TEST_ASSERT_TRUE(flashStorage.readData(0x2FC, readData, sizeof(neighbour)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(neighbour, readData, sizeof(neighbour), "neighbouring data lost");
+    TEST_ASSERT_TRUE_MESSAGE(flashStorage.isErased(0x308, 0x100), "blank area not blank after rewrite");
+
+    // across a page border
+    TEST_ASSERT_TRUE(flashStorage.updateData(0xFFC, cleared, sizeof(cleared)));
+    TEST_ASSERT_TRUE_MESSAGE(flashStorage.updateData(0xFFE, changed, sizeof(changed)), "failed to rewrite pages");
+    TEST_ASSERT_TRUE(flashStorage.readData(0xFFC, readData, sizeof(readData)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(expected, readData, sizeof(expected), "data read does not match update");
+}
+
+void TestStorageStats() {
+    FLASH_STORAGE_TYPE flashStorage;
+    const uint8_t writeData[6] = {0x5A, 0x6B, 0x7C, 0x8D, 0x9E, 0xAF};
+    uint8_t readData[6];
+    FlashStorageStats stats;
+
+    flashStorage.resetStats();
+    TEST_ASSERT_TRUE(flashStorage.writeData(0x501, writeData, sizeof(writeData)));
+    TEST_ASSERT_TRUE(flashStorage.readData(0x501, readData, sizeof(readData)));
+    TEST_ASSERT_TRUE(!flashStorage.writeData(0x503, writeData, 1));
+    TEST_ASSERT_TRUE(flashStorage.erasePage(2, 1));
+
+#if STORAGE_STATS
+    TEST_ASSERT_TRUE_MESSAGE(flashStorage.getStats(stats, true), "no statistics");
+
+    // everything is counted on the path in use, the other one stays empty
+    const bool softdevice = stats.softdevice.writes > 0;
+    const FlashStoragePathStats &path = softdevice ? stats.softdevice : stats.nosd;
+    const FlashStoragePathStats &other = softdevice ? stats.nosd : stats.softdevice;
+    printf("%s: %u waits, %u us (max %u us)\r\n", softdevice ? "softdevice" : "nosd",
+           (unsigned int) path.waits, (unsigned int) path.waitTimeUs, (unsigned int) path.maxWaitUs);
+    TEST_ASSERT_EQUAL_UINT32(1, path.writes);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(writeData), path.bytesWritten);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(2, path.wordsProgrammed, "padded words not counted");
+    TEST_ASSERT_TRUE(path.reads >= 1);
+    TEST_ASSERT_TRUE(path.bytesRead >= sizeof(readData));
+    TEST_ASSERT_EQUAL_UINT32(1, path.blankCheckFailures);
+    TEST_ASSERT_EQUAL_UINT32(1, path.erases);
+    TEST_ASSERT_EQUAL_UINT32(2, path.waits);
+    TEST_ASSERT_TRUE_MESSAGE(path.maxWaitUs > 0 && path.maxWaitUs <= path.waitTimeUs, "wait time not measured");
+    TEST_ASSERT_EQUAL_UINT32(0, other.writes + other.reads + other.erases + other.waits);
+
+    // reading with reset cleared the statistics
+    TEST_ASSERT_TRUE(flashStorage.getStats(stats));
+    TEST_ASSERT_EQUAL_UINT32(0, stats.softdevice.writes + stats.nosd.writes);
+#else
+    TEST_ASSERT_TRUE_MESSAGE(!flashStorage.getStats(stats), "statistics compiled out");
+    TEST_ASSERT_EQUAL_UINT32(0, stats.softdevice.writes + stats.nosd.writes);
+#endif
+}
+
+void TestStorageTimeout() {
+    FLASH_STORAGE_TYPE flashStorage;
+    const uint8_t writeData[5] = {0x70, 0x1A, 0x2B, 0x3C, 0x4D};
+    uint8_t readData[5];
+
+    TEST_ASSERT_TRUE(flashStorage.erasePage(1, 1));
+    TEST_ASSERT_EQUAL(FS_SUCCESS, flashStorage.getLastError());
+
+#if defined(NRF52) || defined(NRF52840_XXAA)
+    // an erase takes 85 ms, with the softdevice the wait gives up while fstorage carries on
+    flashStorage.setTimeout(1);
+    const bool erased = flashStorage.erasePage(1, 1);
+    flashStorage.setTimeout(STORAGE_TIMEOUT_MS);
+    if (!erased) {
+        TEST_ASSERT_EQUAL_MESSAGE(FS_ERR_OPERATION_TIMEOUT, flashStorage.getLastError(), "no timeout reported");
+        wait_ms(200);
+    }
+#endif
+
+    // the storage works after a timeout
+    TEST_ASSERT_TRUE_MESSAGE(flashStorage.erasePage(1, 1), "failed to erase after a timeout");
+    TEST_ASSERT_TRUE(flashStorage.writeData(flashStorage.getPageSize() + 3, writeData, sizeof(writeData)));
+    TEST_ASSERT_EQUAL(FS_SUCCESS, flashStorage.getLastError());
+    TEST_ASSERT_TRUE(flashStorage.readData(flashStorage.getPageSize() + 3, readData, sizeof(readData)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(writeData, readData, sizeof(writeData));
+}
+
+void TestStorageVerify() {
+    FLASH_STORAGE_TYPE flashStorage;
+    const uint32_t pageSize = flashStorage.getPageSize();
+    const uint8_t writeData[7] = {0x0F, 0x1E, 0x2D, 0x3C, 0x4B, 0x5A, 0x69};
+    const uint8_t changeData[2] = {0x0F, 0xF0};
+    FlashStorageStats stats;
+
+    TEST_ASSERT_TRUE(flashStorage.erasePage(1, 1));
+    flashStorage.setVerify(true);
+    flashStorage.resetStats();
+    TEST_ASSERT_TRUE_MESSAGE(flashStorage.writeData(pageSize + 1, writeData, sizeof(writeData)),
+                             "failed to write with verify");
+    TEST_ASSERT_TRUE(flashStorage.verifyData(pageSize + 1, writeData, sizeof(writeData)));
+
+    // programming over the data cannot set the cleared bits again, so the second byte does not read back
+    TEST_ASSERT_FALSE_MESSAGE(flashStorage.programData(pageSize + 1, changeData, sizeof(changeData)),
+                              "mismatch not detected");
+    TEST_ASSERT_EQUAL(FS_ERR_INTERNAL, flashStorage.getLastError());
+    TEST_ASSERT_EQUAL_HEX32(flashStorage.getStartAddress() + pageSize + 2, flashStorage.getVerifyFailure());
+#if STORAGE_STATS
+    TEST_ASSERT_TRUE(flashStorage.getStats(stats, true));
+    TEST_ASSERT_EQUAL_UINT32(1, stats.softdevice.verifyFailures + stats.nosd.verifyFailures);
+#else
+    (void) stats;
+#endif
+
+    // a single write is verified without the verify mode, the data may be unaligned
+    flashStorage.setVerify(false);
+    TEST_ASSERT_FALSE(flashStorage.verifyData(pageSize + 1, writeData, sizeof(writeData)));
+    TEST_ASSERT_EQUAL_HEX32(flashStorage.getStartAddress() + pageSize + 2, flashStorage.getVerifyFailure());
+    TEST_ASSERT_TRUE(flashStorage.verifyData(pageSize + 4, writeData + 3, 4));
+    TEST_ASSERT_TRUE(flashStorage.erasePage(1, 1));
+}
+
+void TestStorageChunks() {
+#if defined(NRF52) || defined(NRF52840_XXAA)
+    NRF52FlashStorage flashStorage;
+    const uint32_t pageSize = flashStorage.getPageSize();
+    static uint8_t writeData[2048];
+    FlashStorageStats stats;
+
+    for (uint32_t i = 0; i < sizeof(writeData); i++) writeData[i] = (uint8_t) (i * 7 + 1);
+    TEST_ASSERT_TRUE(flashStorage.erasePage(1, 2));
+
+    // 3.75 ms leave (3750 - 2500) / 41 = 30 words next to the radio event
+    NRF52FlashStorage::setConnectionInterval(3750);
+    TEST_ASSERT_TRUE_MESSAGE(NRF52FlashStorage::getChunkWords() <= 30, "chunk does not fit into the interval");
+    flashStorage.resetStats();
+    TEST_ASSERT_TRUE_MESSAGE(flashStorage.writeData(pageSize + 1, writeData, sizeof(writeData)),
+                             "failed to write in chunks");
+    TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(writeData, flashStorage.map(pageSize + 1, sizeof(writeData)),
+                                         sizeof(writeData), "data read does not match written data");
+    TEST_ASSERT_TRUE(NRF52FlashStorage::getChunkWords() >= STORAGE_SD_CHUNK_MIN_WORDS);
+    TEST_ASSERT_TRUE(NRF52FlashStorage::getChunkWords() <= 30);
+
+#if STORAGE_STATS
+    TEST_ASSERT_TRUE(flashStorage.getStats(stats, true));
+    const FlashStoragePathStats &path = stats.softdevice;
+    printf("%u chunks of %u words, %u us (max %u us), %u failed\r\n",
+           (unsigned int) path.chunks, (unsigned int) NRF52FlashStorage::getChunkWords(),
+           (unsigned int) path.chunkTimeUs, (unsigned int) path.maxChunkUs, (unsigned int) path.chunkFailures);
+    if (path.writes > 0) {
+        TEST_ASSERT_TRUE_MESSAGE(path.chunks >= sizeof(writeData) / (30 * 4), "chunks larger than the interval");
+        TEST_ASSERT_EQUAL_UINT32(0, path.chunkFailures);
+        TEST_ASSERT_TRUE_MESSAGE(path.maxChunkUs > 0 && path.maxChunkUs <= path.chunkTimeUs, "chunk time not measured");
+    } else {
+        // without softdevice the NVMC is programmed directly
+        TEST_ASSERT_EQUAL_UINT32(0, path.chunks);
+    }
+
+    // the pages of an erase are operations of their own
+    TEST_ASSERT_TRUE(flashStorage.erasePage(1, 2));
+    TEST_ASSERT_TRUE(flashStorage.getStats(stats, true));
+    TEST_ASSERT_EQUAL_UINT32(stats.softdevice.erases ? 2 : 0, stats.softdevice.chunks);
+#else
+    (void) stats;
+    TEST_ASSERT_TRUE(flashStorage.erasePage(1, 2));
+#endif
+    TEST_ASSERT_TRUE(flashStorage.isErased(pageSize, 2 * pageSize));
+    NRF52FlashStorage::setConnectionInterval(0);
+#endif
+}
+
 #endif //UBIRCH_MBED_NRF52_STORAGE_BASICFLASHSTORAGETESTS_H
@@ -0,0 +1,266 @@
+/*!
+ * @file
+ * @brief BenchmarkFlashStorageTests.h
+ *
+ * Throughput and latency benchmark of the storage hot paths.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#ifndef UBIRCH_MBED_NRF52_STORAGE_BENCHMARKFLASHSTORAGETESTS_H
+#define UBIRCH_MBED_NRF52_STORAGE_BENCHMARKFLASHSTORAGETESTS_H
+
+#include <stdio.h>
+#include <unity/unity.h>
+
+// the storage class under test, the host build uses the simulated flash
+#ifndef FLASH_STORAGE_TYPE
+#include <NRF52FlashStorage.h>
+#define FLASH_STORAGE_TYPE NRF52FlashStorage
+#endif
+
+// microsecond clock for the benchmarks, the host build uses the projected device time
+#ifndef FLASH_TEST_CLOCK_US
+#define FLASH_TEST_CLOCK_US() us_ticker_read()
+#endif
+
+// name of the measured path in the CSV output (sd, nosd or sim)
+#ifndef STORAGE_BENCHMARK_PATH
+#define STORAGE_BENCHMARK_PATH "nosd"
+#endif
+
+// timed operations per combination of operation, size and offset
+#ifndef STORAGE_BENCHMARK_SAMPLES
+#define STORAGE_BENCHMARK_SAMPLES 32
+#endif
+
+#define STORAGE_BENCHMARK_MAX_SIZE 4096
+
+#if defined(NRF52) || defined(NRF52840_XXAA)
+#include <cmsis.h>
+#endif
+
+// the CSV rows go to this file, stdout (the serial console) if NULL
+static FILE *benchmarkCsv = NULL;
+
+static uint8_t benchmarkBuffer[STORAGE_BENCHMARK_MAX_SIZE];
+static uint32_t benchmarkSamples[STORAGE_BENCHMARK_SAMPLES];
+
+enum BenchmarkOp {
+    BENCHMARK_WRITE = 0,
+    BENCHMARK_READ,
+    BENCHMARK_BLANK_CHECK,
+    BENCHMARK_ERASE
+};
+
+static const char *const benchmarkOpNames[] = {"write", "read", "blank-check", "erase"};
+
+/*
+ * print a CSV row of the samples, the samples are sorted for the percentiles
+ */
+static void benchmarkReport(BenchmarkOp op, uint32_t size, uint32_t offset) {
+    FILE *out = benchmarkCsv != NULL ? benchmarkCsv : stdout;
+    uint32_t total = 0;
+
+    for (uint32_t i = 1; i < STORAGE_BENCHMARK_SAMPLES; i++) {
+        const uint32_t sample = benchmarkSamples[i];
+        uint32_t j = i;
+        while (j > 0 && benchmarkSamples[j - 1] > sample) {
+            benchmarkSamples[j] = benchmarkSamples[j - 1];
+            j--;
+        }
+        benchmarkSamples[j] = sample;
+    }
+    for (uint32_t i = 0; i < STORAGE_BENCHMARK_SAMPLES; i++) total += benchmarkSamples[i];
+
+    const float kbPerSecond = total ? (float) size * STORAGE_BENCHMARK_SAMPLES * 1000000.0f / 1024 / total : 0.0f;
+    fprintf(out, "%s,%s,%u,%u,%u,%u,%.1f,%u,%u,%u\r\n", STORAGE_BENCHMARK_PATH, benchmarkOpNames[op],
+            (unsigned int) size, (unsigned int) offset, (unsigned int) STORAGE_BENCHMARK_SAMPLES,
+            (unsigned int) total, kbPerSecond,
+            (unsigned int) benchmarkSamples[(STORAGE_BENCHMARK_SAMPLES - 1) * 50 / 100],
+            (unsigned int) benchmarkSamples[(STORAGE_BENCHMARK_SAMPLES - 1) * 99 / 100],
+            (unsigned int) benchmarkSamples[STORAGE_BENCHMARK_SAMPLES - 1]);
+}
+
+/*
+ * Measure writes, reads and blank checks of one size at one offset. The samples
+ * use consecutive, word disjoint areas (so no word is programmed twice), the
+ * storage is erased outside of the measurement when it runs full.
+ */
+static void benchmarkTransfers(FLASH_STORAGE_TYPE &flashStorage, uint32_t storageSize,
+                               uint32_t size, uint32_t offset) {
+    const uint32_t numPages = storageSize / flashStorage.getPageSize();
+    const uint32_t stride = (offset + size + 3) & ~3U;
+    const uint32_t perErase = storageSize / stride;
+    uint32_t start;
+
+    for (uint32_t i = 0; i < STORAGE_BENCHMARK_SAMPLES; i++) {
+        if (i % perErase == 0) TEST_ASSERT_TRUE(flashStorage.erasePage(0, (uint8_t) numPages));
+        const uint32_t location = (i % perErase) * stride + offset;
+        start = FLASH_TEST_CLOCK_US();
+        TEST_ASSERT_TRUE_MESSAGE(flashStorage.writeData(location, benchmarkBuffer, size),
+                                 "failed to write to storage");
+        benchmarkSamples[i] = FLASH_TEST_CLOCK_US() - start;
+    }
+    benchmarkReport(BENCHMARK_WRITE, size, offset);
+
+    for (uint32_t i = 0; i < STORAGE_BENCHMARK_SAMPLES; i++) {
+        const uint32_t location = (i % perErase) * stride + offset;
+        start = FLASH_TEST_CLOCK_US();
+        TEST_ASSERT_TRUE_MESSAGE(flashStorage.readData(location, benchmarkBuffer, size),
+                                 "failed to read from storage");
+        benchmarkSamples[i] = FLASH_TEST_CLOCK_US() - start;
+    }
+    benchmarkReport(BENCHMARK_READ, size, offset);
+
+    TEST_ASSERT_TRUE(flashStorage.erasePage(0, (uint8_t) numPages));
+    for (uint32_t i = 0; i < STORAGE_BENCHMARK_SAMPLES; i++) {
+        const uint32_t location = (i % perErase) * stride + offset;
+        start = FLASH_TEST_CLOCK_US();
+        const bool erased = flashStorage.isErased(location, size);
+        benchmarkSamples[i] = FLASH_TEST_CLOCK_US() - start;
+        TEST_ASSERT_TRUE_MESSAGE(erased, "erased area not detected as blank");
+    }
+    benchmarkReport(BENCHMARK_BLANK_CHECK, size, offset);
+}
+
+/*
+ * Throughput and p50/p99 latency of write, read, blank check and erase for
+ * sizes from 1 byte to 4 KB at aligned and unaligned offsets, printed as CSV.
+ */
+void TestBenchmarkSweep() {
+    FLASH_STORAGE_TYPE flashStorage;
+    const uint32_t sizes[] = {1, 4, 16, 64, 256, 1024, STORAGE_BENCHMARK_MAX_SIZE};
+    const uint32_t offsets[] = {0, 1};
+    const uint32_t pageSize = flashStorage.getPageSize();
+    const uint32_t storageSize = flashStorage.getEndAddress() - flashStorage.getStartAddress();
+    const uint32_t numPages = storageSize / pageSize;
+
+    for (uint32_t i = 0; i < sizeof(benchmarkBuffer); i++) benchmarkBuffer[i] = (uint8_t) (i * 7 + 3);
+
+    fprintf(benchmarkCsv != NULL ? benchmarkCsv : stdout,
+            "path,op,size,offset,samples,total_us,kb_per_s,p50_us,p99_us,max_us\r\n");
+    for (uint32_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        for (uint32_t o = 0; o < sizeof(offsets) / sizeof(offsets[0]); o++) {
+            // skip sizes the storage cannot hold
+            if (offsets[o] + sizes[s] > storageSize) continue;
+            benchmarkTransfers(flashStorage, storageSize, sizes[s], offsets[o]);
+        }
+    }
+
+    // erase works on whole pages only
+    for (uint32_t pages = 1; pages <= 2 && pages <= numPages; pages++) {
+        for (uint32_t i = 0; i < STORAGE_BENCHMARK_SAMPLES; i++) {
+            const uint32_t start = FLASH_TEST_CLOCK_US();
+            TEST_ASSERT_TRUE(flashStorage.erasePage(0, (uint8_t) pages));
+            benchmarkSamples[i] = FLASH_TEST_CLOCK_US() - start;
+        }
+        benchmarkReport(BENCHMARK_ERASE, pages * pageSize, 0);
+    }
+}
+
+/*
+ * Cost of the verify mode (setVerify()) in percent of the write time, for
+ * writes from 4 bytes to 4 KB, printed as CSV.
+ */
+void TestBenchmarkVerify() {
+    FLASH_STORAGE_TYPE flashStorage;
+    const uint32_t sizes[] = {4, 16, 64, 256, 1024, STORAGE_BENCHMARK_MAX_SIZE};
+    const uint32_t storageSize = flashStorage.getEndAddress() - flashStorage.getStartAddress();
+    const uint32_t numPages = storageSize / flashStorage.getPageSize();
+    FILE *out = benchmarkCsv != NULL ? benchmarkCsv : stdout;
+    uint32_t totalUs[2];
+
+    for (uint32_t i = 0; i < sizeof(benchmarkBuffer); i++) benchmarkBuffer[i] = (uint8_t) (i * 7 + 3);
+
+    fprintf(out, "path,size,samples,write_us,verified_us,verify_percent\r\n");
+    for (uint32_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        if (sizes[s] > storageSize) continue;
+        const uint32_t perErase = storageSize / sizes[s];
+        for (uint32_t verify = 0; verify < 2; verify++) {
+            flashStorage.setVerify(verify == 1);
+            totalUs[verify] = 0;
+            for (uint32_t i = 0; i < STORAGE_BENCHMARK_SAMPLES; i++) {
+                if (i % perErase == 0) TEST_ASSERT_TRUE(flashStorage.erasePage(0, (uint8_t) numPages));
+                const uint32_t start = FLASH_TEST_CLOCK_US();
+                TEST_ASSERT_TRUE_MESSAGE(flashStorage.writeData((i % perErase) * sizes[s], benchmarkBuffer, sizes[s]),
+                                         "failed to write to storage");
+                totalUs[verify] += FLASH_TEST_CLOCK_US() - start;
+            }
+        }
+        flashStorage.setVerify(false);
+
+        const float percent = totalUs[0] ? 100.0f * ((float) totalUs[1] - (float) totalUs[0]) / totalUs[0] : 0.0f;
+        fprintf(out, "%s,%u,%u,%u,%u,%.2f\r\n", STORAGE_BENCHMARK_PATH, (unsigned int) sizes[s],
+                (unsigned int) STORAGE_BENCHMARK_SAMPLES, (unsigned int) totalUs[0], (unsigned int) totalUs[1],
+                percent);
+        // the compare is a read of the written words, far below the write time
+        TEST_ASSERT_TRUE_MESSAGE(totalUs[1] <= totalUs[0] + totalUs[0] / 10 + STORAGE_BENCHMARK_SAMPLES * 10,
+                                 "verify costs more than 10 % of the write time");
+    }
+    TEST_ASSERT_TRUE(flashStorage.erasePage(0, (uint8_t) numPages));
+}
+
+/*
+ * CPU awake time of the wait strategies per KB written and per page erase. The
+ * DWT cycle counter stops while the CPU sleeps, so it counts the awake time only.
+ */
+void TestBenchmarkWaitStrategies() {
+#if defined(NRF52) || defined(NRF52840_XXAA)
+    const FlashWaitStrategy strategies[] = {FLASH_WAIT_SPIN, FLASH_WAIT_SLEEP, FLASH_WAIT_SEMAPHORE};
+    const char *const names[] = {"spin", "sleep", "semaphore"};
+    NRF52FlashStorage flashStorage;
+    const uint32_t pageSize = flashStorage.getPageSize();
+    const uint32_t cyclesPerUs = SystemCoreClock / 1000000;
+
+    for (uint32_t i = 0; i < 1024; i++) benchmarkBuffer[i] = (uint8_t) (i * 7 + 3);
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    for (uint32_t s = 0; s < sizeof(strategies) / sizeof(strategies[0]); s++) {
+        flashStorage.setWaitStrategy(strategies[s]);
+        TEST_ASSERT_TRUE(flashStorage.erasePage(0, 2));
+
+        // 2 pages written in 1 KB writes
+        uint32_t cycles = DWT->CYCCNT;
+        uint32_t start = FLASH_TEST_CLOCK_US();
+        for (uint32_t location = 0; location < 2 * pageSize; location += 1024) {
+            TEST_ASSERT_TRUE_MESSAGE(flashStorage.writeData(location, benchmarkBuffer, 1024),
+                                     "failed to write to storage");
+        }
+        const uint32_t writeAwakeUs = (DWT->CYCCNT - cycles) / cyclesPerUs;
+        const uint32_t writeUs = FLASH_TEST_CLOCK_US() - start;
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(benchmarkBuffer, flashStorage.map(pageSize, 1024), 1024);
+
+        cycles = DWT->CYCCNT;
+        start = FLASH_TEST_CLOCK_US();
+        TEST_ASSERT_TRUE(flashStorage.erasePage(0, 2));
+        const uint32_t eraseAwakeUs = (DWT->CYCCNT - cycles) / cyclesPerUs;
+        const uint32_t eraseUs = FLASH_TEST_CLOCK_US() - start;
+
+        const uint32_t kb = 2 * pageSize / 1024;
+        printf("wait %s: awake %u us/KB of %u us/KB, awake %u us/erase of %u us/erase\r\n", names[s],
+               (unsigned int) (writeAwakeUs / kb), (unsigned int) (writeUs / kb),
+               (unsigned int) (eraseAwakeUs / 2), (unsigned int) (eraseUs / 2));
+        TEST_ASSERT_TRUE(writeAwakeUs <= writeUs + writeUs / 10 + 100);
+    }
+    flashStorage.setWaitStrategy(STORAGE_WAIT_STRATEGY);
+#endif
+}
+
+#endif //UBIRCH_MBED_NRF52_STORAGE_BENCHMARKFLASHSTORAGETESTS_H
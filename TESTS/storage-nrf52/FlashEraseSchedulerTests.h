@@ -0,0 +1,230 @@
+/*!
+ * @file
+ * @brief FlashEraseSchedulerTests.h
+ *
+ * Background Erase Scheduler Test Functions.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#ifndef UBIRCH_MBED_NRF52_STORAGE_FLASHERASESCHEDULERTESTS_H
+#define UBIRCH_MBED_NRF52_STORAGE_FLASHERASESCHEDULERTESTS_H
+
+#include <stdio.h>
+#include <unity/unity.h>
+#include <FlashEraseScheduler.h>
+
+// the storage class under test, the host build uses the simulated flash
+#ifndef FLASH_STORAGE_TYPE
+#include <NRF52FlashStorage.h>
+#define FLASH_STORAGE_TYPE NRF52FlashStorage
+#endif
+
+// microsecond clock for the benchmarks, the host build uses the projected device time
+#ifndef FLASH_TEST_CLOCK_US
+#define FLASH_TEST_CLOCK_US() us_ticker_read()
+#endif
+
+#define SCHEDULER_TEST_PAGES 3
+
+// the nRF52832 has no partial erase, everywhere else (nRF52840, simulated flash) the erase is sliced
+#if defined(NRF52)
+#define SCHEDULER_TEST_PARTIAL_ERASE 0
+#else
+#define SCHEDULER_TEST_PARTIAL_ERASE 1
+#endif
+
+/*
+ * the idle time of the test, erase in the background until the reserve is ready
+ */
+static void schedulerIdle(FlashEraseScheduler &scheduler) {
+    while (scheduler.poll() || scheduler.isErasing()) {
+        while (scheduler.isErasing()) /* do nothing */;
+    }
+}
+
+void TestSchedulerPreErase() {
+    FLASH_STORAGE_TYPE flashStorage;
+    FlashEraseScheduler scheduler(flashStorage, 0, SCHEDULER_TEST_PAGES, 1);
+    const uint32_t pageSize = flashStorage.getPageSize();
+    const uint8_t record[16] = {0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+                                0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F};
+    uint32_t maxLatency = 0;
+    uint8_t page, previous;
+
+    TEST_ASSERT_TRUE(flashStorage.erasePage(0, SCHEDULER_TEST_PAGES));
+    TEST_ASSERT_TRUE_MESSAGE(scheduler.mount(), "failed to mount scheduler");
+    TEST_ASSERT_EQUAL_UINT32(SCHEDULER_TEST_PAGES, scheduler.getReady());
+
+    // a logger switching pages: the full page is released, the erase runs in the idle time
+    TEST_ASSERT_TRUE(scheduler.take(previous, false));
+    for (int round = 0; round < 3 * SCHEDULER_TEST_PAGES; round++) {
+        const uint32_t start = FLASH_TEST_CLOCK_US();
+        TEST_ASSERT_TRUE_MESSAGE(scheduler.take(page, false), "no erased page ready");
+        TEST_ASSERT_TRUE_MESSAGE(flashStorage.writeData(page * pageSize, record, sizeof(record)),
+                                 "failed to write to the taken page");
+        const uint32_t latency = FLASH_TEST_CLOCK_US() - start;
+        if (latency > maxLatency) maxLatency = latency;
+
+        TEST_ASSERT_TRUE(scheduler.release(previous));
+        TEST_ASSERT_EQUAL_UINT32(FLASH_PAGE_DIRTY, scheduler.getState(previous));
+        previous = page;
+        schedulerIdle(scheduler);
+        TEST_ASSERT_TRUE_MESSAGE(scheduler.getReady() >= 1, "reserve not refilled");
+    }
+    printf("page switch: max %u us, %u background erases, %u stalls\r\n",
+           (unsigned int) maxLatency, (unsigned int) scheduler.getBackgroundErases(),
+           (unsigned int) scheduler.getStalls());
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.getStalls());
+    TEST_ASSERT_TRUE_MESSAGE(scheduler.getBackgroundErases() >= 3 * SCHEDULER_TEST_PAGES - 1, "erases not in the background");
+    // the write after a page switch never includes an erase (85 ms)
+    TEST_ASSERT_TRUE_MESSAGE(maxLatency < 20000, "writer waited for an erase");
+
+    // pages with data (the current page and released pages beyond the reserve) are in use after a mount
+    FlashEraseScheduler mounted(flashStorage, 0, SCHEDULER_TEST_PAGES, SCHEDULER_TEST_PAGES);
+    TEST_ASSERT_TRUE(mounted.mount());
+    TEST_ASSERT_EQUAL_UINT32(FLASH_PAGE_IN_USE, mounted.getState(page));
+    schedulerIdle(mounted);
+    TEST_ASSERT_TRUE_MESSAGE(!flashStorage.isErased(page * pageSize, sizeof(record)), "data erased after mount");
+    for (uint8_t i = 0; i < SCHEDULER_TEST_PAGES; i++) {
+        if (mounted.getState(i) == FLASH_PAGE_IN_USE) TEST_ASSERT_TRUE(mounted.release(i));
+    }
+    TEST_ASSERT_TRUE(!mounted.release(page));
+    schedulerIdle(mounted);
+    TEST_ASSERT_EQUAL_UINT32(SCHEDULER_TEST_PAGES, mounted.getReady());
+}
+
+void TestSchedulerStall() {
+    FLASH_STORAGE_TYPE flashStorage;
+    FlashEraseScheduler scheduler(flashStorage, 0, SCHEDULER_TEST_PAGES, 1);
+    const uint32_t pageSize = flashStorage.getPageSize();
+    const uint8_t data[4] = {0xCA, 0xFE, 0xBA, 0xBE};
+    uint8_t pages[SCHEDULER_TEST_PAGES], page;
+
+    TEST_ASSERT_TRUE(flashStorage.erasePage(0, SCHEDULER_TEST_PAGES));
+    TEST_ASSERT_TRUE(scheduler.mount());
+    for (int i = 0; i < SCHEDULER_TEST_PAGES; i++) {
+        TEST_ASSERT_TRUE(scheduler.take(pages[i], false));
+        TEST_ASSERT_TRUE(flashStorage.writeData(pages[i] * pageSize, data, sizeof(data)));
+    }
+    TEST_ASSERT_TRUE_MESSAGE(!scheduler.take(page, true), "took a page while all are in use");
+    for (int i = 0; i < SCHEDULER_TEST_PAGES; i++) TEST_ASSERT_TRUE(scheduler.release(pages[i]));
+
+    // without idle time the writer has to wait for the erase
+    TEST_ASSERT_TRUE_MESSAGE(!scheduler.take(page, false), "took a dirty page");
+    TEST_ASSERT_TRUE_MESSAGE(scheduler.take(page, true), "failed to take a page");
+    TEST_ASSERT_EQUAL_UINT32(1, scheduler.getStalls());
+    TEST_ASSERT_TRUE_MESSAGE(flashStorage.isErased(page * pageSize, pageSize), "taken page not erased");
+    TEST_ASSERT_EQUAL_UINT32(SCHEDULER_TEST_PAGES - 1, scheduler.getDirty());
+    TEST_ASSERT_TRUE(scheduler.release(page));
+    schedulerIdle(scheduler);
+}
+
+/*
+ * a storage that accepts erases but never completes them, like an fstorage that lost the event
+ */
+class LostEraseStorage : public FLASH_STORAGE_TYPE {
+public:
+    bool erasePageAsync(uint8_t page, uint8_t numPages, FlashStorageCallback callback, void *context) {
+        (void) page;
+        (void) numPages;
+        (void) callback;
+        (void) context;
+        return true;
+    }
+};
+
+void TestSchedulerLostErase() {
+    LostEraseStorage flashStorage;
+    FlashEraseScheduler scheduler(flashStorage, 0, SCHEDULER_TEST_PAGES, 1);
+    uint8_t pages[SCHEDULER_TEST_PAGES], page;
+
+    TEST_ASSERT_TRUE(flashStorage.erasePage(0, SCHEDULER_TEST_PAGES));
+    TEST_ASSERT_TRUE(scheduler.mount());
+    for (int i = 0; i < SCHEDULER_TEST_PAGES; i++) TEST_ASSERT_TRUE(scheduler.take(pages[i], false));
+    TEST_ASSERT_TRUE(scheduler.release(pages[0]));
+
+    // the writer gives up after the timeout of the storage instead of hanging
+    TEST_ASSERT_TRUE(scheduler.poll());
+    TEST_ASSERT_TRUE(scheduler.isErasing());
+    TEST_ASSERT_TRUE_MESSAGE(!scheduler.take(page, true), "took a page that was never erased");
+    TEST_ASSERT_EQUAL_UINT32(FS_ERR_OPERATION_TIMEOUT, flashStorage.getLastError());
+}
+
+void TestSchedulerSlices() {
+    FLASH_STORAGE_TYPE flashStorage;
+    FlashEraseScheduler scheduler(flashStorage, 0, SCHEDULER_TEST_PAGES, 1);
+    const uint32_t pageSize = flashStorage.getPageSize();
+    const uint8_t data[4] = {0x51, 0x1C, 0xED, 0x00};
+    FlashStorageStats stats;
+    uint32_t slices = 0;
+    bool done = false;
+    uint8_t pages[SCHEDULER_TEST_PAGES], page;
+
+    TEST_ASSERT_TRUE(flashStorage.erasePage(0, SCHEDULER_TEST_PAGES));
+    TEST_ASSERT_TRUE(flashStorage.writeData(pageSize + 8, data, sizeof(data)));
+    flashStorage.resetStats();
+    while (!done && slices < 1000) {
+        TEST_ASSERT_TRUE_MESSAGE(flashStorage.eraseSlice(1, done), "erase slice failed");
+        slices++;
+    }
+    TEST_ASSERT_TRUE_MESSAGE(done, "erase in slices did not finish");
+    TEST_ASSERT_TRUE_MESSAGE(flashStorage.isErased(pageSize, pageSize), "page not erased after the last slice");
+
+#if STORAGE_STATS
+    TEST_ASSERT_TRUE(flashStorage.getStats(stats));
+    const FlashStoragePathStats &path = stats.softdevice.eraseSlices ? stats.softdevice : stats.nosd;
+    printf("erase slices: %u, max %u us\r\n", (unsigned int) slices, (unsigned int) path.maxSliceUs);
+    TEST_ASSERT_EQUAL_UINT32(slices, path.eraseSlices);
+    TEST_ASSERT_EQUAL_UINT32(1, path.erases);
+    TEST_ASSERT_TRUE_MESSAGE(path.maxSliceUs > 0, "slice time not measured");
+#if SCHEDULER_TEST_PARTIAL_ERASE
+    TEST_ASSERT_TRUE_MESSAGE(slices > 1, "page erased in one slice");
+    TEST_ASSERT_TRUE_MESSAGE(path.maxSliceUs <= STORAGE_ERASE_SLICE_MS * 1000 + 1000, "slice blocked too long");
+#else
+    TEST_ASSERT_EQUAL_UINT32(1, slices);
+#endif
+#else
+    (void) stats;
+#endif
+
+    // the scheduler erases a released page one slice per call
+    TEST_ASSERT_TRUE(scheduler.mount());
+    for (int i = 0; i < SCHEDULER_TEST_PAGES; i++) {
+        TEST_ASSERT_TRUE(scheduler.take(pages[i], false));
+        TEST_ASSERT_TRUE(flashStorage.writeData(pages[i] * pageSize, data, sizeof(data)));
+    }
+    TEST_ASSERT_TRUE(scheduler.release(pages[0]));
+    uint32_t calls = 0;
+    while (scheduler.pollSlice()) calls++;
+    TEST_ASSERT_EQUAL_UINT32(slices, calls);
+    TEST_ASSERT_EQUAL_UINT32(FLASH_PAGE_ERASED, scheduler.getState(pages[0]));
+    TEST_ASSERT_TRUE(flashStorage.isErased(pages[0] * pageSize, pageSize));
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.getStalls());
+
+    // a writer taking a page during the slices finishes the erase
+    TEST_ASSERT_TRUE(scheduler.take(page, false));
+    TEST_ASSERT_TRUE(scheduler.release(pages[1]));
+    TEST_ASSERT_TRUE(scheduler.pollSlice());
+    TEST_ASSERT_TRUE_MESSAGE(scheduler.take(page, true), "failed to take a page");
+    TEST_ASSERT_EQUAL_UINT32(pages[1], page);
+    TEST_ASSERT_TRUE(flashStorage.isErased(page * pageSize, pageSize));
+    TEST_ASSERT_EQUAL_UINT32(SCHEDULER_TEST_PARTIAL_ERASE, scheduler.getStalls());
+}
+
+#endif //UBIRCH_MBED_NRF52_STORAGE_FLASHERASESCHEDULERTESTS_H
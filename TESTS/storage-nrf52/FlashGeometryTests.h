@@ -0,0 +1,99 @@
+/*!
+ * @file
+ * @brief FlashGeometryTests.h
+ *
+ * Compile-time Geometry and Flash Region Test Functions.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#ifndef UBIRCH_MBED_NRF52_STORAGE_FLASHGEOMETRYTESTS_H
+#define UBIRCH_MBED_NRF52_STORAGE_FLASHGEOMETRYTESTS_H
+
+#include <unity/unity.h>
+#include <FlashGeometry.h>
+
+#if defined(NRF52) || defined(NRF52840_XXAA)
+#include <NRF52FlashRegion.h>
+#endif
+
+void TestGeometry() {
+    typedef FlashGeometry<4, 1024> Geometry;
+    typedef FlashGeometry<1, 2048> LargePages;
+
+    // the constants can size arrays, a geometry like FlashGeometry<0, 1000> does not compile
+    static uint8_t page[Geometry::PAGE_SIZE];
+    TEST_ASSERT_EQUAL_UINT32(4096, sizeof(page));
+    TEST_ASSERT_EQUAL_UINT32(12, Geometry::PAGE_SHIFT);
+    TEST_ASSERT_EQUAL_UINT32(16384, Geometry::SIZE);
+    TEST_ASSERT_EQUAL_UINT32(13, LargePages::PAGE_SHIFT);
+    TEST_ASSERT_EQUAL_UINT32(8191, LargePages::PAGE_MASK);
+
+    TEST_ASSERT_EQUAL_UINT32(2, Geometry::pageIndex(0x2FFF));
+    TEST_ASSERT_EQUAL_UINT32(0xFFF, Geometry::pageOffset(0x2FFF));
+    TEST_ASSERT_EQUAL_UINT32(0x2000, Geometry::pageStart(0x2FFF));
+    TEST_ASSERT_EQUAL_UINT32(1, Geometry::words(5, 3));
+    TEST_ASSERT_EQUAL_UINT32(2, Geometry::words(5, 4));
+
+    // the padding to whole words has to fit as well, without overflow
+    TEST_ASSERT_TRUE(Geometry::contains(0, 16384));
+    TEST_ASSERT_TRUE(Geometry::contains(16383, 1));
+    TEST_ASSERT_TRUE(!Geometry::contains(16383, 2));
+    TEST_ASSERT_TRUE(!Geometry::contains(16384, 0));
+    TEST_ASSERT_TRUE(!Geometry::contains(4, 0xFFFFFFFF));
+}
+
+void TestRegion() {
+#if defined(NRF52) || defined(NRF52840_XXAA)
+    NRF52FlashStorage flashStorage;
+    NRF52FlashRegion<1, PAGE_SIZE_WORDS, 1> region;
+    NRF52FlashRegion<1, 2 * PAGE_SIZE_WORDS, 1> largeRegion;
+    const uint32_t pageSize = flashStorage.getPageSize();
+    const uint8_t data[3] = {0x12, 0x34, 0x56};
+    uint8_t readData[3];
+
+    TEST_ASSERT_EQUAL_UINT32(flashStorage.getStartAddress() + pageSize, region.getStartAddress());
+    TEST_ASSERT_EQUAL_UINT32(pageSize, region.getEndAddress() - region.getStartAddress());
+    TEST_ASSERT_EQUAL_UINT32(2 * pageSize, largeRegion.getPageSize());
+
+    // locations are relative to the region
+    TEST_ASSERT_TRUE(region.erasePage(0, 1));
+    TEST_ASSERT_TRUE_MESSAGE(region.writeData(1, data, sizeof(data)), "failed to write to region");
+    TEST_ASSERT_TRUE(flashStorage.readData(pageSize + 1, readData, sizeof(readData)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(data, readData, sizeof(data));
+    TEST_ASSERT_TRUE(region.readData(1, readData, sizeof(readData)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(data, readData, sizeof(data));
+    TEST_ASSERT_TRUE_MESSAGE(!region.writeData(2, data, 1), "wrote over data");
+
+    // nothing outside of the region
+    TEST_ASSERT_TRUE_MESSAGE(!region.writeData(pageSize - 1, data, 2), "wrote beyond the region");
+    TEST_ASSERT_TRUE_MESSAGE(!region.erasePage(1, 1), "erased beyond the region");
+    TEST_ASSERT_TRUE(region.map(pageSize, 1) == NULL);
+    TEST_ASSERT_EQUAL_UINT32(3, region.findFirstNonBlank(pageSize - 3, 16));
+
+    // the base counts in pages of the region, a large page erases all flash pages it spans
+    TEST_ASSERT_EQUAL_UINT32(flashStorage.getStartAddress() + 2 * pageSize, largeRegion.getStartAddress());
+    TEST_ASSERT_TRUE(flashStorage.erasePage(2, 2));
+    TEST_ASSERT_TRUE(flashStorage.writeData(3 * pageSize + 8, data, 1));
+    TEST_ASSERT_TRUE(largeRegion.erasePage(0, 1));
+    TEST_ASSERT_TRUE(flashStorage.isErased(2 * pageSize, 2 * pageSize));
+    TEST_ASSERT_TRUE_MESSAGE(!region.isErased(1, sizeof(data)), "erased the page before the region");
+#endif
+}
+
+#endif //UBIRCH_MBED_NRF52_STORAGE_FLASHGEOMETRYTESTS_H
@@ -0,0 +1,241 @@
+/*!
+ * @file
+ * @brief FlashKVTests.h
+ *
+ * Flash Key-Value Store Test Functions.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#ifndef UBIRCH_MBED_NRF52_STORAGE_FLASHKVTESTS_H
+#define UBIRCH_MBED_NRF52_STORAGE_FLASHKVTESTS_H
+
+#include <stdio.h>
+#include <string.h>
+#include <unity/unity.h>
+#include <FlashKV.h>
+
+// the storage class under test, the host build uses the simulated flash
+#ifndef FLASH_STORAGE_TYPE
+#include <NRF52FlashStorage.h>
+#define FLASH_STORAGE_TYPE NRF52FlashStorage
+#endif
+
+// microsecond clock for the benchmarks, the host build uses the projected device time
+#ifndef FLASH_TEST_CLOCK_US
+#define FLASH_TEST_CLOCK_US() us_ticker_read()
+#endif
+
+#define KV_TEST_PAGES 3
+
+void TestKVPutGet() {
+    FLASH_STORAGE_TYPE flashStorage;
+    FlashKV kv(flashStorage, 0, KV_TEST_PAGES);
+    const uint8_t deviceKey[32] = {0x9C, 0x1F, 0x2A, 0x4B, 0x6D, 0x7E, 0x8F, 0x90};
+    const uint8_t config[5] = {1, 2, 3, 4, 5};
+    uint8_t readData[32];
+    uint16_t length;
+
+    TEST_ASSERT_TRUE_MESSAGE(kv.format(), "failed to format store");
+    TEST_ASSERT_TRUE_MESSAGE(!kv.get("key", readData, sizeof(readData), length), "found missing key");
+
+    TEST_ASSERT_TRUE_MESSAGE(kv.put("key", deviceKey, sizeof(deviceKey)), "failed to put value");
+    TEST_ASSERT_TRUE_MESSAGE(kv.put("config", config, sizeof(config)), "failed to put value");
+    TEST_ASSERT_TRUE_MESSAGE(kv.put("empty", NULL, 0), "failed to put empty value");
+    TEST_ASSERT_EQUAL_UINT32(3, kv.getCount());
+
+    TEST_ASSERT_TRUE_MESSAGE(kv.get("key", readData, sizeof(readData), length), "failed to get value");
+    TEST_ASSERT_EQUAL_UINT16(sizeof(deviceKey), length);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(deviceKey, readData, sizeof(deviceKey), "value does not match");
+    TEST_ASSERT_TRUE_MESSAGE(kv.get("empty", readData, sizeof(readData), length), "failed to get value");
+    TEST_ASSERT_EQUAL_UINT16(0, length);
+    TEST_ASSERT_TRUE_MESSAGE(!kv.get("config", readData, 4, length), "value did not fit");
+    TEST_ASSERT_EQUAL_UINT16(sizeof(config), length);
+
+    // an update is a single append, no erase
+    const uint32_t live = kv.getLiveBytes();
+    TEST_ASSERT_TRUE_MESSAGE(kv.put("config", config + 1, sizeof(config) - 1), "failed to update value");
+    TEST_ASSERT_EQUAL_UINT32(3, kv.getCount());
+    TEST_ASSERT_EQUAL_UINT32(live - 4, kv.getLiveBytes());
+    TEST_ASSERT_TRUE_MESSAGE(kv.get("config", readData, sizeof(readData), length), "failed to get value");
+    TEST_ASSERT_EQUAL_UINT16(sizeof(config) - 1, length);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(config + 1, readData, length, "value does not match");
+    TEST_ASSERT_EQUAL_UINT32(0, kv.getErases());
+
+    TEST_ASSERT_TRUE_MESSAGE(kv.remove("key"), "failed to remove key");
+    TEST_ASSERT_TRUE_MESSAGE(!kv.remove("key"), "removed missing key");
+    TEST_ASSERT_TRUE_MESSAGE(!kv.get("key", readData, sizeof(readData), length), "found removed key");
+    TEST_ASSERT_EQUAL_UINT32(2, kv.getCount());
+    TEST_ASSERT_TRUE_MESSAGE(kv.get("config", readData, sizeof(readData), length), "failed to get value");
+
+    TEST_ASSERT_TRUE_MESSAGE(!kv.put("", config, sizeof(config)), "put empty key");
+    TEST_ASSERT_TRUE_MESSAGE(!kv.put("a key that is longer than thirty-two characters", config, 1), "put long key");
+}
+
+void TestKVRecovery() {
+    FLASH_STORAGE_TYPE flashStorage;
+    char key[16];
+    uint8_t readData[8];
+    uint16_t length;
+
+    {
+        FlashKV kv(flashStorage, 0, KV_TEST_PAGES);
+        TEST_ASSERT_TRUE_MESSAGE(kv.format(), "failed to format store");
+        for (uint32_t n = 0; n < 40; n++) {
+            snprintf(key, sizeof(key), "key%u", (unsigned int) (n % 10));
+            TEST_ASSERT_TRUE_MESSAGE(kv.put(key, (const uint8_t *) &n, sizeof(n)), "failed to put value");
+        }
+        TEST_ASSERT_TRUE_MESSAGE(kv.remove("key3"), "failed to remove key");
+    }
+
+    FlashKV kv(flashStorage, 0, KV_TEST_PAGES);
+    TEST_ASSERT_TRUE_MESSAGE(kv.mount(), "failed to mount store");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(9, kv.getCount(), "keys not recovered");
+    for (uint32_t n = 30; n < 40; n++) {
+        snprintf(key, sizeof(key), "key%u", (unsigned int) (n % 10));
+        if (n == 33) {
+            TEST_ASSERT_TRUE_MESSAGE(!kv.get(key, readData, sizeof(readData), length), "found removed key");
+            continue;
+        }
+        TEST_ASSERT_TRUE_MESSAGE(kv.get(key, readData, sizeof(readData), length), "failed to get value");
+        TEST_ASSERT_EQUAL_UINT16(sizeof(n), length);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(&n, readData, sizeof(n), "latest value not recovered");
+    }
+}
+
+void TestKVGarbageCollection() {
+    FLASH_STORAGE_TYPE flashStorage;
+    FlashKV kv(flashStorage, 0, KV_TEST_PAGES);
+    char key[16];
+    uint32_t counters[16] = {0};
+    uint8_t config[64];
+    uint8_t readData[64];
+    uint16_t length;
+
+    TEST_ASSERT_TRUE_MESSAGE(kv.format(), "failed to format store");
+    memset(config, 0xC5, sizeof(config));
+    TEST_ASSERT_TRUE_MESSAGE(kv.put("config", config, sizeof(config)), "failed to put value");
+
+    // 1000 counter updates, the configuration is never written again
+    for (uint32_t n = 0; n < 1000; n++) {
+        const uint32_t counter = (n * 7) % 16;
+        counters[counter]++;
+        snprintf(key, sizeof(key), "counter%u", (unsigned int) counter);
+        TEST_ASSERT_TRUE_MESSAGE(kv.put(key, (const uint8_t *) &counters[counter], sizeof(uint32_t)),
+                                 "failed to put value");
+    }
+    printf("1000 updates: %u erases, %u keys, %u live bytes\r\n",
+           (unsigned int) kv.getErases(), (unsigned int) kv.getCount(), (unsigned int) kv.getLiveBytes());
+    TEST_ASSERT_TRUE_MESSAGE(kv.getErases() > 0, "no garbage collected");
+    TEST_ASSERT_TRUE_MESSAGE(kv.getErases() < 20, "too many erases");
+
+    FlashKV recovered(flashStorage, 0, KV_TEST_PAGES);
+    TEST_ASSERT_TRUE_MESSAGE(recovered.mount(), "failed to mount store");
+    TEST_ASSERT_EQUAL_UINT32(17, recovered.getCount());
+    TEST_ASSERT_TRUE_MESSAGE(recovered.get("config", readData, sizeof(readData), length), "config lost");
+    TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(config, readData, sizeof(config), "config does not match");
+    for (uint32_t counter = 0; counter < 16; counter++) {
+        snprintf(key, sizeof(key), "counter%u", (unsigned int) counter);
+        TEST_ASSERT_TRUE_MESSAGE(recovered.get(key, readData, sizeof(readData), length), "counter lost");
+        TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(&counters[counter], readData, sizeof(uint32_t),
+                                             "counter does not match");
+    }
+
+    // the live data is limited to what the garbage collection can move
+    TEST_ASSERT_TRUE_MESSAGE(!kv.put("big", config, FLASHKV_MAX_VALUE_SIZE + 1), "put oversized value");
+}
+
+void TestKVFull() {
+    FLASH_STORAGE_TYPE flashStorage;
+    FlashKV kv(flashStorage, 0, 2);
+    char key[16];
+    uint8_t latest[42];
+    uint8_t value[83];
+    uint8_t readData[83];
+    uint16_t length;
+
+    // 41 keys of 96 bytes, with two pages every rotation moves all of them
+    TEST_ASSERT_TRUE_MESSAGE(kv.format(), "failed to format store");
+    memset(value, 0x3C, sizeof(value));
+    for (uint32_t n = 0; n < 41; n++) {
+        snprintf(key, sizeof(key), "key%02u", (unsigned int) n);
+        value[0] = latest[n] = (uint8_t) n;
+        TEST_ASSERT_TRUE_MESSAGE(kv.put(key, value, sizeof(value)), "failed to put value");
+    }
+
+    // the old version of an updated key still fits next to the new one
+    for (uint32_t n = 0; n < 200; n++) {
+        snprintf(key, sizeof(key), "key%02u", (unsigned int) (n % 41));
+        value[0] = latest[n % 41] = (uint8_t) (n + 41);
+        TEST_ASSERT_TRUE_MESSAGE(kv.put(key, value, sizeof(value)), "failed to update value");
+    }
+    TEST_ASSERT_TRUE_MESSAGE(kv.getErases() <= 200, "too many erases");
+
+    // one more key fills the page, an update would not fit next to the old version
+    value[0] = latest[41] = 0xA5;
+    TEST_ASSERT_TRUE_MESSAGE(kv.put("key41", value, sizeof(value)), "failed to put value");
+    value[0] = 0x5A;
+    TEST_ASSERT_TRUE_MESSAGE(!kv.put("key00", value, sizeof(value)), "updated value without space");
+
+    FlashKV recovered(flashStorage, 0, 2);
+    TEST_ASSERT_TRUE_MESSAGE(recovered.mount(), "failed to mount store");
+    TEST_ASSERT_EQUAL_UINT32(42, recovered.getCount());
+    for (uint32_t n = 0; n < 42; n++) {
+        snprintf(key, sizeof(key), "key%02u", (unsigned int) n);
+        TEST_ASSERT_TRUE_MESSAGE(recovered.get(key, readData, sizeof(readData), length), "value lost");
+        TEST_ASSERT_EQUAL_UINT16(sizeof(value), length);
+        TEST_ASSERT_EQUAL_HEX8(latest[n], readData[0]);
+    }
+}
+
+void TestKVBenchmark() {
+    FLASH_STORAGE_TYPE flashStorage;
+    FlashKV kv(flashStorage, 0, KV_TEST_PAGES);
+    char key[16];
+    uint8_t value[16];
+    uint16_t length;
+
+    TEST_ASSERT_TRUE_MESSAGE(kv.format(), "failed to format store");
+    memset(value, 0x5A, sizeof(value));
+    for (uint32_t n = 0; n < 32; n++) {
+        snprintf(key, sizeof(key), "key%u", (unsigned int) n);
+        TEST_ASSERT_TRUE_MESSAGE(kv.put(key, value, sizeof(value)), "failed to put value");
+    }
+
+    uint32_t start = FLASH_TEST_CLOCK_US();
+    for (uint32_t n = 0; n < 1000; n++) {
+        snprintf(key, sizeof(key), "key%u", (unsigned int) (n % 32));
+        TEST_ASSERT_TRUE_MESSAGE(kv.get(key, value, sizeof(value), length), "failed to get value");
+    }
+    const uint32_t get = FLASH_TEST_CLOCK_US() - start;
+
+    const uint32_t erases = kv.getErases();
+    start = FLASH_TEST_CLOCK_US();
+    for (uint32_t n = 0; n < 1000; n++) {
+        snprintf(key, sizeof(key), "key%u", (unsigned int) (n % 32));
+        value[0] = (uint8_t) n;
+        TEST_ASSERT_TRUE_MESSAGE(kv.put(key, value, sizeof(value)), "failed to put value");
+    }
+    const uint32_t put = FLASH_TEST_CLOCK_US() - start;
+
+    printf("| keys | get [us] | put [us] | erases / 1000 puts |\r\n");
+    printf("| %4u | %8.1f | %8.1f | %18u |\r\n", (unsigned int) kv.getCount(),
+           get / 1000.0f, put / 1000.0f, (unsigned int) (kv.getErases() - erases));
+}
+
+#endif //UBIRCH_MBED_NRF52_STORAGE_FLASHKVTESTS_H
@@ -0,0 +1,247 @@
+/*!
+ * @file
+ * @brief FlashLogTests.h
+ *
+ * Flash Log Test Functions.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#ifndef UBIRCH_MBED_NRF52_STORAGE_FLASHLOGTESTS_H
+#define UBIRCH_MBED_NRF52_STORAGE_FLASHLOGTESTS_H
+
+#include <string.h>
+#include <unity/unity.h>
+#include <FlashLog.h>
+
+// the storage class under test, the host build uses the simulated flash
+#ifndef FLASH_STORAGE_TYPE
+#include <NRF52FlashStorage.h>
+#define FLASH_STORAGE_TYPE NRF52FlashStorage
+#endif
+
+// microsecond clock for the benchmarks, the host build uses the projected device time
+#ifndef FLASH_TEST_CLOCK_US
+#define FLASH_TEST_CLOCK_US() us_ticker_read()
+#endif
+
+#define LOG_TEST_PAGES 3
+
+// fill a record with a pattern, records of at least 4 bytes start with the record number
+static void fillRecord(uint8_t *record, uint16_t length, uint32_t n) {
+    for (uint16_t i = 0; i < length; i++) record[i] = (uint8_t) (n * 31 + i);
+    if (length >= sizeof(n)) memcpy(record, &n, sizeof(n));
+}
+
+void TestLogAppendRead() {
+    FLASH_STORAGE_TYPE flashStorage;
+    FlashLog log(flashStorage, 0, LOG_TEST_PAGES);
+    const uint16_t lengths[] = {1, 3, 4, 17, 64};
+    uint32_t locations[5];
+    uint8_t record[64];
+    uint8_t readData[64];
+    uint16_t length;
+
+    TEST_ASSERT_TRUE_MESSAGE(log.format(), "failed to format log");
+    TEST_ASSERT_TRUE_MESSAGE(!log.append(record, 0), "appended empty record");
+    for (uint32_t n = 0; n < 5; n++) {
+        fillRecord(record, lengths[n], n);
+        TEST_ASSERT_TRUE_MESSAGE(log.append(record, lengths[n], &locations[n]), "failed to append record");
+    }
+
+    FlashLogCursor cursor = log.begin();
+    for (uint32_t n = 0; n < 5; n++) {
+        uint32_t location;
+        fillRecord(record, lengths[n], n);
+        TEST_ASSERT_TRUE_MESSAGE(log.next(cursor, readData, sizeof(readData), length, &location),
+                                 "failed to read record");
+        TEST_ASSERT_EQUAL_UINT16(lengths[n], length);
+        TEST_ASSERT_EQUAL_HEX32(locations[n], location);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(record, readData, length, "record does not match");
+    }
+    TEST_ASSERT_TRUE_MESSAGE(!log.next(cursor, readData, sizeof(readData), length), "read beyond the end");
+    TEST_ASSERT_EQUAL_UINT16(0, length);
+
+    // direct access by location, the buffer has to be large enough
+    TEST_ASSERT_TRUE(log.readRecord(locations[3], readData, sizeof(readData), length));
+    TEST_ASSERT_EQUAL_UINT16(17, length);
+    TEST_ASSERT_TRUE_MESSAGE(!log.readRecord(locations[4], readData, 16, length), "record did not fit");
+    TEST_ASSERT_EQUAL_UINT16(64, length);
+    TEST_ASSERT_TRUE_MESSAGE(!log.readRecord(locations[4] + 4, readData, sizeof(readData), length),
+                             "invalid location read");
+}
+
+void TestLogRecovery() {
+    FLASH_STORAGE_TYPE flashStorage;
+    uint8_t record[40];
+    uint8_t readData[40];
+    uint16_t length;
+    uint32_t tailFree, location;
+
+    {
+        FlashLog log(flashStorage, 0, LOG_TEST_PAGES);
+        TEST_ASSERT_TRUE_MESSAGE(log.format(), "failed to format log");
+        for (uint32_t n = 0; n < 150; n++) {
+            fillRecord(record, sizeof(record), n);
+            TEST_ASSERT_TRUE_MESSAGE(log.append(record, sizeof(record), &location), "failed to append record");
+        }
+        tailFree = log.getTailFree();
+    }
+
+    // a record interrupted by a reset: header written, data missing
+    const uint32_t header = 0xBEEF0000 | sizeof(record);
+    TEST_ASSERT_TRUE(flashStorage.programData(location + 4 + sizeof(record), (const uint8_t *) &header, 4));
+
+    FlashLog log(flashStorage, 0, LOG_TEST_PAGES);
+    TEST_ASSERT_TRUE_MESSAGE(log.mount(), "failed to mount log");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(2, log.getTailSequence() - log.getHeadSequence() + 1, "pages not recovered");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(tailFree - 4 - sizeof(record), log.getTailFree(), "tail not recovered");
+
+    fillRecord(record, sizeof(record), 150);
+    TEST_ASSERT_TRUE_MESSAGE(log.append(record, sizeof(record)), "failed to append record");
+
+    // the interrupted record is skipped
+    FlashLogCursor cursor = log.begin();
+    uint32_t n = 0;
+    while (log.next(cursor, readData, sizeof(readData), length)) {
+        fillRecord(record, sizeof(record), n++);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(record, readData, sizeof(record), "record does not match");
+    }
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(151, n, "records missing");
+}
+
+void TestLogTornHeader() {
+    FLASH_STORAGE_TYPE flashStorage;
+    uint8_t record[40];
+    uint8_t readData[40];
+    uint16_t length;
+
+    // the header of the next page torn by a reset: magic only, magic and sequence number
+    for (uint32_t words = 1; words <= 2; words++) {
+        uint32_t sequence;
+        {
+            FlashLog log(flashStorage, 0, LOG_TEST_PAGES);
+            TEST_ASSERT_TRUE_MESSAGE(log.format(), "failed to format log");
+            for (uint32_t n = 0; n < 60; n++) {
+                fillRecord(record, sizeof(record), n);
+                TEST_ASSERT_TRUE_MESSAGE(log.append(record, sizeof(record)), "failed to append record");
+            }
+            sequence = log.getTailSequence();
+        }
+        const uint32_t header[2] = {FLASHLOG_MAGIC, sequence + 1};
+        TEST_ASSERT_TRUE(flashStorage.programData(flashStorage.getPageSize(), (const uint8_t *) header, words * 4));
+
+        // the torn page is the interrupted rotation, not the tail
+        FlashLog log(flashStorage, 0, LOG_TEST_PAGES);
+        TEST_ASSERT_TRUE_MESSAGE(log.mount(), "failed to mount log");
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(sequence, log.getTailSequence(), "tail not recovered");
+        fillRecord(record, sizeof(record), 60);
+        TEST_ASSERT_TRUE_MESSAGE(log.append(record, sizeof(record)), "failed to append record");
+
+        FlashLogCursor cursor = log.begin();
+        uint32_t n = 0;
+        while (log.next(cursor, readData, sizeof(readData), length)) {
+            fillRecord(record, sizeof(record), n++);
+            TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(record, readData, sizeof(record), "record does not match");
+        }
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(61, n, "records lost");
+    }
+}
+
+static uint32_t logReclaimed;
+
+static bool logReclaimHandler(void *context, uint32_t sequence, uint32_t location) {
+    (void) sequence;
+    (void) location;
+    *(uint32_t *) context += 1;
+    return true;
+}
+
+void TestLogReclaim() {
+    FLASH_STORAGE_TYPE flashStorage;
+    FlashLog log(flashStorage, 0, LOG_TEST_PAGES);
+    uint8_t record[100];
+    uint8_t readData[100];
+    uint16_t length;
+    const uint32_t records = 3 * LOG_TEST_PAGES * flashStorage.getPageSize() / sizeof(record);
+
+    logReclaimed = 0;
+    log.setReclaimHandler(logReclaimHandler, &logReclaimed);
+    TEST_ASSERT_TRUE_MESSAGE(log.format(), "failed to format log");
+    for (uint32_t n = 0; n < records; n++) {
+        fillRecord(record, sizeof(record), n);
+        TEST_ASSERT_TRUE_MESSAGE(log.append(record, sizeof(record)), "failed to append record");
+    }
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(log.getHeadSequence() - 1, logReclaimed, "reclaim handler not called");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(LOG_TEST_PAGES - 1, log.getTailSequence() - log.getHeadSequence() + 1,
+                                     "no erased page ahead");
+
+    // the newest records are still there and in order, up to the last one
+    FlashLogCursor cursor = log.begin();
+    TEST_ASSERT_TRUE(log.next(cursor, readData, sizeof(readData), length));
+    uint32_t n;
+    memcpy(&n, readData, sizeof(n));
+    TEST_ASSERT_TRUE_MESSAGE(n > 0 && n < records, "oldest records not reclaimed");
+    fillRecord(record, sizeof(record), n);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(record, readData, sizeof(record), "record does not match");
+    while (log.next(cursor, readData, sizeof(readData), length)) {
+        fillRecord(record, sizeof(record), ++n);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(record, readData, sizeof(record), "record does not match");
+    }
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(records - 1, n, "newest records missing");
+
+    // and survive a reset
+    FlashLog recovered(flashStorage, 0, LOG_TEST_PAGES);
+    TEST_ASSERT_TRUE_MESSAGE(recovered.mount(), "failed to mount log");
+    TEST_ASSERT_EQUAL_UINT32(log.getHeadSequence(), recovered.getHeadSequence());
+    TEST_ASSERT_EQUAL_UINT32(log.getTailSequence(), recovered.getTailSequence());
+    TEST_ASSERT_EQUAL_UINT32(log.getTailFree(), recovered.getTailFree());
+}
+
+void TestLogBenchmark() {
+    FLASH_STORAGE_TYPE flashStorage;
+    FlashLog log(flashStorage, 0, LOG_TEST_PAGES);
+    const uint16_t lengths[] = {8, 32, 128};
+    uint8_t record[128];
+
+    printf("| record [B] | records | append [us] | records/s | mount [us] |\r\n");
+    for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+        TEST_ASSERT_TRUE_MESSAGE(log.format(), "failed to format log");
+        fillRecord(record, lengths[i], i);
+
+        // fill a whole page, so recovery has to walk all of its records
+        const uint32_t records = (flashStorage.getPageSize() - FLASHLOG_PAGE_HEADER_SIZE) /
+                                 (FLASHLOG_RECORD_HEADER_SIZE + lengths[i]);
+        uint32_t start = FLASH_TEST_CLOCK_US();
+        for (uint32_t n = 0; n < records; n++) {
+            TEST_ASSERT_TRUE_MESSAGE(log.append(record, lengths[i]), "failed to append record");
+        }
+        const uint32_t append = FLASH_TEST_CLOCK_US() - start;
+
+        FlashLog recovered(flashStorage, 0, LOG_TEST_PAGES);
+        start = FLASH_TEST_CLOCK_US();
+        TEST_ASSERT_TRUE_MESSAGE(recovered.mount(), "failed to mount log");
+        const uint32_t mount = FLASH_TEST_CLOCK_US() - start;
+        TEST_ASSERT_EQUAL_UINT32(log.getTailFree(), recovered.getTailFree());
+
+        printf("| %10u | %7u | %11u | %9.0f | %10u |\r\n", lengths[i], (unsigned int) records,
+               (unsigned int) append, append ? records * 1000000.0f / append : 0.0f, (unsigned int) mount);
+    }
+}
+
+#endif //UBIRCH_MBED_NRF52_STORAGE_FLASHLOGTESTS_H
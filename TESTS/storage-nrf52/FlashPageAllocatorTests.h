@@ -0,0 +1,133 @@
+/*!
+ * @file
+ * @brief FlashPageAllocatorTests.h
+ *
+ * Flash Page Allocator Test Functions.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#ifndef UBIRCH_MBED_NRF52_STORAGE_FLASHPAGEALLOCATORTESTS_H
+#define UBIRCH_MBED_NRF52_STORAGE_FLASHPAGEALLOCATORTESTS_H
+
+#include <stdio.h>
+#include <unity/unity.h>
+#include <FlashPageAllocator.h>
+
+// the storage class under test, the host build uses the simulated flash
+#ifndef FLASH_STORAGE_TYPE
+#include <NRF52FlashStorage.h>
+#define FLASH_STORAGE_TYPE NRF52FlashStorage
+#endif
+
+#define ALLOCATOR_TEST_PAGES 3
+
+void TestAllocatorLeastWorn() {
+    FLASH_STORAGE_TYPE flashStorage;
+    FlashPageAllocator allocator(flashStorage, 0, ALLOCATOR_TEST_PAGES);
+    const uint8_t data[4] = {0xDE, 0xAD, 0xBE, 0xEF};
+    uint8_t page, first, second;
+    uint32_t count;
+
+    TEST_ASSERT_TRUE(flashStorage.erasePage(0, ALLOCATOR_TEST_PAGES));
+    TEST_ASSERT_TRUE_MESSAGE(allocator.mount(), "failed to mount allocator");
+    TEST_ASSERT_TRUE(allocator.getEraseCount(1, count));
+    TEST_ASSERT_EQUAL_UINT32(0, count);
+
+    // the page freed again and again gets worn, the other pages are picked in between
+    TEST_ASSERT_TRUE_MESSAGE(allocator.allocateFreshPage(first), "failed to allocate page");
+    TEST_ASSERT_TRUE(allocator.isAllocated(first));
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_TRUE(flashStorage.writeData(allocator.getDataLocation(first), data, sizeof(data)));
+        TEST_ASSERT_TRUE_MESSAGE(allocator.freePage(first), "failed to free page");
+        TEST_ASSERT_TRUE_MESSAGE(!allocator.isAllocated(first), "freed page still allocated");
+        TEST_ASSERT_TRUE_MESSAGE(flashStorage.isErased(allocator.getDataLocation(first),
+                                                       allocator.getDataSize()), "page not erased");
+        TEST_ASSERT_TRUE(allocator.allocateFreshPage(page));
+        TEST_ASSERT_TRUE(allocator.freePage(page));
+    }
+    TEST_ASSERT_TRUE(allocator.getEraseCount(first, count));
+    TEST_ASSERT_TRUE_MESSAGE(count >= 5, "erases not counted");
+
+    // the least worn pages are handed out first, until none is left
+    TEST_ASSERT_TRUE(allocator.allocateFreshPage(first));
+    TEST_ASSERT_TRUE(allocator.allocateFreshPage(second));
+    TEST_ASSERT_TRUE(allocator.allocateFreshPage(page));
+    TEST_ASSERT_TRUE_MESSAGE(!allocator.allocateFreshPage(page), "allocated more pages than available");
+    uint32_t firstCount, secondCount;
+    TEST_ASSERT_TRUE(allocator.getEraseCount(first, firstCount));
+    TEST_ASSERT_TRUE(allocator.getEraseCount(second, secondCount));
+    TEST_ASSERT_TRUE(allocator.getEraseCount(page, count));
+    TEST_ASSERT_TRUE_MESSAGE(firstCount <= secondCount && secondCount <= count, "most worn page allocated first");
+
+    // the counters survive a reset
+    FlashPageAllocator recovered(flashStorage, 0, ALLOCATOR_TEST_PAGES);
+    TEST_ASSERT_TRUE_MESSAGE(recovered.mount(), "failed to mount allocator");
+    TEST_ASSERT_TRUE(recovered.getEraseCount(page, firstCount));
+    TEST_ASSERT_EQUAL_UINT32(count, firstCount);
+    TEST_ASSERT_TRUE(recovered.isAllocated(page));
+}
+
+void TestAllocatorInterruptedErase() {
+    FLASH_STORAGE_TYPE flashStorage;
+    FlashPageAllocator allocator(flashStorage, 0, ALLOCATOR_TEST_PAGES);
+    uint8_t page;
+    uint32_t count, maxCount;
+
+    TEST_ASSERT_TRUE(flashStorage.erasePage(0, ALLOCATOR_TEST_PAGES));
+    TEST_ASSERT_TRUE_MESSAGE(allocator.mount(), "failed to mount allocator");
+    TEST_ASSERT_TRUE(allocator.allocateFreshPage(page));
+    TEST_ASSERT_TRUE(allocator.freePage(page));
+    FlashWearHealth health;
+    TEST_ASSERT_TRUE(allocator.getHealth(health));
+    maxCount = health.maxErases;
+
+    // a reset between erase and header loses the counter, it is estimated with the maximum
+    TEST_ASSERT_TRUE(flashStorage.erasePage(1, 1));
+    TEST_ASSERT_TRUE_MESSAGE(!allocator.getEraseCount(1, count), "header survived erase");
+    TEST_ASSERT_TRUE_MESSAGE(allocator.mount(), "failed to mount allocator");
+    TEST_ASSERT_TRUE(allocator.getEraseCount(1, count));
+    TEST_ASSERT_EQUAL_UINT32(maxCount, count);
+}
+
+void TestAllocatorHealth() {
+    FLASH_STORAGE_TYPE flashStorage;
+    FlashPageAllocator allocator(flashStorage, 0, ALLOCATOR_TEST_PAGES);
+    FlashWearHealth health;
+    uint8_t page;
+
+    TEST_ASSERT_TRUE(flashStorage.erasePage(0, ALLOCATOR_TEST_PAGES));
+    TEST_ASSERT_TRUE_MESSAGE(allocator.mount(), "failed to mount allocator");
+    for (int i = 0; i < 3 * ALLOCATOR_TEST_PAGES + 1; i++) {
+        TEST_ASSERT_TRUE(allocator.allocateFreshPage(page));
+        TEST_ASSERT_TRUE(allocator.freePage(page));
+    }
+
+    TEST_ASSERT_TRUE(allocator.getHealth(health));
+    printf("erases min %u max %u mean %u, remaining %u cycles (%u leveled)\r\n",
+           (unsigned int) health.minErases, (unsigned int) health.maxErases, (unsigned int) health.meanErases,
+           (unsigned int) health.remainingCycles, (unsigned int) health.projectedCycles);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(3, health.minErases, "wear not leveled");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(4, health.maxErases, "wear not leveled");
+    TEST_ASSERT_EQUAL_UINT32(3, health.meanErases);
+    TEST_ASSERT_EQUAL_UINT32(FLASH_ENDURANCE_CYCLES - 4, health.remainingCycles);
+    TEST_ASSERT_EQUAL_UINT32(FLASH_ENDURANCE_CYCLES * ALLOCATOR_TEST_PAGES - (3 * ALLOCATOR_TEST_PAGES + 1),
+                             health.projectedCycles);
+}
+
+#endif //UBIRCH_MBED_NRF52_STORAGE_FLASHPAGEALLOCATORTESTS_H
@@ -0,0 +1,93 @@
+/*!
+ * @file
+ * @brief FlashPartitionTests.h
+ *
+ * Flash Partition Table Test Functions.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#ifndef UBIRCH_MBED_NRF52_STORAGE_FLASHPARTITIONTESTS_H
+#define UBIRCH_MBED_NRF52_STORAGE_FLASHPARTITIONTESTS_H
+
+#include <unity/unity.h>
+#include <NRF52FlashPartitions.h>
+
+/*
+ * the test suite registers two partitions "keys" (1 page) and "telemetry" (2 pages)
+ * and initializes the table before the tests run
+ */
+extern NRF52FlashPartitionTable partitionTable;
+
+void TestPartitionTable() {
+    NRF52FlashStorage *keys = partitionTable.find("keys");
+    NRF52FlashStorage *telemetry = partitionTable.find("telemetry");
+    NRF52FlashStorage library;
+
+    TEST_ASSERT_TRUE_MESSAGE(partitionTable.check(), "partition table invalid");
+    TEST_ASSERT_EQUAL_UINT32(2, partitionTable.getCount());
+    TEST_ASSERT_TRUE_MESSAGE(keys != NULL && telemetry != NULL, "partition not found");
+    TEST_ASSERT_TRUE(partitionTable.find("unknown") == NULL);
+    TEST_ASSERT_TRUE(partitionTable.get(2) == NULL);
+
+    const uint32_t pageSize = library.getPageSize();
+    TEST_ASSERT_EQUAL_UINT32(pageSize, keys->getEndAddress() - keys->getStartAddress());
+    TEST_ASSERT_EQUAL_UINT32(2 * pageSize, telemetry->getEndAddress() - telemetry->getStartAddress());
+    TEST_ASSERT_TRUE_MESSAGE(keys->getStartAddress() >= telemetry->getEndAddress() ||
+                             telemetry->getStartAddress() >= keys->getEndAddress(), "partitions overlap");
+
+    // the same pages under two names are refused
+    const NRF52FlashPartition twice[] = {{"a", keys}, {"b", keys}};
+    NRF52FlashPartitionTable overlapping(twice, 2);
+    TEST_ASSERT_TRUE_MESSAGE(!overlapping.check(), "overlapping partitions accepted");
+    const NRF52FlashPartition sameName[] = {{"a", keys}, {"a", telemetry}};
+    NRF52FlashPartitionTable duplicate(sameName, 2);
+    TEST_ASSERT_TRUE_MESSAGE(!duplicate.check(), "duplicate names accepted");
+}
+
+void TestPartitionsIndependent() {
+    NRF52FlashStorage *keys = partitionTable.find("keys");
+    NRF52FlashStorage *telemetry = partitionTable.find("telemetry");
+    NRF52FlashStorage library;
+    const uint8_t key[4] = {0x4B, 0x45, 0x59, 0x21};
+    const uint8_t record[4] = {0x01, 0x02, 0x03, 0x04};
+    uint8_t readData[4];
+
+    TEST_ASSERT_TRUE(keys->erasePage(0, 1));
+    TEST_ASSERT_TRUE(library.erasePage(0, 1));
+    TEST_ASSERT_TRUE_MESSAGE(keys->writeData(0, key, sizeof(key)), "failed to write key");
+    TEST_ASSERT_TRUE_MESSAGE(library.writeData(0, key, sizeof(key)), "failed to write library storage");
+
+    // the telemetry pages are erased and written without touching the other storages
+    for (int round = 0; round < 3; round++) {
+        TEST_ASSERT_TRUE(telemetry->erasePage(0, 2));
+        TEST_ASSERT_TRUE_MESSAGE(telemetry->isErased(0, telemetry->getEndAddress() - telemetry->getStartAddress()),
+                                 "telemetry not erased");
+        TEST_ASSERT_TRUE_MESSAGE(telemetry->writeData(0, record, sizeof(record)), "failed to write telemetry");
+    }
+    TEST_ASSERT_TRUE_MESSAGE(!telemetry->erasePage(2, 1), "erased beyond the partition");
+
+    TEST_ASSERT_TRUE(keys->readData(0, readData, sizeof(readData)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(key, readData, sizeof(key), "key changed by telemetry");
+    TEST_ASSERT_TRUE(library.readData(0, readData, sizeof(readData)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(key, readData, sizeof(key), "library storage changed by telemetry");
+    TEST_ASSERT_TRUE(telemetry->readData(0, readData, sizeof(readData)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(record, readData, sizeof(record));
+}
+
+#endif //UBIRCH_MBED_NRF52_STORAGE_FLASHPARTITIONTESTS_H
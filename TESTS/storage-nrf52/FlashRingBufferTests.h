@@ -0,0 +1,247 @@
+/*!
+ * @file
+ * @brief FlashRingBufferTests.h
+ *
+ * Ring Buffer Test Functions.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#ifndef UBIRCH_MBED_NRF52_STORAGE_FLASHRINGBUFFERTESTS_H
+#define UBIRCH_MBED_NRF52_STORAGE_FLASHRINGBUFFERTESTS_H
+
+#include <stdio.h>
+#include <string.h>
+#include <unity/unity.h>
+#include <FlashRingBuffer.h>
+
+// the storage class under test, the host build uses the simulated flash
+#ifndef FLASH_STORAGE_TYPE
+#include <NRF52FlashStorage.h>
+#define FLASH_STORAGE_TYPE NRF52FlashStorage
+#endif
+
+// microsecond clock for the benchmarks, the host build uses the projected device time
+#ifndef FLASH_TEST_CLOCK_US
+#define FLASH_TEST_CLOCK_US() us_ticker_read()
+#endif
+
+#define RING_TEST_PAGES 4
+
+// a sensor sample, numbered to check the order
+struct RingTestSample {
+    uint32_t number;
+    uint16_t values[6];
+};
+
+static void fillSample(RingTestSample &sample, uint32_t number) {
+    sample.number = number;
+    for (uint32_t i = 0; i < sizeof(sample.values) / sizeof(sample.values[0]); i++) {
+        sample.values[i] = (uint16_t) (number * 7 + i);
+    }
+}
+
+static void popSample(FlashRingBuffer &ring, uint32_t number) {
+    RingTestSample expected, sample;
+    uint16_t length;
+
+    fillSample(expected, number);
+    TEST_ASSERT_TRUE_MESSAGE(ring.pop((uint8_t *) &sample, sizeof(sample), length), "failed to pop sample");
+    TEST_ASSERT_EQUAL_UINT16(sizeof(sample), length);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE((const uint8_t *) &expected, (const uint8_t *) &sample, sizeof(sample),
+                                         "sample does not match");
+}
+
+void TestRingPushPop() {
+    FLASH_STORAGE_TYPE flashStorage;
+    FlashRingBuffer ring(flashStorage, 0, RING_TEST_PAGES, 16);
+    RingTestSample sample;
+    uint8_t entry[200], readData[200];
+    uint16_t length;
+
+    TEST_ASSERT_TRUE_MESSAGE(ring.format(), "failed to format");
+    TEST_ASSERT_TRUE(ring.isEmpty());
+    TEST_ASSERT_TRUE_MESSAGE(!ring.pop(readData, sizeof(readData), length), "popped from an empty ring");
+    TEST_ASSERT_EQUAL_UINT16(0, length);
+
+    // fixed-size samples and variable-size entries spanning several slots
+    for (uint32_t i = 0; i < sizeof(entry); i++) entry[i] = (uint8_t) (i * 13);
+    fillSample(sample, 1);
+    TEST_ASSERT_TRUE(ring.push((const uint8_t *) &sample, sizeof(sample)));
+    TEST_ASSERT_TRUE_MESSAGE(ring.push(entry, 3), "failed to push small entry");
+    TEST_ASSERT_TRUE_MESSAGE(ring.push(entry, sizeof(entry)), "failed to push large entry");
+    fillSample(sample, 2);
+    TEST_ASSERT_TRUE(ring.push((const uint8_t *) &sample, sizeof(sample)));
+    TEST_ASSERT_TRUE_MESSAGE(!ring.push(entry, 0), "pushed an empty entry");
+    TEST_ASSERT_TRUE(!ring.isEmpty());
+
+    // peek does not consume, a buffer that is too small returns the length
+    TEST_ASSERT_TRUE(ring.peek((uint8_t *) &sample, sizeof(sample), length));
+    TEST_ASSERT_EQUAL_UINT32(1, sample.number);
+    popSample(ring, 1);
+    TEST_ASSERT_TRUE(ring.pop(readData, sizeof(readData), length));
+    TEST_ASSERT_EQUAL_UINT16(3, length);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(entry, readData, 3);
+    TEST_ASSERT_TRUE_MESSAGE(!ring.pop(readData, 100, length), "entry did not fit");
+    TEST_ASSERT_EQUAL_UINT16(sizeof(entry), length);
+    TEST_ASSERT_TRUE(ring.pop(readData, sizeof(readData), length));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(entry, readData, sizeof(entry), "large entry does not match");
+
+    // consume drops the head without reading it
+    TEST_ASSERT_TRUE(ring.consume());
+    TEST_ASSERT_TRUE(ring.isEmpty());
+    TEST_ASSERT_TRUE(!ring.consume());
+}
+
+void TestRingWrap() {
+    FLASH_STORAGE_TYPE flashStorage;
+    FlashRingBuffer ring(flashStorage, 0, RING_TEST_PAGES, sizeof(RingTestSample) + 4);
+    const uint32_t perPage = (flashStorage.getPageSize() - FLASHRING_PAGE_HEADER_SIZE) / (sizeof(RingTestSample) + 4);
+    RingTestSample sample;
+
+    TEST_ASSERT_TRUE_MESSAGE(ring.format(), "failed to format");
+
+    // the consumer keeps up for the first pages, then stops while the producer goes around the ring
+    uint32_t number = 0;
+    for (; number < 2 * perPage; number++) {
+        fillSample(sample, number);
+        TEST_ASSERT_TRUE_MESSAGE(ring.push((const uint8_t *) &sample, sizeof(sample)), "failed to push sample");
+        popSample(ring, number);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, ring.getDroppedPages());
+    const uint32_t stopped = number;
+    for (; number < stopped + (RING_TEST_PAGES + 1) * perPage; number++) {
+        fillSample(sample, number);
+        TEST_ASSERT_TRUE_MESSAGE(ring.push((const uint8_t *) &sample, sizeof(sample)), "failed to push sample");
+    }
+
+    // the oldest pages have been erased with their samples, the ring continues with the oldest page left
+    TEST_ASSERT_EQUAL_UINT32(1, ring.getDroppedPages());
+    TEST_ASSERT_EQUAL_UINT32(2 + RING_TEST_PAGES + 1, ring.getTailSequence());
+    RingTestSample first;
+    uint16_t length;
+    TEST_ASSERT_TRUE(ring.peek((uint8_t *) &first, sizeof(first), length));
+    TEST_ASSERT_EQUAL_UINT32(stopped + ring.getDroppedPages() * perPage, first.number);
+    for (uint32_t n = first.number; n < number; n++) popSample(ring, n);
+    TEST_ASSERT_TRUE(ring.isEmpty());
+}
+
+void TestRingRecovery() {
+    FLASH_STORAGE_TYPE flashStorage;
+    const uint32_t pageSize = flashStorage.getPageSize();
+    const uint32_t slotSize = sizeof(RingTestSample) + 4;
+    const uint32_t perPage = (pageSize - FLASHRING_PAGE_HEADER_SIZE) / slotSize;
+    FlashStorageStats stats;
+    RingTestSample sample;
+    uint32_t pushed = 0, popped = 0;
+
+    {
+        FlashRingBuffer ring(flashStorage, 0, RING_TEST_PAGES, slotSize);
+        TEST_ASSERT_TRUE_MESSAGE(ring.format(), "failed to format");
+
+        // wrap the ring once, the consumer lags a page and a half behind
+        for (; pushed < (RING_TEST_PAGES + 1) * perPage + perPage / 3; pushed++) {
+            fillSample(sample, pushed);
+            TEST_ASSERT_TRUE(ring.push((const uint8_t *) &sample, sizeof(sample)));
+            if (pushed >= perPage + perPage / 2) popSample(ring, popped++);
+        }
+        TEST_ASSERT_EQUAL_UINT32(0, ring.getDroppedPages());
+    }
+
+    // the tail and the head are found with binary searches, not with a scan of the pages
+    FlashRingBuffer ring(flashStorage, 0, RING_TEST_PAGES, slotSize);
+    flashStorage.resetStats();
+    const uint32_t start = FLASH_TEST_CLOCK_US();
+    TEST_ASSERT_TRUE_MESSAGE(ring.mount(), "failed to mount");
+    const uint32_t mountUs = FLASH_TEST_CLOCK_US() - start;
+#if STORAGE_STATS
+    TEST_ASSERT_TRUE(flashStorage.getStats(stats, true));
+    const FlashStoragePathStats &path = stats.softdevice.reads ? stats.softdevice : stats.nosd;
+    printf("recovery: %u reads, %u us\r\n", (unsigned int) path.reads, (unsigned int) mountUs);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, stats.softdevice.erases + stats.nosd.erases, "erased during recovery");
+    // first page, pages, head, slots of the tail, pages and slots of the head entry
+    TEST_ASSERT_TRUE_MESSAGE(path.reads <= 1 + 2 + 2 + 8 + 3 + 8 + 8, "recovery not bounded");
+#else
+    (void) stats;
+    (void) mountUs;
+#endif
+    TEST_ASSERT_EQUAL_UINT32(RING_TEST_PAGES + 2, ring.getTailSequence());
+    for (uint32_t n = popped; n < pushed; n++) popSample(ring, n);
+    TEST_ASSERT_TRUE(ring.isEmpty());
+
+    // an entry torn by a reset is skipped and consumed, the ring continues after it
+    for (uint32_t n = pushed; n < pushed + 2; n++) {
+        fillSample(sample, n);
+        TEST_ASSERT_TRUE(ring.push((const uint8_t *) &sample, sizeof(sample)));
+    }
+    const uint32_t torn = 0;
+    const uint32_t tornLocation = ((RING_TEST_PAGES + 1) % RING_TEST_PAGES) * pageSize + FLASHRING_PAGE_HEADER_SIZE +
+                                  (perPage / 3) * slotSize + 4;
+    TEST_ASSERT_TRUE(flashStorage.programData(tornLocation, (const uint8_t *) &torn, sizeof(torn)));
+    FlashRingBuffer recovered(flashStorage, 0, RING_TEST_PAGES, slotSize);
+    TEST_ASSERT_TRUE(recovered.mount());
+    popSample(recovered, pushed + 1);
+    TEST_ASSERT_TRUE(recovered.isEmpty());
+    FlashRingBuffer again(flashStorage, 0, RING_TEST_PAGES, slotSize);
+    TEST_ASSERT_TRUE(again.mount());
+    TEST_ASSERT_TRUE_MESSAGE(again.isEmpty(), "torn entry not consumed");
+}
+
+void TestRingBenchmark() {
+    FLASH_STORAGE_TYPE flashStorage;
+    const uint16_t lengths[] = {16, 60, 200};
+    uint8_t entry[200], readData[200];
+    uint16_t length;
+
+    printf("| entry [B] | entries | push [us] | pushes/s | pop [us] | pops/s | mount [us] |\r\n");
+    for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+        FlashRingBuffer ring(flashStorage, 0, RING_TEST_PAGES, (uint16_t) (lengths[i] + 4));
+        TEST_ASSERT_TRUE_MESSAGE(ring.format(), "failed to format");
+        for (uint32_t n = 0; n < lengths[i]; n++) entry[n] = (uint8_t) (n + i);
+
+        // fill all but the last page, so recovery has the most pages and slots to search
+        const uint32_t entries = (RING_TEST_PAGES - 1) *
+                                 ((flashStorage.getPageSize() - FLASHRING_PAGE_HEADER_SIZE) / (lengths[i] + 4));
+        uint32_t start = FLASH_TEST_CLOCK_US();
+        for (uint32_t n = 0; n < entries; n++) {
+            TEST_ASSERT_TRUE_MESSAGE(ring.push(entry, lengths[i]), "failed to push entry");
+        }
+        const uint32_t push = FLASH_TEST_CLOCK_US() - start;
+
+        // pop half of the entries, recovery has to find the head in the middle of the ring
+        start = FLASH_TEST_CLOCK_US();
+        for (uint32_t n = 0; n < entries / 2; n++) {
+            TEST_ASSERT_TRUE_MESSAGE(ring.pop(readData, sizeof(readData), length), "failed to pop entry");
+        }
+        const uint32_t pop = FLASH_TEST_CLOCK_US() - start;
+
+        FlashRingBuffer recovered(flashStorage, 0, RING_TEST_PAGES, (uint16_t) (lengths[i] + 4));
+        start = FLASH_TEST_CLOCK_US();
+        TEST_ASSERT_TRUE_MESSAGE(recovered.mount(), "failed to mount");
+        const uint32_t mount = FLASH_TEST_CLOCK_US() - start;
+        uint32_t remaining = 0;
+        while (recovered.pop(readData, sizeof(readData), length)) remaining++;
+        TEST_ASSERT_EQUAL_UINT32(entries - entries / 2, remaining);
+
+        printf("| %9u | %7u | %9u | %8.0f | %8u | %6.0f | %10u |\r\n", lengths[i], (unsigned int) entries,
+               (unsigned int) push, push ? entries * 1000000.0f / push : 0.0f,
+               (unsigned int) pop, pop ? (entries / 2) * 1000000.0f / pop : 0.0f, (unsigned int) mount);
+    }
+}
+
+#endif //UBIRCH_MBED_NRF52_STORAGE_FLASHRINGBUFFERTESTS_H
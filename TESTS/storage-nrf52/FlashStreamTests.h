@@ -0,0 +1,181 @@
+/*!
+ * @file
+ * @brief FlashStreamTests.h
+ *
+ * Flash Stream Writer and Reader Test Functions.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#ifndef UBIRCH_MBED_NRF52_STORAGE_FLASHSTREAMTESTS_H
+#define UBIRCH_MBED_NRF52_STORAGE_FLASHSTREAMTESTS_H
+
+#include <stdio.h>
+#include <unity/unity.h>
+#include <FlashStream.h>
+
+// the storage class under test, the host build uses the simulated flash
+#ifndef FLASH_STORAGE_TYPE
+#include <NRF52FlashStorage.h>
+#define FLASH_STORAGE_TYPE NRF52FlashStorage
+#endif
+
+// microsecond clock for the benchmarks, the host build uses the projected device time
+#ifndef FLASH_TEST_CLOCK_US
+#define FLASH_TEST_CLOCK_US() us_ticker_read()
+#endif
+
+// bytes written per 128 word block in the benchmark, byte writes with writeData()
+// program each word four times and have to stay below the nWRITE limit
+#define STREAM_BENCHMARK_BLOCK_BYTES 128
+#define STREAM_BENCHMARK_BLOCKS 8
+
+static uint8_t streamTestByte(uint32_t n) {
+    return (uint8_t) (n * 13 + 5);
+}
+
+void TestStreamWriteRead() {
+    FLASH_STORAGE_TYPE flashStorage;
+    const uint32_t pageSize = flashStorage.getPageSize();
+    const uint32_t location = pageSize - 9;
+    uint8_t data[24];
+    uint8_t readData[24];
+    uint32_t n = 0;
+
+    TEST_ASSERT_TRUE(flashStorage.erasePage(0, 2));
+    for (uint32_t i = 0; i < sizeof(data); i++) data[i] = streamTestByte(i);
+
+    {
+        FlashStreamWriter writer(flashStorage, location, 64);
+        // single bytes, a partial word flushed in the middle and a block crossing the page boundary
+        TEST_ASSERT_TRUE_MESSAGE(writer.write(data[n++]), "failed to write byte");
+        TEST_ASSERT_TRUE_MESSAGE(writer.write(data[n++]), "failed to write byte");
+        TEST_ASSERT_TRUE_MESSAGE(writer.flush(), "failed to flush");
+        TEST_ASSERT_TRUE_MESSAGE(!flashStorage.isErased(location, 2), "flushed bytes not programmed");
+        TEST_ASSERT_TRUE_MESSAGE(writer.write(data[n++]), "failed to write byte");
+        TEST_ASSERT_TRUE_MESSAGE(!writer.flush(), "flushed a partial word twice");
+        TEST_ASSERT_TRUE_MESSAGE(writer.write(data + n, 13), "failed to write block");
+        n += 13;
+        TEST_ASSERT_EQUAL_UINT32(location + n, writer.getLocation());
+        TEST_ASSERT_EQUAL_UINT32(64 - n, writer.getRemaining());
+    }
+
+    // a new writer continues at the unaligned cursor of the last one
+    {
+        FlashStreamWriter writer(flashStorage, location + n, 64 - n);
+        while (n < sizeof(data)) {
+            TEST_ASSERT_TRUE_MESSAGE(writer.write(data[n++]), "failed to write byte");
+        }
+        TEST_ASSERT_TRUE_MESSAGE(!writer.write(data, 64), "wrote beyond the area");
+    }
+    TEST_ASSERT_TRUE_MESSAGE(flashStorage.readData(location, readData, sizeof(readData)),
+                             "failed to read from storage");
+    TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(data, readData, sizeof(data), "data read does not match written data");
+    TEST_ASSERT_TRUE_MESSAGE(flashStorage.isErased(location + sizeof(data), 64 - sizeof(data)),
+                             "data written beyond the cursor");
+
+    // writing over data is refused
+    FlashStreamWriter overwrite(flashStorage, location + 4, 4);
+    TEST_ASSERT_TRUE_MESSAGE(!overwrite.write(data, 4), "wrote over data");
+
+    // byte, word and block reads in any order
+    FlashStreamReader reader(flashStorage, location, sizeof(data));
+    uint8_t byte;
+    TEST_ASSERT_TRUE_MESSAGE(reader.read(byte), "failed to read byte");
+    TEST_ASSERT_EQUAL_HEX8(data[0], byte);
+    TEST_ASSERT_TRUE_MESSAGE(reader.read(readData, 3), "failed to read bytes");
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(data + 1, readData, 3);
+    TEST_ASSERT_TRUE_MESSAGE(reader.read(readData, 11), "failed to read block");
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(data + 4, readData, 11);
+    for (n = 15; n < sizeof(data); n++) {
+        TEST_ASSERT_TRUE_MESSAGE(reader.read(byte), "failed to read byte");
+        TEST_ASSERT_EQUAL_HEX8(data[n], byte);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, reader.getRemaining());
+    TEST_ASSERT_TRUE_MESSAGE(!reader.read(byte), "read beyond the area");
+}
+
+void TestStreamBenchmark() {
+    FLASH_STORAGE_TYPE flashStorage;
+    const uint32_t recordSizes[] = {1, 7, 16, 64};
+    uint8_t record[64];
+    const uint32_t total = STREAM_BENCHMARK_BLOCK_BYTES * STREAM_BENCHMARK_BLOCKS;
+
+    for (uint32_t i = 0; i < sizeof(record); i++) record[i] = streamTestByte(i);
+
+    printf("| record [B] | writeData [KB/s] | stream write [KB/s] | readData [KB/s] | stream read [KB/s] |\r\n");
+    for (uint32_t r = 0; r < sizeof(recordSizes) / sizeof(recordSizes[0]); r++) {
+        const uint32_t size = recordSizes[r];
+        uint32_t elapsed[4], length;
+
+        // the blocks start unaligned, one per 128 word block of the flash
+        TEST_ASSERT_TRUE(flashStorage.erasePage(0, 1));
+        uint32_t start = FLASH_TEST_CLOCK_US();
+        for (uint32_t block = 0; block < STREAM_BENCHMARK_BLOCKS; block++) {
+            const uint32_t location = block * 512 + 1;
+            for (uint32_t offset = 0; offset < STREAM_BENCHMARK_BLOCK_BYTES; offset += length) {
+                length = STREAM_BENCHMARK_BLOCK_BYTES - offset < size ? STREAM_BENCHMARK_BLOCK_BYTES - offset : size;
+                TEST_ASSERT_TRUE_MESSAGE(flashStorage.writeData(location + offset, record, length),
+                                         "failed to write to storage");
+            }
+        }
+        elapsed[0] = FLASH_TEST_CLOCK_US() - start;
+
+        start = FLASH_TEST_CLOCK_US();
+        for (uint32_t block = 0; block < STREAM_BENCHMARK_BLOCKS; block++) {
+            const uint32_t location = block * 512 + 1;
+            for (uint32_t offset = 0; offset < STREAM_BENCHMARK_BLOCK_BYTES; offset += length) {
+                length = STREAM_BENCHMARK_BLOCK_BYTES - offset < size ? STREAM_BENCHMARK_BLOCK_BYTES - offset : size;
+                TEST_ASSERT_TRUE_MESSAGE(flashStorage.readData(location + offset, record, length),
+                                         "failed to read from storage");
+            }
+        }
+        elapsed[2] = FLASH_TEST_CLOCK_US() - start;
+
+        TEST_ASSERT_TRUE(flashStorage.erasePage(0, 1));
+        start = FLASH_TEST_CLOCK_US();
+        for (uint32_t block = 0; block < STREAM_BENCHMARK_BLOCKS; block++) {
+            FlashStreamWriter writer(flashStorage, block * 512 + 1, STREAM_BENCHMARK_BLOCK_BYTES);
+            for (uint32_t offset = 0; offset < STREAM_BENCHMARK_BLOCK_BYTES; offset += length) {
+                length = STREAM_BENCHMARK_BLOCK_BYTES - offset < size ? STREAM_BENCHMARK_BLOCK_BYTES - offset : size;
+                TEST_ASSERT_TRUE_MESSAGE(writer.write(record, length), "failed to write stream");
+            }
+            TEST_ASSERT_TRUE_MESSAGE(writer.flush(), "failed to flush stream");
+        }
+        elapsed[1] = FLASH_TEST_CLOCK_US() - start;
+
+        start = FLASH_TEST_CLOCK_US();
+        for (uint32_t block = 0; block < STREAM_BENCHMARK_BLOCKS; block++) {
+            FlashStreamReader reader(flashStorage, block * 512 + 1, STREAM_BENCHMARK_BLOCK_BYTES);
+            for (uint32_t offset = 0; offset < STREAM_BENCHMARK_BLOCK_BYTES; offset += length) {
+                length = STREAM_BENCHMARK_BLOCK_BYTES - offset < size ? STREAM_BENCHMARK_BLOCK_BYTES - offset : size;
+                TEST_ASSERT_TRUE_MESSAGE(reader.read(record, length), "failed to read stream");
+            }
+        }
+        elapsed[3] = FLASH_TEST_CLOCK_US() - start;
+
+        float rate[4];
+        for (int i = 0; i < 4; i++) {
+            rate[i] = elapsed[i] ? total * 1000000.0f / 1024 / elapsed[i] : 0.0f;
+        }
+        printf("| %10u | %16.1f | %19.1f | %15.1f | %18.1f |\r\n", (unsigned int) size,
+               rate[0], rate[1], rate[2], rate[3]);
+    }
+}
+
+#endif //UBIRCH_MBED_NRF52_STORAGE_FLASHSTREAMTESTS_H
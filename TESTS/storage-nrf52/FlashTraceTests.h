@@ -0,0 +1,103 @@
+/*!
+ * @file
+ * @brief FlashTraceTests.h
+ *
+ * Flash Operation Trace Test Functions.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#ifndef UBIRCH_MBED_NRF52_STORAGE_FLASHTRACETESTS_H
+#define UBIRCH_MBED_NRF52_STORAGE_FLASHTRACETESTS_H
+
+#include <stdio.h>
+#include <unity/unity.h>
+#include <FlashTrace.h>
+
+// the storage class under test, the host build uses the simulated flash
+#ifndef FLASH_STORAGE_TYPE
+#include <NRF52FlashStorage.h>
+#define FLASH_STORAGE_TYPE NRF52FlashStorage
+#endif
+
+// the trace test is registered only with STORAGE_TRACE=1 (TESTS/settings-trace.json)
+#if STORAGE_TRACE
+/*
+ * find the next event of an operation, starting at index
+ */
+static uint32_t findTraceEvent(const FlashTraceEvent *events, uint32_t count, uint32_t index, FlashTraceOp op) {
+    while (index < count && events[index].op != op) index++;
+    return index;
+}
+
+void TestTraceTimeline() {
+    FLASH_STORAGE_TYPE flashStorage;
+    static FlashTraceEvent events[STORAGE_TRACE_EVENTS];
+    const uint8_t writeData[8] = {0x10, 0x32, 0x54, 0x76, 0x98, 0xBA, 0xDC, 0xFE};
+    uint8_t readData[8];
+    const uint32_t pageSize = flashStorage.getPageSize();
+
+    TEST_ASSERT_TRUE(flashStorage.erasePage(1, 1));
+    FlashTrace::clear();
+    TEST_ASSERT_TRUE(flashStorage.writeData(pageSize + 3, writeData, sizeof(writeData)));
+    TEST_ASSERT_TRUE(flashStorage.readData(pageSize + 3, readData, sizeof(readData)));
+    TEST_ASSERT_TRUE(flashStorage.erasePage(1, 1));
+
+    const uint32_t count = FlashTrace::read(events, STORAGE_TRACE_EVENTS);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(FlashTrace::getCount(), count, "events lost");
+    FlashTrace::dump();
+
+    // the operations appear in order, each begin with its end
+    uint32_t index = findTraceEvent(events, count, 0, FLASH_TRACE_WRITE_BEGIN);
+    TEST_ASSERT_TRUE_MESSAGE(index < count, "write not traced");
+    TEST_ASSERT_EQUAL_UINT32(pageSize + 3, events[index].address);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(writeData), events[index].length);
+    index = findTraceEvent(events, count, index, FLASH_TRACE_WRITE_END);
+    TEST_ASSERT_TRUE_MESSAGE(index < count, "write end not traced");
+    TEST_ASSERT_EQUAL_UINT32(FS_SUCCESS, events[index].result);
+    index = findTraceEvent(events, count, index, FLASH_TRACE_READ);
+    TEST_ASSERT_TRUE_MESSAGE(index < count, "read not traced");
+    TEST_ASSERT_EQUAL_UINT32(pageSize + 3, events[index].address);
+    index = findTraceEvent(events, count, index, FLASH_TRACE_ERASE_BEGIN);
+    TEST_ASSERT_TRUE_MESSAGE(index < count, "erase not traced");
+    TEST_ASSERT_EQUAL_UINT32(pageSize, events[index].address);
+    TEST_ASSERT_EQUAL_UINT32(pageSize, events[index].length);
+    const uint32_t eraseBegin = events[index].timestamp;
+    index = findTraceEvent(events, count, index, FLASH_TRACE_ERASE_END);
+    TEST_ASSERT_TRUE_MESSAGE(index < count, "erase end not traced");
+    TEST_ASSERT_TRUE_MESSAGE(events[index].timestamp > eraseBegin, "erase took no time");
+    for (uint32_t i = 1; i < count; i++) {
+        TEST_ASSERT_TRUE_MESSAGE(events[i].timestamp - events[0].timestamp >=
+                                 events[i - 1].timestamp - events[0].timestamp, "timestamps out of order");
+    }
+
+    // a full ring buffer keeps the newest events
+    FlashTrace::clear();
+    TEST_ASSERT_TRUE(flashStorage.writeData(pageSize, writeData, 1));
+    for (uint32_t i = 0; i < STORAGE_TRACE_EVENTS; i++) {
+        TEST_ASSERT_TRUE(flashStorage.readData(pageSize + i, readData, 1));
+    }
+    TEST_ASSERT_TRUE_MESSAGE(FlashTrace::getCount() > STORAGE_TRACE_EVENTS, "events not counted");
+    TEST_ASSERT_EQUAL_UINT32(STORAGE_TRACE_EVENTS, FlashTrace::read(events, STORAGE_TRACE_EVENTS));
+    TEST_ASSERT_EQUAL_UINT32(FLASH_TRACE_READ, events[0].op);
+    TEST_ASSERT_EQUAL_UINT32(pageSize + STORAGE_TRACE_EVENTS - 1, events[STORAGE_TRACE_EVENTS - 1].address);
+    TEST_ASSERT_TRUE(flashStorage.erasePage(1, 1));
+}
+#endif
+
+#endif //UBIRCH_MBED_NRF52_STORAGE_FLASHTRACETESTS_H
@@ -0,0 +1,251 @@
+/*!
+ * @file
+ * @brief FlashTransactionTests.h
+ *
+ * Transaction Test Functions.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#ifndef UBIRCH_MBED_NRF52_STORAGE_FLASHTRANSACTIONTESTS_H
+#define UBIRCH_MBED_NRF52_STORAGE_FLASHTRANSACTIONTESTS_H
+
+#include <stdio.h>
+#include <string.h>
+#include <unity/unity.h>
+#include <FlashTransaction.h>
+
+// the storage class under test, the host build uses the simulated flash
+#ifndef FLASH_STORAGE_TYPE
+#include <NRF52FlashStorage.h>
+#define FLASH_STORAGE_TYPE NRF52FlashStorage
+#endif
+
+// microsecond clock for the benchmarks, the host build uses the projected device time
+#ifndef FLASH_TEST_CLOCK_US
+#define FLASH_TEST_CLOCK_US() us_ticker_read()
+#endif
+
+#define TXN_TEST_PAGES 3
+
+enum TxnTestRecord {
+    TXN_DEVICE_KEY = 1,
+    TXN_CERTIFICATE,
+    TXN_COUNTER_BASE
+};
+
+// fill the records of a provisioning, every generation with different data
+static uint8_t txnKey[32];
+static uint8_t txnCertificate[300];
+static uint32_t txnCounterBase;
+
+static void fillProvisioning(uint32_t generation) {
+    for (uint32_t i = 0; i < sizeof(txnKey); i++) txnKey[i] = (uint8_t) (generation * 17 + i);
+    for (uint32_t i = 0; i < sizeof(txnCertificate); i++) txnCertificate[i] = (uint8_t) (generation * 29 + i * 3);
+    txnCounterBase = 0x1000 * generation;
+}
+
+static bool stageProvisioning(FlashTransaction &txn) {
+    return txn.stage(TXN_DEVICE_KEY, txnKey, sizeof(txnKey))
+           && txn.stage(TXN_CERTIFICATE, txnCertificate, sizeof(txnCertificate))
+           && txn.stage(TXN_COUNTER_BASE, (const uint8_t *) &txnCounterBase, sizeof(txnCounterBase));
+}
+
+static void checkProvisioning(FlashTransaction &txn, uint32_t generation) {
+    uint8_t readData[300];
+    uint16_t length;
+
+    fillProvisioning(generation);
+    TEST_ASSERT_TRUE_MESSAGE(txn.read(TXN_DEVICE_KEY, readData, sizeof(readData), length), "key missing");
+    TEST_ASSERT_EQUAL_UINT16(sizeof(txnKey), length);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(txnKey, readData, sizeof(txnKey), "key does not match");
+    TEST_ASSERT_TRUE_MESSAGE(txn.read(TXN_CERTIFICATE, readData, sizeof(readData), length), "certificate missing");
+    TEST_ASSERT_EQUAL_UINT16(sizeof(txnCertificate), length);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(txnCertificate, readData, sizeof(txnCertificate),
+                                         "certificate does not match");
+    TEST_ASSERT_TRUE_MESSAGE(txn.read(TXN_COUNTER_BASE, readData, sizeof(readData), length), "counter missing");
+    TEST_ASSERT_EQUAL_UINT16(sizeof(txnCounterBase), length);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE((const uint8_t *) &txnCounterBase, readData, sizeof(txnCounterBase),
+                                         "counter does not match");
+}
+
+void TestTransactionCommit() {
+    FLASH_STORAGE_TYPE flashStorage;
+    FlashTransaction txn(flashStorage, 0, TXN_TEST_PAGES);
+    FlashStorageStats stats;
+    uint8_t readData[300];
+    uint16_t length;
+
+    TEST_ASSERT_TRUE_MESSAGE(txn.format(), "failed to format");
+    TEST_ASSERT_TRUE_MESSAGE(!txn.stage(TXN_DEVICE_KEY, txnKey, sizeof(txnKey)), "staged without a transaction");
+
+    // nothing can be read before the commit
+    fillProvisioning(1);
+    TEST_ASSERT_TRUE(txn.begin());
+    TEST_ASSERT_TRUE_MESSAGE(stageProvisioning(txn), "failed to stage");
+    TEST_ASSERT_TRUE_MESSAGE(!txn.read(TXN_DEVICE_KEY, readData, sizeof(readData), length), "read before commit");
+    TEST_ASSERT_EQUAL_UINT16(0, length);
+
+    // the commit is a single word
+    flashStorage.resetStats();
+    TEST_ASSERT_TRUE_MESSAGE(txn.commit(), "failed to commit");
+#if STORAGE_STATS
+    TEST_ASSERT_TRUE(flashStorage.getStats(stats, true));
+    TEST_ASSERT_EQUAL_UINT32(1, stats.softdevice.wordsProgrammed + stats.nosd.wordsProgrammed);
+#else
+    (void) stats;
+#endif
+    TEST_ASSERT_EQUAL_UINT32(1, txn.getCommitted());
+    checkProvisioning(txn, 1);
+
+    // a later transaction replaces the records it contains, the last version in it counts
+    const uint32_t counter[2] = {0x5000, 0x6000};
+    TEST_ASSERT_TRUE(txn.begin());
+    TEST_ASSERT_TRUE(txn.stage(TXN_COUNTER_BASE, (const uint8_t *) &counter[0], sizeof(counter[0])));
+    TEST_ASSERT_TRUE(txn.stage(TXN_COUNTER_BASE, (const uint8_t *) &counter[1], sizeof(counter[1])));
+    TEST_ASSERT_TRUE(txn.commit());
+    TEST_ASSERT_TRUE(txn.read(TXN_COUNTER_BASE, readData, sizeof(readData), length));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY((const uint8_t *) &counter[1], readData, sizeof(counter[1]));
+    TEST_ASSERT_TRUE(txn.read(TXN_DEVICE_KEY, readData, sizeof(readData), length));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(txnKey, readData, sizeof(txnKey));
+    TEST_ASSERT_TRUE_MESSAGE(!txn.read(TXN_CERTIFICATE, readData, 16, length), "record did not fit");
+    TEST_ASSERT_EQUAL_UINT16(sizeof(txnCertificate), length);
+
+    // an aborted transaction is ignored
+    fillProvisioning(2);
+    TEST_ASSERT_TRUE(txn.begin());
+    TEST_ASSERT_TRUE(stageProvisioning(txn));
+    txn.abort();
+    TEST_ASSERT_TRUE_MESSAGE(!txn.commit(), "committed an aborted transaction");
+    TEST_ASSERT_TRUE(txn.read(TXN_DEVICE_KEY, readData, sizeof(readData), length));
+    fillProvisioning(1);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(txnKey, readData, sizeof(txnKey));
+}
+
+void TestTransactionRecovery() {
+    FLASH_STORAGE_TYPE flashStorage;
+    const uint32_t pageSize = flashStorage.getPageSize();
+    FlashStorageStats stats;
+    uint32_t committed;
+
+    {
+        FlashTransaction txn(flashStorage, 0, TXN_TEST_PAGES);
+        TEST_ASSERT_TRUE_MESSAGE(txn.format(), "failed to format");
+        for (uint32_t generation = 1; generation <= 4; generation++) {
+            fillProvisioning(generation);
+            TEST_ASSERT_TRUE(txn.begin());
+            TEST_ASSERT_TRUE_MESSAGE(stageProvisioning(txn), "failed to stage");
+            TEST_ASSERT_TRUE_MESSAGE(txn.commit(), "failed to commit");
+        }
+
+        // a reset during the provisioning: the records are written, the commit is missing
+        fillProvisioning(5);
+        TEST_ASSERT_TRUE(txn.begin());
+        TEST_ASSERT_TRUE(stageProvisioning(txn));
+        committed = txn.getCommitted();
+    }
+
+    // the uncommitted records are rolled back, without erasing and without a scan of the area
+    FlashTransaction txn(flashStorage, 0, TXN_TEST_PAGES);
+    flashStorage.resetStats();
+    uint32_t start = FLASH_TEST_CLOCK_US();
+    TEST_ASSERT_TRUE_MESSAGE(txn.mount(), "failed to mount");
+    const uint32_t mountUs = FLASH_TEST_CLOCK_US() - start;
+#if STORAGE_STATS
+    TEST_ASSERT_TRUE(flashStorage.getStats(stats, true));
+    const FlashStoragePathStats &path = stats.softdevice.reads ? stats.softdevice : stats.nosd;
+    printf("recovery: %u reads, %u us\r\n", (unsigned int) path.reads, (unsigned int) mountUs);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, stats.softdevice.erases + stats.nosd.erases, "erased during recovery");
+    // magic, binary search of the commit table, last commit and its records, interrupted records and the end
+    TEST_ASSERT_TRUE_MESSAGE(path.reads <= 1 + 11 + 1 + 3 + 4, "recovery not bounded");
+#else
+    (void) stats;
+    (void) mountUs;
+#endif
+    TEST_ASSERT_EQUAL_UINT32(committed, txn.getCommitted());
+    checkProvisioning(txn, 4);
+
+    // a commit word torn by a reset is ignored as well
+    const uint32_t torn = 0xFFF00000;
+    TEST_ASSERT_TRUE(flashStorage.programData((committed + 1) * 4, (const uint8_t *) &torn, sizeof(torn)));
+    FlashTransaction recovered(flashStorage, 0, TXN_TEST_PAGES);
+    TEST_ASSERT_TRUE_MESSAGE(recovered.mount(), "failed to mount");
+    TEST_ASSERT_EQUAL_UINT32(committed + 1, recovered.getCommitted());
+    checkProvisioning(recovered, 4);
+
+    // the next transaction goes after the interrupted records
+    const uint32_t free = recovered.getFree();
+    fillProvisioning(6);
+    TEST_ASSERT_TRUE(recovered.begin());
+    TEST_ASSERT_TRUE_MESSAGE(stageProvisioning(recovered), "failed to stage after recovery");
+    TEST_ASSERT_TRUE_MESSAGE(recovered.commit(), "failed to commit after recovery");
+    TEST_ASSERT_EQUAL_UINT32(free - 3 * FLASHTXN_RECORD_HEADER_SIZE - sizeof(txnKey) - sizeof(txnCertificate)
+                             - sizeof(txnCounterBase), recovered.getFree());
+    FlashTransaction again(flashStorage, 0, TXN_TEST_PAGES);
+    TEST_ASSERT_TRUE(again.mount());
+    checkProvisioning(again, 6);
+    TEST_ASSERT_TRUE(again.getFree() < (TXN_TEST_PAGES - 1) * pageSize);
+}
+
+// commit 4 provisionings and stage a 5th one, starting with its smallest record
+static uint32_t prepareTornCommit(FlashTransaction &txn) {
+    TEST_ASSERT_TRUE_MESSAGE(txn.format(), "failed to format");
+    for (uint32_t generation = 1; generation <= 4; generation++) {
+        fillProvisioning(generation);
+        TEST_ASSERT_TRUE(txn.begin());
+        TEST_ASSERT_TRUE_MESSAGE(stageProvisioning(txn), "failed to stage");
+        TEST_ASSERT_TRUE_MESSAGE(txn.commit(), "failed to commit");
+    }
+    fillProvisioning(5);
+    TEST_ASSERT_TRUE(txn.begin());
+    TEST_ASSERT_TRUE(txn.stage(TXN_COUNTER_BASE, (const uint8_t *) &txnCounterBase, sizeof(txnCounterBase)));
+    TEST_ASSERT_TRUE(txn.stage(TXN_DEVICE_KEY, txnKey, sizeof(txnKey)));
+    TEST_ASSERT_TRUE(txn.stage(TXN_CERTIFICATE, txnCertificate, sizeof(txnCertificate)));
+    return txn.getCommitted() + 1;
+}
+
+void TestTransactionTornCommit() {
+    FLASH_STORAGE_TYPE flashStorage;
+    uint32_t slot, word;
+
+    {
+        FlashTransaction txn(flashStorage, 0, TXN_TEST_PAGES);
+        slot = prepareTornCommit(txn);
+        TEST_ASSERT_TRUE_MESSAGE(txn.commit(), "failed to commit");
+        TEST_ASSERT_TRUE(flashStorage.readData(slot * 4, (uint8_t *) &word, sizeof(word)));
+    }
+
+    // a reset while programming the commit word leaves some of its 0 bits at 1, a torn
+    // start may point to a later record, but the transaction is never committed partly
+    for (uint32_t bit = 0; bit < 32; bit++) {
+        if (word & (1UL << bit)) continue;
+        {
+            FlashTransaction txn(flashStorage, 0, TXN_TEST_PAGES);
+            prepareTornCommit(txn);
+        }
+        const uint32_t torn = word | (1UL << bit);
+        TEST_ASSERT_TRUE(flashStorage.programData(slot * 4, (const uint8_t *) &torn, sizeof(torn)));
+
+        FlashTransaction recovered(flashStorage, 0, TXN_TEST_PAGES);
+        TEST_ASSERT_TRUE_MESSAGE(recovered.mount(), "failed to mount");
+        TEST_ASSERT_EQUAL_UINT32(slot, recovered.getCommitted());
+        checkProvisioning(recovered, 4);
+    }
+}
+
+#endif //UBIRCH_MBED_NRF52_STORAGE_FLASHTRANSACTIONTESTS_H
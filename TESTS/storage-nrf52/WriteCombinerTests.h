@@ -0,0 +1,158 @@
+/*!
+ * @file
+ * @brief WriteCombinerTests.h
+ *
+ * Write Combiner Test Functions.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#ifndef UBIRCH_MBED_NRF52_STORAGE_WRITECOMBINERTESTS_H
+#define UBIRCH_MBED_NRF52_STORAGE_WRITECOMBINERTESTS_H
+
+#include <unity/unity.h>
+#include <FlashWriteCombiner.h>
+
+// the storage class under test, the host build uses the simulated flash
+#ifndef FLASH_STORAGE_TYPE
+#include <NRF52FlashStorage.h>
+#define FLASH_STORAGE_TYPE NRF52FlashStorage
+#endif
+
+static uint32_t combinerTestClock;
+
+static uint32_t combinerClock() {
+    return combinerTestClock;
+}
+
+void TestCombinerReadYourWrites() {
+    FLASH_STORAGE_TYPE flashStorage;
+    FlashWriteCombiner combiner(flashStorage);
+    const uint8_t writeData[16] = {0xA1, 0xB2, 0xC3, 0xD4,
+                                   0xE5, 0xF6, 0x07, 0x18,
+                                   0x29, 0x3A, 0x4B, 0x5C,
+                                   0x6D, 0x7E, 0x8F, 0x90};
+    uint8_t readData[16];
+
+    TEST_ASSERT_TRUE(flashStorage.erasePage(1, 1));
+
+    // three adjacent writes are staged, nothing is stored yet
+    TEST_ASSERT_TRUE_MESSAGE(combiner.writeData(0x1001, writeData, 5), "failed to write to storage");
+    TEST_ASSERT_TRUE_MESSAGE(combiner.writeData(0x1006, writeData + 5, 7), "failed to write to storage");
+    TEST_ASSERT_TRUE_MESSAGE(combiner.writeData(0x100D, writeData + 12, 4), "failed to write to storage");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, combiner.getStores(), "data stored before flush");
+    TEST_ASSERT_TRUE_MESSAGE(flashStorage.isErased(0x1000, 0x20), "data stored before flush");
+
+    // reads and blank checks see the staged data
+    TEST_ASSERT_TRUE_MESSAGE(combiner.readData(0x1001, readData, sizeof(readData)), "failed to read from storage");
+    TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(writeData, readData, sizeof(writeData),
+                                         "data read does not match written data");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(1, combiner.findFirstNonBlank(0x1000, 0x20), "staged data is blank");
+    TEST_ASSERT_TRUE_MESSAGE(!combiner.writeData(0x1008, writeData, 1), "write over staged data");
+
+    // a write to another location stores the staged data with a single write
+    TEST_ASSERT_TRUE_MESSAGE(combiner.writeData(0x1080, writeData, 1), "failed to write to storage");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(1, combiner.getStores(), "staged data not stored");
+    TEST_ASSERT_TRUE_MESSAGE(flashStorage.readData(0x1001, readData, sizeof(readData)), "failed to read from storage");
+    TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(writeData, readData, sizeof(writeData),
+                                         "data read does not match written data");
+
+    TEST_ASSERT_TRUE_MESSAGE(combiner.flush(), "failed to flush");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(2, combiner.getStores(), "staged data not stored");
+    TEST_ASSERT_TRUE_MESSAGE(!flashStorage.isErased(0x1080, 1), "staged data not stored");
+}
+
+void TestCombinerTimeout() {
+    FLASH_STORAGE_TYPE flashStorage;
+    FlashWriteCombiner combiner(flashStorage, combinerClock, 100);
+    const uint8_t writeData[4] = {0x01, 0x02, 0x03, 0x04};
+
+    TEST_ASSERT_TRUE(flashStorage.erasePage(1, 1));
+
+    combinerTestClock = 1000;
+    TEST_ASSERT_TRUE_MESSAGE(combiner.writeData(0x1200, writeData, sizeof(writeData)), "failed to write to storage");
+    combinerTestClock = 1099;
+    TEST_ASSERT_TRUE(combiner.poll());
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, combiner.getStores(), "data stored before timeout");
+    combinerTestClock = 1100;
+    TEST_ASSERT_TRUE(combiner.poll());
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(1, combiner.getStores(), "data not stored after timeout");
+    TEST_ASSERT_TRUE_MESSAGE(!flashStorage.isErased(0x1200, sizeof(writeData)), "data not stored after timeout");
+}
+
+void TestCombinerGapsAndRetry() {
+    FLASH_STORAGE_TYPE flashStorage;
+    FlashWriteCombiner combiner(flashStorage);
+    const uint8_t writeData[8] = {0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88};
+    uint8_t readData[12];
+
+    TEST_ASSERT_TRUE(flashStorage.erasePage(1, 1));
+
+    // the blank gap between two combined writes can still be written, like on the storage
+    TEST_ASSERT_TRUE(combiner.writeData(0x1100, writeData, 4));
+    TEST_ASSERT_TRUE(combiner.writeData(0x1108, writeData + 4, 4));
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(4, combiner.findFirstNonBlank(0x1104, 8), "gap is not blank");
+    TEST_ASSERT_TRUE_MESSAGE(combiner.writeData(0x1104, writeData, 4), "failed to write into the gap");
+    TEST_ASSERT_TRUE_MESSAGE(!combiner.writeData(0x1106, writeData, 1), "write over staged data");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, combiner.getStores(), "data stored before flush");
+
+    // a failed store keeps the staged data, a later flush stores it
+    const uint32_t conflict = 0;
+    TEST_ASSERT_TRUE(flashStorage.programData(0x1104, (const uint8_t *) &conflict, sizeof(conflict)));
+    TEST_ASSERT_TRUE_MESSAGE(!combiner.flush(), "stored over data");
+    TEST_ASSERT_TRUE(combiner.readData(0x1100, readData, sizeof(readData)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(writeData, readData + 4, 4, "staged data lost");
+    TEST_ASSERT_TRUE(flashStorage.erasePage(1, 1));
+    TEST_ASSERT_TRUE_MESSAGE(combiner.flush(), "failed to retry the flush");
+    TEST_ASSERT_TRUE(flashStorage.readData(0x1100, readData, sizeof(readData)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(writeData, readData, 4, "data read does not match written data");
+    TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(writeData, readData + 4, 4, "data read does not match written data");
+    TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(writeData + 4, readData + 8, 4, "data read does not match written data");
+}
+
+void TestCombinerStoresPerKB() {
+    FLASH_STORAGE_TYPE flashStorage;
+    FlashWriteCombiner combiner(flashStorage);
+    uint8_t record[32];
+    uint8_t readData[32];
+    uint32_t location = 0x1000;
+
+    TEST_ASSERT_TRUE(flashStorage.erasePage(1, 1));
+
+    // records of 4 to 32 bytes to consecutive locations, like telemetry
+    for (uint16_t n = 0; location + 32 <= 0x1400; n++) {
+        uint16_t length = (uint16_t) (4 + (n * 7) % 29);
+        memset(record, (int) (n & 0x7F), length);
+        TEST_ASSERT_TRUE_MESSAGE(combiner.writeData(location, record, length), "failed to write to storage");
+        location += length;
+    }
+    TEST_ASSERT_TRUE(combiner.flush());
+
+    printf("%u writes, %u bytes, %u stores (%.1f writes/KB, %.1f stores/KB)\r\n",
+           (unsigned int) combiner.getWrites(), (unsigned int) combiner.getBytesWritten(),
+           (unsigned int) combiner.getStores(),
+           combiner.getWrites() * 1024.0f / combiner.getBytesWritten(),
+           combiner.getStores() * 1024.0f / combiner.getBytesWritten());
+    TEST_ASSERT_TRUE_MESSAGE(combiner.getStores() * 4 < combiner.getWrites(), "writes not combined");
+
+    TEST_ASSERT_TRUE(flashStorage.readData(location - 32, readData, sizeof(readData)));
+    TEST_ASSERT_TRUE(combiner.readData(location - 32, record, sizeof(record)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(record, readData, sizeof(record), "stored data does not match");
+}
+
+#endif //UBIRCH_MBED_NRF52_STORAGE_WRITECOMBINERTESTS_H
@@ -53,10 +53,14 @@ Case cases[] = {
              TestStorageWriteOverPageBoarder, greentea_failure_handler),
         Case("Storage [noSD] test storage write big buffer",
              TestStorageWriteBigBuffer, greentea_failure_handler),
+        Case("Storage [noSD] test storage write large transfer",
+             TestStorageWriteLargeTransfer, greentea_failure_handler),
         Case("Storage [noSD] test storage erase pages",
              TestStorageErasePages, greentea_failure_handler),
         Case("Storage [noSD] test storage write over the upper bound",
              TestStorageWriteOverUpperBound, greentea_failure_handler),
+        Case("Storage [noSD] test storage write and erase async",
+             TestStorageWriteEraseAsync, greentea_failure_handler),
 
 };
 
@@ -53,6 +53,13 @@ Case cases[] = {
         Case("Storage [noSD] test storage write buffer", TestStorageWriteBuffer, greentea_failure_handler),
         Case("Storage [noSD] test storage write existing fails", TestStorageWriteFailOnUsedFlash, greentea_failure_handler),
         Case("Storage [noSD] test storage write non-aligned", TestStorageWriteNonAligned, greentea_failure_handler),
+        Case("Storage [noSD] test storage blank check", TestStorageBlankCheck, greentea_failure_handler),
+        Case("Storage [noSD] test storage map", TestStorageMap, greentea_failure_handler),
+        Case("Storage [noSD] test storage update data", TestStorageUpdateData, greentea_failure_handler),
+        Case("Storage [noSD] test storage statistics", TestStorageStats, greentea_failure_handler),
+        Case("Storage [noSD] test storage timeout", TestStorageTimeout, greentea_failure_handler),
+        Case("Storage [noSD] test storage verify", TestStorageVerify, greentea_failure_handler),
+        Case("Storage [noSD] test storage chunks", TestStorageChunks, greentea_failure_handler),
 };
 
 int main() {
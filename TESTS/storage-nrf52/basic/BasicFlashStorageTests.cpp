@@ -53,6 +53,13 @@ Case("Storage [SD] test storage write 1.5 words", TestStorageWriteWordAndHalfWor
 Case("Storage [SD] test storage write buffer", TestStorageWriteBuffer, greentea_failure_handler),
 Case("Storage [SD] test storage write existing fails", TestStorageWriteFailOnUsedFlash, greentea_failure_handler),
 Case("Storage [SD] test storage write non-aligned", TestStorageWriteNonAligned, greentea_failure_handler),
+Case("Storage [SD] test storage blank check", TestStorageBlankCheck, greentea_failure_handler),
+Case("Storage [SD] test storage map", TestStorageMap, greentea_failure_handler),
+Case("Storage [SD] test storage update data", TestStorageUpdateData, greentea_failure_handler),
+Case("Storage [SD] test storage statistics", TestStorageStats, greentea_failure_handler),
+Case("Storage [SD] test storage timeout", TestStorageTimeout, greentea_failure_handler),
+Case("Storage [SD] test storage verify", TestStorageVerify, greentea_failure_handler),
+Case("Storage [SD] test storage chunks", TestStorageChunks, greentea_failure_handler),
 };
 
 
@@ -0,0 +1,86 @@
+/*
+ * @file BenchmarkFlashStorageSD.cpp
+ *
+ * Benchmarks for the flash storage hot paths (softdevice enabled).
+ *
+ * @date 2026-10-15
+ *
+ * Copyright 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include "mbed.h"
+#include <BLE.h>
+#include <nrf52_bitfields.h>
+#include <NRF52FlashStorage.h>
+
+#include "utest/utest.h"
+#include "unity/unity.h"
+#include "greentea-client/test_env.h"
+
+#define STORAGE_BENCHMARK_PATH "sd"
+#include "../BenchmarkFlashStorageTests.h"
+
+using namespace utest::v1;
+
+utest::v1::status_t greentea_failure_handler(const Case *const source, const failure_t reason) { // NOLINT
+    greentea_case_failure_abort_handler(source, reason);
+    return STATUS_CONTINUE;
+}
+
+Case cases[] = {
+        Case("Storage [benchmark SD] sweep", TestBenchmarkSweep, greentea_failure_handler),
+        Case("Storage [benchmark SD] verify", TestBenchmarkVerify, greentea_failure_handler),
+        Case("Storage [benchmark SD] wait strategies", TestBenchmarkWaitStrategies, greentea_failure_handler),
+};
+
+utest::v1::status_t greentea_test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(150, "default_auto");
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+void startTests(BLE::InitializationCompleteCallbackContext *params) {
+    (void) params;
+
+    NRF52FlashStorage flashStorage;
+    flashStorage.init();
+
+    Specification specification(greentea_test_setup, cases, greentea_test_teardown_handler);
+    Harness::run(specification);
+}
+
+static Thread bleEventThread(osPriorityNormal, 24000);
+static EventQueue bleEventQueue(/* event count */ 16 * EVENTS_EVENT_SIZE);
+
+void scheduleBleEventsProcessing(BLE::OnEventsToProcessCallbackContext *context) {
+    bleEventQueue.call(Callback<void()>(&context->ble, &BLE::processEvents));
+}
+
+int main() {
+    // set the storage address (exclude bootloader area)
+    NRF_NVMC->CONFIG = NVMC_CONFIG_WEN_Wen << NVMC_CONFIG_WEN_Pos;
+    while (NRF_NVMC->READY == NVMC_READY_READY_Busy) {}
+    NRF_UICR->NRFFW[0] = 0x7A000;
+    NRF_NVMC->CONFIG = NVMC_CONFIG_WEN_Ren << NVMC_CONFIG_WEN_Pos;
+    while (NRF_NVMC->READY == NVMC_READY_READY_Busy) {}
+
+    // configure BLE to ensure events are handled, the benchmark starts when the softdevice is up
+    bleEventThread.start(callback(&bleEventQueue, &EventQueue::dispatch_forever));
+
+    BLE &ble = BLE::Instance();
+    ble.onEventsToProcess(scheduleBleEventsProcessing);
+    ble.init(startTests);
+}
@@ -0,0 +1,167 @@
+/*
+ * @file BenchmarkFlashStorage.cpp
+ *
+ * Benchmarks for the flash storage hot paths (no softdevice).
+ *
+ * @date 2026-10-15
+ *
+ * Copyright 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include "mbed.h"
+#include <nrf52_bitfields.h>
+#include <NRF52FlashStorage.h>
+
+#include "utest/utest.h"
+#include "unity/unity.h"
+#include "greentea-client/test_env.h"
+
+#include "../BenchmarkFlashStorageTests.h"
+
+#ifndef NUM_PAGES
+#define NUM_PAGES   1
+#endif
+
+#define BENCHMARK_ROUNDS 20
+
+using namespace utest::v1;
+
+/*
+ * The blank check as it was done before, one readData() call per byte.
+ */
+static bool blankCheckPerByte(NRF52FlashStorage &flashStorage, uint32_t location, uint16_t length) {
+    unsigned char buffer8[1];
+    for (int index = 0; index < length; index++) {
+        flashStorage.readData(location + index, buffer8, sizeof(uint8_t));
+        if (buffer8[0] != 0xFF) return false;
+    }
+    return true;
+}
+
+unsigned char writeBuffer[4096];
+
+void TestBenchmarkBlankCheck() {
+    NRF52FlashStorage flashStorage;
+    const uint16_t sizes[] = {1, 16, 256, 4096};
+    uint32_t location = 0;
+    Timer timer;
+
+    TEST_ASSERT_TRUE(flashStorage.erasePage(0, NUM_PAGES));
+    memset(writeBuffer, 0xA5, sizeof(writeBuffer));
+
+    printf("| size [B] | per byte [us] | word-wise [us] | speed-up | write [us] |\r\n");
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        const uint16_t size = sizes[i];
+        bool perByteBlank = true, wordWiseBlank = true;
+
+        timer.reset();
+        timer.start();
+        for (int round = 0; round < BENCHMARK_ROUNDS; round++) {
+            perByteBlank &= blankCheckPerByte(flashStorage, location, size);
+        }
+        timer.stop();
+        const int perByte = timer.read_us();
+
+        timer.reset();
+        timer.start();
+        for (int round = 0; round < BENCHMARK_ROUNDS; round++) {
+            wordWiseBlank &= flashStorage.isErased(location, size);
+        }
+        timer.stop();
+        const int wordWise = timer.read_us();
+
+        timer.reset();
+        timer.start();
+        TEST_ASSERT_TRUE_MESSAGE(flashStorage.writeData(location, writeBuffer, size), "failed to write to storage");
+        timer.stop();
+        const int write = timer.read_us();
+
+        TEST_ASSERT_TRUE_MESSAGE(perByteBlank && wordWiseBlank, "erased area not detected as blank");
+        TEST_ASSERT_TRUE_MESSAGE(!flashStorage.isErased(location, size), "written area detected as blank");
+
+        printf("| %8u | %13.2f | %14.2f | %7.1fx | %10d |\r\n", size,
+               (float) perByte / BENCHMARK_ROUNDS, (float) wordWise / BENCHMARK_ROUNDS,
+               wordWise ? (float) perByte / wordWise : 0.0f, write);
+        location += size;
+    }
+}
+
+/*
+ * Write a page in chunks of 128 bytes (the TestStorageWritePage workload) and return the time in µs.
+ */
+static int writePage(NRF52FlashStorage &flashStorage) {
+    Timer timer;
+
+    TEST_ASSERT_TRUE(flashStorage.erasePage(0, 1));
+    timer.start();
+    for (size_t i = 0; i < sizeof(writeBuffer) / 128; i++) {
+        TEST_ASSERT_TRUE_MESSAGE(flashStorage.writeData(128 * i, writeBuffer + 128 * i, 128),
+                                 "failed to write to storage");
+    }
+    timer.stop();
+    return timer.read_us();
+}
+
+void TestBenchmarkWritePageBurst() {
+    NRF52FlashStorage flashStorage;
+    const uint32_t bursts[] = {1, 8, STORAGE_BURST_WORDS, 128};
+
+    for (size_t i = 0; i < sizeof(writeBuffer); i++) writeBuffer[i] = static_cast<uint8_t>(random());
+
+    printf("| burst [words] | page write [us] | throughput [KB/s] |\r\n");
+    for (size_t i = 0; i < sizeof(bursts) / sizeof(bursts[0]); i++) {
+        NRF52FlashStorage::setStoreBurst(bursts[i]);
+        const int time = writePage(flashStorage);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(writeBuffer, flashStorage.map(0, sizeof(writeBuffer)), sizeof(writeBuffer));
+        printf("| %13u | %15d | %17.2f |\r\n", (unsigned int) bursts[i], time,
+               time ? sizeof(writeBuffer) * 1000000.0f / 1024 / time : 0.0f);
+    }
+    NRF52FlashStorage::setStoreBurst(STORAGE_BURST_WORDS);
+}
+
+utest::v1::status_t greentea_failure_handler(const Case *const source, const failure_t reason) { // NOLINT
+    greentea_case_failure_abort_handler(source, reason);
+    return STATUS_CONTINUE;
+}
+
+Case cases[] = {
+        Case("Storage [benchmark] blank check", TestBenchmarkBlankCheck, greentea_failure_handler),
+        Case("Storage [benchmark] write page burst", TestBenchmarkWritePageBurst, greentea_failure_handler),
+        Case("Storage [benchmark] sweep", TestBenchmarkSweep, greentea_failure_handler),
+        Case("Storage [benchmark] verify", TestBenchmarkVerify, greentea_failure_handler),
+        Case("Storage [benchmark] wait strategies", TestBenchmarkWaitStrategies, greentea_failure_handler),
+};
+
+utest::v1::status_t greentea_test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(150, "default_auto");
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+int main() {
+    // set the storage address (exclude bootloader area)
+    NRF_NVMC->CONFIG = NVMC_CONFIG_WEN_Wen << NVMC_CONFIG_WEN_Pos;
+    while (NRF_NVMC->READY == NVMC_READY_READY_Busy) {}
+    NRF_UICR->NRFFW[0] = 0x7A000;
+    NRF_NVMC->CONFIG = NVMC_CONFIG_WEN_Ren << NVMC_CONFIG_WEN_Pos;
+    while (NRF_NVMC->READY == NVMC_READY_READY_Busy) {}
+
+    NRF52FlashStorage flashStorage;
+    flashStorage.init();
+
+    Specification specification(greentea_test_setup, cases, greentea_test_teardown_handler);
+    Harness::run(specification);
+}
@@ -0,0 +1,112 @@
+/*
+ * @file LayerFlashStorageTests.cpp
+ *
+ * Test the layers on top of the flash storage (no softdevice).
+ *
+ * @date 2026-10-15
+ *
+ * Copyright 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include "mbed.h"
+#include <nrf52_bitfields.h>
+#include <NRF52FlashStorage.h>
+
+#include "utest/utest.h"
+#include "unity/unity.h"
+#include "greentea-client/test_env.h"
+
+#include "../WriteCombinerTests.h"
+#include "../FlashLogTests.h"
+#include "../FlashKVTests.h"
+#include "../FlashPageAllocatorTests.h"
+#include "../FlashStreamTests.h"
+#include "../FlashTraceTests.h"
+#include "../FlashGeometryTests.h"
+#include "../FlashEraseSchedulerTests.h"
+#include "../FlashTransactionTests.h"
+#include "../FlashRingBufferTests.h"
+
+#ifndef NUM_PAGES
+#define NUM_PAGES   1
+#endif
+
+using namespace utest::v1;
+
+utest::v1::status_t greentea_failure_handler(const Case *const source, const failure_t reason) { // NOLINT
+    greentea_case_failure_abort_handler(source, reason);
+    return STATUS_CONTINUE;
+}
+
+Case cases[] = {
+        Case("Storage [layers] write combiner read your writes", TestCombinerReadYourWrites, greentea_failure_handler),
+        Case("Storage [layers] write combiner timeout", TestCombinerTimeout, greentea_failure_handler),
+        Case("Storage [layers] write combiner gaps and retry", TestCombinerGapsAndRetry, greentea_failure_handler),
+        Case("Storage [layers] write combiner stores per KB", TestCombinerStoresPerKB, greentea_failure_handler),
+        Case("Storage [layers] log append and read", TestLogAppendRead, greentea_failure_handler),
+        Case("Storage [layers] log recovery", TestLogRecovery, greentea_failure_handler),
+        Case("Storage [layers] log torn header", TestLogTornHeader, greentea_failure_handler),
+        Case("Storage [layers] log reclaim", TestLogReclaim, greentea_failure_handler),
+        Case("Storage [layers] log benchmark", TestLogBenchmark, greentea_failure_handler),
+        Case("Storage [layers] kv put and get", TestKVPutGet, greentea_failure_handler),
+        Case("Storage [layers] kv recovery", TestKVRecovery, greentea_failure_handler),
+        Case("Storage [layers] kv garbage collection", TestKVGarbageCollection, greentea_failure_handler),
+        Case("Storage [layers] kv full", TestKVFull, greentea_failure_handler),
+        Case("Storage [layers] kv benchmark", TestKVBenchmark, greentea_failure_handler),
+        Case("Storage [layers] allocator least worn page", TestAllocatorLeastWorn, greentea_failure_handler),
+        Case("Storage [layers] allocator interrupted erase", TestAllocatorInterruptedErase, greentea_failure_handler),
+        Case("Storage [layers] allocator health", TestAllocatorHealth, greentea_failure_handler),
+        Case("Storage [layers] stream write and read", TestStreamWriteRead, greentea_failure_handler),
+        Case("Storage [layers] stream benchmark", TestStreamBenchmark, greentea_failure_handler),
+#if STORAGE_TRACE
+        Case("Storage [layers] trace timeline", TestTraceTimeline, greentea_failure_handler),
+#endif
+        Case("Storage [layers] geometry constants", TestGeometry, greentea_failure_handler),
+        Case("Storage [layers] region", TestRegion, greentea_failure_handler),
+        Case("Storage [layers] erase scheduler pre-erase", TestSchedulerPreErase, greentea_failure_handler),
+        Case("Storage [layers] erase scheduler stall", TestSchedulerStall, greentea_failure_handler),
+        Case("Storage [layers] erase scheduler lost erase", TestSchedulerLostErase, greentea_failure_handler),
+        Case("Storage [layers] erase scheduler slices", TestSchedulerSlices, greentea_failure_handler),
+        Case("Storage [layers] transaction commit", TestTransactionCommit, greentea_failure_handler),
+        Case("Storage [layers] transaction recovery", TestTransactionRecovery, greentea_failure_handler),
+        Case("Storage [layers] transaction torn commit", TestTransactionTornCommit, greentea_failure_handler),
+        Case("Storage [layers] ring buffer push and pop", TestRingPushPop, greentea_failure_handler),
+        Case("Storage [layers] ring buffer wrap", TestRingWrap, greentea_failure_handler),
+        Case("Storage [layers] ring buffer recovery", TestRingRecovery, greentea_failure_handler),
+        Case("Storage [layers] ring buffer benchmark", TestRingBenchmark, greentea_failure_handler),
+};
+
+utest::v1::status_t greentea_test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(150, "default_auto");
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+int main() {
+    // set the storage address (exclude bootloader area)
+    NRF_NVMC->CONFIG = NVMC_CONFIG_WEN_Wen << NVMC_CONFIG_WEN_Pos;
+    while (NRF_NVMC->READY == NVMC_READY_READY_Busy) {}
+    NRF_UICR->NRFFW[0] = 0x7A000;
+    NRF_NVMC->CONFIG = NVMC_CONFIG_WEN_Ren << NVMC_CONFIG_WEN_Pos;
+    while (NRF_NVMC->READY == NVMC_READY_READY_Busy) {}
+
+    NRF52FlashStorage flashStorage;
+    flashStorage.init();
+    flashStorage.erasePage(0, NUM_PAGES);
+
+    Specification specification(greentea_test_setup, cases, greentea_test_teardown_handler);
+    Harness::run(specification);
+}
@@ -0,0 +1,76 @@
+/*
+ * @file PartitionFlashStorageTests.cpp
+ *
+ * Tests for named flash partitions (no softdevice).
+ *
+ * @date 2026-10-15
+ *
+ * Copyright 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include "mbed.h"
+#include <nrf52_bitfields.h>
+#include <NRF52FlashPartitions.h>
+
+#include "utest/utest.h"
+#include "unity/unity.h"
+#include "greentea-client/test_env.h"
+
+#include "../FlashPartitionTests.h"
+
+using namespace utest::v1;
+
+STORAGE_PARTITION(keys, 1, 0xFD);
+STORAGE_PARTITION(telemetry, 2, 0xFC);
+
+static const NRF52FlashPartition partitions[] = {
+        STORAGE_PARTITION_ENTRY(keys),
+        STORAGE_PARTITION_ENTRY(telemetry),
+};
+
+NRF52FlashPartitionTable partitionTable(partitions, sizeof(partitions) / sizeof(partitions[0]));
+
+utest::v1::status_t greentea_failure_handler(const Case *const source, const failure_t reason) { // NOLINT
+    greentea_case_failure_abort_handler(source, reason);
+    return STATUS_CONTINUE;
+}
+
+Case cases[] = {
+        Case("Storage [partitions] partition table", TestPartitionTable, greentea_failure_handler),
+        Case("Storage [partitions] partitions independent", TestPartitionsIndependent, greentea_failure_handler),
+};
+
+utest::v1::status_t greentea_test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(150, "default_auto");
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+int main() {
+    // set the storage address (exclude bootloader area)
+    NRF_NVMC->CONFIG = NVMC_CONFIG_WEN_Wen << NVMC_CONFIG_WEN_Pos;
+    while (NRF_NVMC->READY == NVMC_READY_READY_Busy) {}
+    NRF_UICR->NRFFW[0] = 0x7A000;
+    NRF_NVMC->CONFIG = NVMC_CONFIG_WEN_Ren << NVMC_CONFIG_WEN_Pos;
+    while (NRF_NVMC->READY == NVMC_READY_READY_Busy) {}
+
+    if (!partitionTable.init()) {
+        printf("partition table invalid\r\n");
+    }
+
+    Specification specification(greentea_test_setup, cases, greentea_test_teardown_handler);
+    Harness::run(specification);
+}
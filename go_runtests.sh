@@ -4,4 +4,10 @@ mbed new .
 mbed target NRF52_DK
 mbed toolchain GCC_ARM
 mbed test --compile -n "$TESTS" --app-config TESTS/settings.json
-mbedgt -n "$TESTS" --plain --report-junit=testresult.xml --report-memory-metrics-csv=testmem.csv
\ No newline at end of file
+mbedgt -n "$TESTS" --plain --report-junit=testresult.xml --report-memory-metrics-csv=testmem.csv
+# the layers suite again with the flash operation trace enabled
+mbed test --compile -n 'tests-storage-nrf52-layers' --app-config TESTS/settings-trace.json --build BUILD/tests-trace
+mbedgt --test-spec BUILD/tests-trace/test_spec.json -n 'tests-storage-nrf52-layers' --plain --report-junit=testresult-trace.xml
+# benchmark results as CSV (rows printed by the benchmark suites on the serial console)
+mbedgt -n 'tests-storage-nrf52-benchmark*' --plain -V \
+  | sed -n 's/.*\[RXD\] \(\(path\|sd\|nosd\),.*\)$/\1/p' | tr -d '\r' | awk '!/^path/ || !h++' > benchmark.csv
@@ -0,0 +1,78 @@
+/*!
+ * @file
+ * @brief HostFlashStorageBenchmark.cpp
+ *
+ * Runs the storage benchmark on the simulated flash and writes the results
+ * as CSV, the latencies are projected device time of the cost model.
+ *
+ * usage: bench-host [result.csv]
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#include <stdlib.h>
+#include <SimulatedFlashStorage.h>
+
+#include "HostTestRunner.h"
+
+#ifndef STORAGE_PAGES
+#define STORAGE_PAGES 4
+#endif
+
+static SimulatedFlash hostFlash(STORAGE_PAGES + 1);
+
+/**
+ * The storage as the benchmark sees it, all instances share the same simulated device.
+ */
+class HostFlashStorage : public SimulatedFlashStorage {
+public:
+    HostFlashStorage() : SimulatedFlashStorage(hostFlash, 0, STORAGE_PAGES, 0x7A000) {}
+};
+
+#define FLASH_STORAGE_TYPE HostFlashStorage
+#define FLASH_TEST_CLOCK_US() ((uint32_t) (hostFlash.elapsedNs / 1000))
+#define STORAGE_BENCHMARK_PATH "sim"
+
+#include "../TESTS/storage-nrf52/BenchmarkFlashStorageTests.h"
+
+using namespace utest::v1;
+
+Case benchmarkCases[] = {
+        Case("Storage [sim] benchmark sweep", TestBenchmarkSweep),
+        Case("Storage [sim] benchmark verify", TestBenchmarkVerify),
+};
+
+int main(int argc, char **argv) {
+    HostFlashStorage flashStorage;
+    int failed;
+
+    if (argc > 1) {
+        benchmarkCsv = fopen(argv[1], "w");
+        if (benchmarkCsv == NULL) {
+            perror(argv[1]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    flashStorage.init();
+    flashStorage.erasePage(0, NUM_PAGES);
+    failed = runHostTests("benchmark-host", benchmarkCases, sizeof(benchmarkCases) / sizeof(Case), hostFlash);
+
+    if (benchmarkCsv != NULL) fclose(benchmarkCsv);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,154 @@
+/*!
+ * @file
+ * @brief HostFlashStorageTests.cpp
+ *
+ * Runs the basic and advanced storage tests on the simulated flash.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#include <stdlib.h>
+#include <SimulatedFlashStorage.h>
+
+#include "HostTestRunner.h"
+
+#ifndef STORAGE_PAGES
+#define STORAGE_PAGES 4
+#endif
+
+// one extra page behind the storage, like the flash following the storage region on the chip
+static SimulatedFlash hostFlash(STORAGE_PAGES + 1);
+
+/**
+ * The storage as the tests see it, all instances share the same simulated device.
+ */
+class HostFlashStorage : public SimulatedFlashStorage {
+public:
+    HostFlashStorage() : SimulatedFlashStorage(hostFlash, 0, STORAGE_PAGES, 0x7A000) {}
+};
+
+#define FLASH_STORAGE_TYPE HostFlashStorage
+#define FLASH_TEST_CLOCK_US() ((uint32_t) (hostFlash.elapsedNs / 1000))
+
+#include "../TESTS/storage-nrf52/BasicFlashStorageTests.h"
+#include "../TESTS/storage-nrf52/AdvancedFlashStorageTests.h"
+#include "../TESTS/storage-nrf52/WriteCombinerTests.h"
+#include "../TESTS/storage-nrf52/FlashLogTests.h"
+#include "../TESTS/storage-nrf52/FlashKVTests.h"
+#include "../TESTS/storage-nrf52/FlashPageAllocatorTests.h"
+#include "../TESTS/storage-nrf52/FlashStreamTests.h"
+#include "../TESTS/storage-nrf52/FlashTraceTests.h"
+#include "../TESTS/storage-nrf52/FlashGeometryTests.h"
+#include "../TESTS/storage-nrf52/FlashEraseSchedulerTests.h"
+#include "../TESTS/storage-nrf52/FlashTransactionTests.h"
+#include "../TESTS/storage-nrf52/FlashRingBufferTests.h"
+
+Case basicCases[] = {
+        Case("Storage [sim] test storage write byte", TestStorageWriteSingleByte),
+        Case("Storage [sim] test storage write half word", TestStorageWriteHalfWord),
+        Case("Storage [sim] test storage write 3 byte", TestStorageWriteThreeBytes),
+        Case("Storage [sim] test storage write word", TestStorageWriteWord),
+        Case("Storage [sim] test storage write 2 words", TestStorageWriteMultipleWords),
+        Case("Storage [sim] test storage write 1.5 words", TestStorageWriteWordAndHalfWord),
+        Case("Storage [sim] test storage write buffer", TestStorageWriteBuffer),
+        Case("Storage [sim] test storage write existing fails", TestStorageWriteFailOnUsedFlash),
+        Case("Storage [sim] test storage write non-aligned", TestStorageWriteNonAligned),
+        Case("Storage [sim] test storage blank check", TestStorageBlankCheck),
+        Case("Storage [sim] test storage map", TestStorageMap),
+        Case("Storage [sim] test storage update data", TestStorageUpdateData),
+        Case("Storage [sim] test storage statistics", TestStorageStats),
+        Case("Storage [sim] test storage timeout", TestStorageTimeout),
+        Case("Storage [sim] test storage verify", TestStorageVerify),
+};
+
+Case advancedCases[] = {
+        Case("Storage [sim] test storage", TestStorage),
+        Case("Storage [sim] test storage write subsequent bytes", TestStorageWriteSubsequentBytes),
+        Case("Storage [sim] test storage write byte above end address", TestStorageWriteAboveEndAddress),
+        Case("Storage [sim] test storage write buffer over page boarder", TestStorageWriteOverPageBoarder),
+        Case("Storage [sim] test storage write big buffer", TestStorageWriteBigBuffer),
+        Case("Storage [sim] test storage write large transfer", TestStorageWriteLargeTransfer),
+        Case("Storage [sim] test storage erase pages", TestStorageErasePages),
+        Case("Storage [sim] test storage write over the upper bound", TestStorageWriteOverUpperBound),
+        Case("Storage [sim] test storage write and erase async", TestStorageWriteEraseAsync),
+};
+
+Case layerCases[] = {
+        Case("Storage [sim] write combiner read your writes", TestCombinerReadYourWrites),
+        Case("Storage [sim] write combiner timeout", TestCombinerTimeout),
+        Case("Storage [sim] write combiner gaps and retry", TestCombinerGapsAndRetry),
+        Case("Storage [sim] write combiner stores per KB", TestCombinerStoresPerKB),
+        Case("Storage [sim] log append and read", TestLogAppendRead),
+        Case("Storage [sim] log recovery", TestLogRecovery),
+        Case("Storage [sim] log torn header", TestLogTornHeader),
+        Case("Storage [sim] log reclaim", TestLogReclaim),
+        Case("Storage [sim] log benchmark", TestLogBenchmark),
+        Case("Storage [sim] kv put and get", TestKVPutGet),
+        Case("Storage [sim] kv recovery", TestKVRecovery),
+        Case("Storage [sim] kv garbage collection", TestKVGarbageCollection),
+        Case("Storage [sim] kv full", TestKVFull),
+        Case("Storage [sim] kv benchmark", TestKVBenchmark),
+        Case("Storage [sim] allocator least worn page", TestAllocatorLeastWorn),
+        Case("Storage [sim] allocator interrupted erase", TestAllocatorInterruptedErase),
+        Case("Storage [sim] allocator health", TestAllocatorHealth),
+        Case("Storage [sim] stream write and read", TestStreamWriteRead),
+        Case("Storage [sim] stream benchmark", TestStreamBenchmark),
+#if STORAGE_TRACE
+        Case("Storage [sim] trace timeline", TestTraceTimeline),
+#endif
+        Case("Storage [sim] geometry constants", TestGeometry),
+        Case("Storage [sim] erase scheduler pre-erase", TestSchedulerPreErase),
+        Case("Storage [sim] erase scheduler stall", TestSchedulerStall),
+        Case("Storage [sim] erase scheduler lost erase", TestSchedulerLostErase),
+        Case("Storage [sim] erase scheduler slices", TestSchedulerSlices),
+        Case("Storage [sim] transaction commit", TestTransactionCommit),
+        Case("Storage [sim] transaction recovery", TestTransactionRecovery),
+        Case("Storage [sim] transaction torn commit", TestTransactionTornCommit),
+        Case("Storage [sim] ring buffer push and pop", TestRingPushPop),
+        Case("Storage [sim] ring buffer wrap", TestRingWrap),
+        Case("Storage [sim] ring buffer recovery", TestRingRecovery),
+        Case("Storage [sim] ring buffer benchmark", TestRingBenchmark),
+};
+
+#if STORAGE_TRACE
+// trace timestamps in projected device time
+static uint32_t hostTraceClock() {
+    return FLASH_TEST_CLOCK_US();
+}
+#endif
+
+int main() {
+    HostFlashStorage flashStorage;
+    int failed = 0;
+
+    flashStorage.init();
+#if STORAGE_TRACE
+    FlashTrace::setClock(hostTraceClock, 1000000);
+#endif
+
+    flashStorage.erasePage(0, NUM_PAGES);
+    failed += runHostTests("tests-host-basic", basicCases, sizeof(basicCases) / sizeof(Case), hostFlash);
+
+    flashStorage.erasePage(0, NUM_PAGES);
+    failed += runHostTests("tests-host-advanced", advancedCases, sizeof(advancedCases) / sizeof(Case), hostFlash);
+
+    flashStorage.erasePage(0, NUM_PAGES);
+    failed += runHostTests("tests-host-layers", layerCases, sizeof(layerCases) / sizeof(Case), hostFlash);
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
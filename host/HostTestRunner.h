@@ -0,0 +1,68 @@
+/*!
+ * @file
+ * @brief HostTestRunner.h
+ *
+ * Runs storage test cases on the host against a simulated flash and reports
+ * the projected device time of every case.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#ifndef UBIRCH_MBED_NRF52_STORAGE_HOSTTESTRUNNER_H
+#define UBIRCH_MBED_NRF52_STORAGE_HOSTTESTRUNNER_H
+
+#include <stdio.h>
+#include <unity/unity.h>
+#include <utest/utest.h>
+#include <SimulatedFlashStorage.h>
+
+/*!
+ * Run the test cases and print a report line per case.
+ *
+ * @param suite     name of the test suite
+ * @param cases     test cases
+ * @param numCases  number of test cases
+ * @param flash     simulated device used by the cases
+ *
+ * @return          number of failed cases
+ */
+static int runHostTests(const char *suite, const utest::v1::Case *cases, size_t numCases, SimulatedFlash &flash) {
+    int failed = 0;
+    for (size_t i = 0; i < numCases; i++) {
+        flash.resetCounters();
+        const char *result = "OK";
+        try {
+            if (cases[i].handler) {
+                cases[i].handler();
+            } else {
+                size_t callCount = 1;
+                while (cases[i].repeatHandler(callCount) == utest::v1::CaseRepeatAll) callCount++;
+            }
+        } catch (UnityFailure &failure) {
+            printf("%s:%d: %s\r\n", failure.file, failure.line, failure.message);
+            result = "FAIL";
+            failed++;
+        }
+        printf("| %-24s | %-58s | %-4s | %8u words | %4u erases | %10.3f ms |\r\n",
+               suite, cases[i].description, result,
+               flash.wordsWritten, flash.pagesErased, flash.elapsedNs / 1000000.0);
+    }
+    return failed;
+}
+
+#endif //UBIRCH_MBED_NRF52_STORAGE_HOSTTESTRUNNER_H
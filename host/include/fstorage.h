@@ -0,0 +1,46 @@
+/*!
+ * @file
+ * @brief fstorage.h
+ *
+ * Host replacement for the Nordic SDK fstorage header. Only provides the
+ * return codes, so the storage interface compiles without the SDK.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#ifndef UBIRCH_MBED_NRF52_STORAGE_HOST_FSTORAGE_H
+#define UBIRCH_MBED_NRF52_STORAGE_HOST_FSTORAGE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// same values as the SDK fs_ret_t
+typedef enum {
+    FS_SUCCESS,
+    FS_ERR_NOT_INITIALIZED,
+    FS_ERR_INVALID_CFG,
+    FS_ERR_NULL_ARG,
+    FS_ERR_INVALID_ARG,
+    FS_ERR_INVALID_ADDR,
+    FS_ERR_UNALIGNED_ADDR,
+    FS_ERR_QUEUE_FULL,
+    FS_ERR_OPERATION_TIMEOUT,
+    FS_ERR_INTERNAL,
+} fs_ret_t;
+
+#endif //UBIRCH_MBED_NRF52_STORAGE_HOST_FSTORAGE_H
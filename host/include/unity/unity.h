@@ -0,0 +1,83 @@
+/*!
+ * @file
+ * @brief unity.h
+ *
+ * Minimal host replacement for the unity assertions used by the storage tests.
+ * A failed assertion throws a UnityFailure that is caught by the host runner.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#ifndef UBIRCH_MBED_NRF52_STORAGE_HOST_UNITY_H
+#define UBIRCH_MBED_NRF52_STORAGE_HOST_UNITY_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+struct UnityFailure {
+    const char *file;
+    int line;
+    const char *message;
+};
+
+static inline void UnityFail(const char *file, int line, const char *message) {
+    UnityFailure failure = {file, line, message};
+    throw failure;
+}
+
+static inline void UnityAssertEqualHex8Array(const uint8_t *expected, const uint8_t *actual, size_t length,
+                                             const char *file, int line, const char *message) {
+    for (size_t i = 0; i < length; i++) {
+        if (expected[i] != actual[i]) {
+            printf("  [%u] expected 0x%02X, was 0x%02X\r\n", (unsigned) i, expected[i], actual[i]);
+            UnityFail(file, line, message);
+        }
+    }
+}
+
+#define TEST_FAIL_MESSAGE(message) UnityFail(__FILE__, __LINE__, message)
+#define TEST_ASSERT_MESSAGE(condition, message) do { if (!(condition)) TEST_FAIL_MESSAGE(message); } while (0)
+
+#define TEST_ASSERT_TRUE_MESSAGE(condition, message) TEST_ASSERT_MESSAGE(condition, message)
+#define TEST_ASSERT_FALSE_MESSAGE(condition, message) TEST_ASSERT_MESSAGE(!(condition), message)
+#define TEST_ASSERT_EQUAL_MESSAGE(expected, actual, message) TEST_ASSERT_MESSAGE((expected) == (actual), message)
+#define TEST_ASSERT_NOT_EQUAL_MESSAGE(expected, actual, message) TEST_ASSERT_MESSAGE((expected) != (actual), message)
+#define TEST_ASSERT_EQUAL_UINT32_MESSAGE(expected, actual, message) \
+    TEST_ASSERT_MESSAGE((uint32_t) (expected) == (uint32_t) (actual), message)
+#define TEST_ASSERT_EQUAL_UINT16_MESSAGE(expected, actual, message) \
+    TEST_ASSERT_MESSAGE((uint16_t) (expected) == (uint16_t) (actual), message)
+#define TEST_ASSERT_EQUAL_HEX32_MESSAGE(expected, actual, message) \
+    TEST_ASSERT_MESSAGE((uint32_t) (expected) == (uint32_t) (actual), message)
+#define TEST_ASSERT_EQUAL_HEX8_MESSAGE(expected, actual, message) \
+    TEST_ASSERT_MESSAGE((uint8_t) (expected) == (uint8_t) (actual), message)
+#define TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(expected, actual, length, message) \
+    UnityAssertEqualHex8Array((const uint8_t *) (expected), (const uint8_t *) (actual), length, \
+                              __FILE__, __LINE__, message)
+
+#define TEST_ASSERT_TRUE(condition) TEST_ASSERT_TRUE_MESSAGE(condition, #condition)
+#define TEST_ASSERT_FALSE(condition) TEST_ASSERT_FALSE_MESSAGE(condition, #condition)
+#define TEST_ASSERT_EQUAL(expected, actual) TEST_ASSERT_EQUAL_MESSAGE(expected, actual, "values differ")
+#define TEST_ASSERT_EQUAL_UINT32(expected, actual) TEST_ASSERT_EQUAL_UINT32_MESSAGE(expected, actual, "values differ")
+#define TEST_ASSERT_EQUAL_UINT16(expected, actual) TEST_ASSERT_EQUAL_UINT16_MESSAGE(expected, actual, "values differ")
+#define TEST_ASSERT_EQUAL_HEX32(expected, actual) TEST_ASSERT_EQUAL_HEX32_MESSAGE(expected, actual, "values differ")
+#define TEST_ASSERT_EQUAL_HEX8(expected, actual) TEST_ASSERT_EQUAL_HEX8_MESSAGE(expected, actual, "values differ")
+#define TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, actual, length) \
+    TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(expected, actual, length, "arrays differ")
+
+#endif //UBIRCH_MBED_NRF52_STORAGE_HOST_UNITY_H
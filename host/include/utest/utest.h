@@ -0,0 +1,59 @@
+/*!
+ * @file
+ * @brief utest.h
+ *
+ * Minimal host replacement for the utest case control used by the storage tests.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#ifndef UBIRCH_MBED_NRF52_STORAGE_HOST_UTEST_H
+#define UBIRCH_MBED_NRF52_STORAGE_HOST_UTEST_H
+
+#include <stddef.h>
+
+namespace utest {
+namespace v1 {
+
+enum control_t {
+    CaseNext,
+    CaseRepeatAll
+};
+
+typedef void (*case_handler_t)(void);
+typedef control_t (*case_call_count_handler_t)(const size_t call_count);
+
+/**
+ * A test case, either a simple function or one that is repeated on request.
+ */
+struct Case {
+    Case(const char *description, case_handler_t handler)
+            : description(description), handler(handler), repeatHandler(NULL) {}
+
+    Case(const char *description, case_call_count_handler_t handler)
+            : description(description), handler(NULL), repeatHandler(handler) {}
+
+    const char *description;
+    case_handler_t handler;
+    case_call_count_handler_t repeatHandler;
+};
+
+}
+}
+
+#endif //UBIRCH_MBED_NRF52_STORAGE_HOST_UTEST_H
@@ -0,0 +1,192 @@
+/*!
+ * @file
+ * @brief FlashEraseScheduler.cpp
+ *
+ * Background erase of dirty pages, keeps a pool of erased pages ready.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#include "FlashEraseScheduler.h"
+
+#define PRINTF(...)
+//#define PRINTF printf
+
+FlashEraseScheduler::FlashEraseScheduler(FlashStorage &storage, uint8_t firstPage, uint8_t numPages,
+                                         uint8_t reserve)
+        : storage(storage), firstPage(firstPage),
+          numPages(numPages < STORAGE_ERASE_MAX_PAGES ? numPages : (uint8_t) STORAGE_ERASE_MAX_PAGES),
+          reserve(reserve), nextTake(0), erasing(false), slicing(false), erasingPage(0), stalls(0), backgroundErases(0) {
+    for (uint8_t i = 0; i < STORAGE_ERASE_MAX_PAGES; i++) state[i] = FLASH_PAGE_DIRTY;
+}
+
+bool FlashEraseScheduler::mount() {
+    const uint32_t pageSize = storage.getPageSize();
+    if (numPages == 0 || erasing || slicing) {
+        return false;
+    }
+    for (uint8_t i = 0; i < numPages; i++) {
+        state[i] = storage.isErased((firstPage + i) * pageSize, pageSize) ? FLASH_PAGE_ERASED : FLASH_PAGE_IN_USE;
+    }
+    nextTake = 0;
+    return true;
+}
+
+bool FlashEraseScheduler::take(uint8_t &page, bool wait) {
+    bool stalled = false;
+    for (;;) {
+        for (uint8_t n = 0; n < numPages; n++) {
+            const uint8_t i = (uint8_t) ((nextTake + n) % numPages);
+            if (state[i] == FLASH_PAGE_ERASED) {
+                state[i] = FLASH_PAGE_IN_USE;
+                nextTake = (uint8_t) ((i + 1) % numPages);
+                page = (uint8_t) (firstPage + i);
+                return true;
+            }
+        }
+        if (!wait) {
+            return false;
+        }
+
+        // no page ready: wait for the erase in progress or erase a dirty page right now
+        uint8_t i = 0;
+        while (i < numPages && state[i] != FLASH_PAGE_DIRTY) i++;
+        if (!erasing && !slicing && i == numPages) {
+            PRINTF("ERASE SCHEDULER no free page\r\n");
+            return false;
+        }
+        if (!stalled) stalls++;
+        stalled = true;
+        if (erasing) {
+            // bounded by the timeout of the storage, the erase may still complete later
+            if (!storage.waitUntil(eraseDone, this)) {
+                PRINTF("ERASE SCHEDULER erase timed out\r\n");
+                return false;
+            }
+            continue;
+        }
+        if (slicing) {
+            // finish the erase in slices right now
+            while (slicing) {
+                if (!pollSlice()) return false;
+            }
+            continue;
+        }
+        if (!storage.erasePage((uint8_t) (firstPage + i), 1)) {
+            return false;
+        }
+        state[i] = FLASH_PAGE_ERASED;
+    }
+}
+
+bool FlashEraseScheduler::release(uint8_t page) {
+    const uint8_t i = (uint8_t) (page - firstPage);
+    if (page < firstPage || i >= numPages || state[i] != FLASH_PAGE_IN_USE) {
+        return false;
+    }
+    state[i] = FLASH_PAGE_DIRTY;
+    return true;
+}
+
+bool FlashEraseScheduler::poll() {
+    if (erasing || slicing || count(FLASH_PAGE_ERASED) >= reserve) {
+        return false;
+    }
+    uint8_t i = 0;
+    while (i < numPages && state[i] != FLASH_PAGE_DIRTY) i++;
+    if (i == numPages) {
+        return false;
+    }
+
+    // mark the erase before queueing it, without softdevice the callback comes right away
+    erasingPage = i;
+    state[i] = FLASH_PAGE_ERASING;
+    erasing = true;
+    if (!storage.erasePageAsync((uint8_t) (firstPage + i), 1, eraseComplete, this)) {
+        if (erasing) {
+            state[i] = FLASH_PAGE_DIRTY;
+            erasing = false;
+        }
+        return false;
+    }
+    backgroundErases++;
+    return true;
+}
+
+bool FlashEraseScheduler::pollSlice() {
+    if (erasing) {
+        return false;
+    }
+    if (!slicing) {
+        if (count(FLASH_PAGE_ERASED) >= reserve) {
+            return false;
+        }
+        uint8_t i = 0;
+        while (i < numPages && state[i] != FLASH_PAGE_DIRTY) i++;
+        if (i == numPages) {
+            return false;
+        }
+        erasingPage = i;
+        state[i] = FLASH_PAGE_ERASING;
+        slicing = true;
+    }
+
+    bool done = false;
+    if (!storage.eraseSlice((uint8_t) (firstPage + erasingPage), done)) {
+        state[erasingPage] = FLASH_PAGE_DIRTY;
+        slicing = false;
+        return false;
+    }
+    if (done) {
+        state[erasingPage] = FLASH_PAGE_ERASED;
+        slicing = false;
+        backgroundErases++;
+    }
+    return true;
+}
+
+void FlashEraseScheduler::eraseComplete(void *context, fs_ret_t result) {
+    FlashEraseScheduler *scheduler = (FlashEraseScheduler *) context;
+    scheduler->state[scheduler->erasingPage] = result == FS_SUCCESS ? FLASH_PAGE_ERASED : FLASH_PAGE_DIRTY;
+    scheduler->erasing = false;
+}
+
+bool FlashEraseScheduler::eraseDone(void *context) {
+    return !((FlashEraseScheduler *) context)->erasing;
+}
+
+FlashPageState FlashEraseScheduler::getState(uint8_t page) const {
+    const uint8_t i = (uint8_t) (page - firstPage);
+    return page >= firstPage && i < numPages ? (FlashPageState) state[i] : FLASH_PAGE_IN_USE;
+}
+
+uint8_t FlashEraseScheduler::getReady() const {
+    return count(FLASH_PAGE_ERASED);
+}
+
+uint8_t FlashEraseScheduler::getDirty() const {
+    return count(FLASH_PAGE_DIRTY);
+}
+
+uint8_t FlashEraseScheduler::count(FlashPageState pageState) const {
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < numPages; i++) {
+        if (state[i] == pageState) n++;
+    }
+    return n;
+}
@@ -0,0 +1,177 @@
+/*!
+ * @file
+ * @brief FlashEraseScheduler.h
+ *
+ * Background erase of dirty pages, keeps a pool of erased pages ready.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#ifndef UBIRCH_MBED_NRF52_STORAGE_FLASHERASESCHEDULER_H
+#define UBIRCH_MBED_NRF52_STORAGE_FLASHERASESCHEDULER_H
+
+#include "FlashStorage.h"
+
+// maximum number of pages managed by a scheduler (one byte of RAM each)
+#ifndef STORAGE_ERASE_MAX_PAGES
+#define STORAGE_ERASE_MAX_PAGES 32
+#endif
+
+// default number of erased pages kept ready
+#ifndef STORAGE_ERASE_RESERVE
+#define STORAGE_ERASE_RESERVE 1
+#endif
+
+/**
+ * State of a page managed by the scheduler.
+ */
+enum FlashPageState {
+    FLASH_PAGE_DIRTY = 0,       //!< released, has to be erased before it can be used again
+    FLASH_PAGE_ERASING,         //!< the erase is queued
+    FLASH_PAGE_ERASED,          //!< ready to be taken
+    FLASH_PAGE_IN_USE           //!< taken by a writer
+};
+
+/**
+ * Erase scheduler with a pool of pre-erased pages.
+ *
+ * Writers take an erased page with take() and release() it when its data is
+ * no longer needed. The released pages are erased in the background by poll(),
+ * one page at a time, until `reserve` pages are ready again. Call poll() when
+ * the system is idle, e.g. from an EventQueue::call_every() or an idle hook.
+ * With the softdevice the erase is queued with erasePageAsync() and poll()
+ * returns right away. Without the softdevice the NVMC stops the CPU for the
+ * erase, but that happens in the idle time and not in the writer.
+ *
+ * To keep the CPU free for other work without the softdevice, use pollSlice()
+ * instead: every call erases for one slice of STORAGE_ERASE_SLICE_MS only
+ * (see FlashStorage::eraseSlice()).
+ *
+ * A writer only waits for an erase, if it takes a page while none is ready
+ * (counted by getStalls()).
+ */
+class FlashEraseScheduler {
+
+public:
+
+    /*!
+     * @brief   Constructor
+     *
+     * @param storage       the underlying storage
+     * @param firstPage     first page of the storage managed by the scheduler
+     * @param numPages      number of pages managed by the scheduler, at most STORAGE_ERASE_MAX_PAGES
+     * @param reserve       number of erased pages to keep ready
+     */
+    FlashEraseScheduler(FlashStorage &storage, uint8_t firstPage, uint8_t numPages,
+                        uint8_t reserve = STORAGE_ERASE_RESERVE);
+
+    /*!
+     * Check which pages are erased. All other pages hold data and are in use
+     * until their owner releases them.
+     *
+     * @return true, if the pages could be checked
+     */
+    bool mount();
+
+    /*!
+     * Take an erased page for writing.
+     *
+     * @param page      receives the storage page number
+     * @param wait      if no page is ready, erase a dirty page and wait for it, at most
+     *                  the timeout of the storage for an erase in the background
+     *
+     * @return true, if a page has been taken
+     */
+    bool take(uint8_t &page, bool wait = true);
+
+    /*!
+     * Release a page, it will be erased in the background.
+     *
+     * @param page      storage page number
+     *
+     * @return true, if the page was in use
+     */
+    bool release(uint8_t page);
+
+    /*!
+     * Erase a dirty page in the background, if less than `reserve` pages are
+     * ready and no erase is in progress.
+     *
+     * @return true, if an erase has been started
+     */
+    bool poll();
+
+    /*!
+     * Like poll(), but run a single slice of the background erase. Call it
+     * repeatedly, the page is ready after the last slice.
+     *
+     * @return true, if a slice has been run
+     */
+    bool pollSlice();
+
+    /*!
+     * Get the state of a page.
+     */
+    FlashPageState getState(uint8_t page) const;
+
+    /*!
+     * Get the number of erased pages ready to be taken.
+     */
+    uint8_t getReady() const;
+
+    /*!
+     * Get the number of pages waiting for the erase.
+     */
+    uint8_t getDirty() const;
+
+    /*!
+     * Check, if a background erase is in progress.
+     */
+    bool isErasing() const { return erasing; }
+
+    /*!
+     * Get the number of times take() had to wait for an erase.
+     */
+    uint32_t getStalls() const { return stalls; }
+
+    /*!
+     * Get the number of pages erased in the background.
+     */
+    uint32_t getBackgroundErases() const { return backgroundErases; }
+
+protected:
+    FlashStorage &storage;
+    uint8_t firstPage;
+    uint8_t numPages;
+    uint8_t reserve;
+    uint8_t nextTake;                               // round robin, so the erases rotate over all pages
+    volatile bool erasing;                          // an erase is queued
+    bool slicing;                                   // an erase in slices is in progress
+    uint8_t erasingPage;                            // index of the page being erased
+    volatile uint8_t state[STORAGE_ERASE_MAX_PAGES];
+    uint32_t stalls;
+    uint32_t backgroundErases;
+
+    uint8_t count(FlashPageState pageState) const;
+
+    static void eraseComplete(void *context, fs_ret_t result);
+
+    static bool eraseDone(void *context);
+};
+
+#endif //UBIRCH_MBED_NRF52_STORAGE_FLASHERASESCHEDULER_H
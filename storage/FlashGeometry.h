@@ -0,0 +1,108 @@
+/*!
+ * @file
+ * @brief FlashGeometry.h
+ *
+ * Compile-time geometry of a flash region.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#ifndef UBIRCH_MBED_NRF52_STORAGE_FLASHGEOMETRY_H
+#define UBIRCH_MBED_NRF52_STORAGE_FLASHGEOMETRY_H
+
+#include <stdint.h>
+
+/*
+ * compile-time check (C++98 has no static_assert), the array size is negative
+ * and the compiler stops with an error mentioning the name if the condition is false
+ */
+#define FLASH_STATIC_ASSERT(condition, name) typedef char name[(condition) ? 1 : -1]
+
+/**
+ * Base 2 logarithm of a power of two, 0 for anything else.
+ */
+template<uint32_t N>
+struct FlashLog2 {
+    static const uint32_t value = (N & (N - 1)) ? 0 : 1 + FlashLog2<N / 2>::value;
+};
+
+template<>
+struct FlashLog2<1> {
+    static const uint32_t value = 0;
+};
+
+template<>
+struct FlashLog2<0> {
+    static const uint32_t value = 0;
+};
+
+/**
+ * Geometry of a region of Pages pages with PageWords 32 bit words each.
+ *
+ * All values are compile-time constants, so the bounds checks, page index and
+ * alignment math fold into immediate operands. Invalid geometries (no pages,
+ * more than 255 pages, a page size that is not a power of two) do not compile.
+ */
+template<uint32_t Pages, uint32_t PageWords>
+struct FlashGeometry {
+    static const uint32_t PAGES = Pages;                        //!< number of pages
+    static const uint32_t PAGE_WORDS = PageWords;               //!< words per page
+    static const uint32_t PAGE_SIZE = PageWords * 4;            //!< bytes per page
+    static const uint32_t PAGE_SHIFT = FlashLog2<PAGE_SIZE>::value;
+    static const uint32_t PAGE_MASK = PAGE_SIZE - 1;
+    static const uint32_t WORD_MASK = 3;
+    static const uint32_t SIZE = Pages * PAGE_SIZE;             //!< bytes of the region
+
+    FLASH_STATIC_ASSERT(Pages > 0, flash_geometry_needs_pages);
+    // erasePage() addresses pages with 8 bit indices
+    FLASH_STATIC_ASSERT(Pages <= 255, flash_geometry_too_many_pages);
+    FLASH_STATIC_ASSERT(PageWords > 0 && (PageWords & (PageWords - 1)) == 0, flash_geometry_page_not_power_of_two);
+    FLASH_STATIC_ASSERT(SIZE / PAGE_SIZE == Pages, flash_geometry_size_overflow);
+
+    /*!
+     * Check that length8 bytes at p_location, padded to whole words, are inside the region.
+     */
+    static inline bool contains(uint32_t p_location, uint32_t length8) {
+        return p_location < SIZE && length8 <= SIZE - p_location &&
+               ((p_location + length8 + WORD_MASK) & ~WORD_MASK) <= SIZE;
+    }
+
+    /*!
+     * Get the index of the page of a location.
+     */
+    static inline uint32_t pageIndex(uint32_t p_location) { return p_location >> PAGE_SHIFT; }
+
+    /*!
+     * Get the offset of a location inside its page.
+     */
+    static inline uint32_t pageOffset(uint32_t p_location) { return p_location & PAGE_MASK; }
+
+    /*!
+     * Get the start of the page of a location.
+     */
+    static inline uint32_t pageStart(uint32_t p_location) { return p_location & ~PAGE_MASK; }
+
+    /*!
+     * Get the number of words touched by length8 bytes at p_location.
+     */
+    static inline uint32_t words(uint32_t p_location, uint32_t length8) {
+        return ((p_location & WORD_MASK) + length8 + WORD_MASK) >> 2;
+    }
+};
+
+#endif //UBIRCH_MBED_NRF52_STORAGE_FLASHGEOMETRY_H
@@ -0,0 +1,276 @@
+/*!
+ * @file
+ * @brief FlashKV.cpp
+ *
+ * Key-value store on top of the flash record log.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#include <string.h>
+#include "FlashKV.h"
+
+#define PRINTF(...)
+//#define PRINTF printf
+
+#if FLASHKV_MAX_KEYS >= FLASHKV_INDEX_SIZE
+#error "FLASHKV_INDEX_SIZE must be larger than FLASHKV_MAX_KEYS"
+#endif
+
+#define FLASHKV_EMPTY 0xFFFFFFFF
+
+// record flags
+#define FLASHKV_FLAG_DELETED 0x01
+
+// key length and flags in front of the key
+#define FLASHKV_RECORD_HEADER_SIZE 2
+
+FlashKV::FlashKV(FlashStorage &storage, uint8_t firstPage, uint8_t numPages)
+        : storage(storage), log(storage, firstPage, numPages), erases(0) {
+    clearIndex();
+    log.setReclaimHandler(reclaim, this);
+}
+
+bool FlashKV::mount() {
+    clearIndex();
+    if (!log.mount()) {
+        return false;
+    }
+
+    // replay the log, the last version of every key wins
+    FlashLogCursor cursor = log.begin();
+    uint16_t length;
+    uint32_t location;
+    while (log.next(cursor, record, sizeof(record), length, &location)) {
+        const uint8_t keyLength = record[0];
+        if (keyLength == 0 || keyLength > FLASHKV_MAX_KEY_SIZE || FLASHKV_RECORD_HEADER_SIZE + keyLength > length) {
+            PRINTF("KV skipping invalid record at 0x%08x\r\n", location);
+            continue;
+        }
+
+        const char *key = (const char *) record + FLASHKV_RECORD_HEADER_SIZE;
+        const uint16_t keyHash = hash(key, keyLength);
+        uint32_t slot;
+        const bool found = find(key, keyLength, keyHash, slot);
+
+        if (found) {
+            liveBytes -= index[slot].size;
+        } else if (!(record[1] & FLASHKV_FLAG_DELETED)) {
+            if (count >= FLASHKV_MAX_KEYS) {
+                PRINTF("KV too many keys\r\n");
+                return false;
+            }
+            count++;
+        }
+
+        if (record[1] & FLASHKV_FLAG_DELETED) {
+            if (found) {
+                count--;
+                removeSlot(slot);
+            }
+            continue;
+        }
+
+        index[slot].location = location;
+        index[slot].hash = keyHash;
+        index[slot].size = (uint16_t) FlashLog::getRecordSize(length);
+        liveBytes += index[slot].size;
+    }
+
+    PRINTF("KV mounted %u keys, %u bytes\r\n", count, liveBytes);
+    return true;
+}
+
+bool FlashKV::format() {
+    clearIndex();
+    return log.format();
+}
+
+bool FlashKV::put(const char *key, const uint8_t *value, uint16_t length) {
+    const size_t keyLength = key ? strlen(key) : 0;
+    if (keyLength == 0 || keyLength > FLASHKV_MAX_KEY_SIZE || length > FLASHKV_MAX_VALUE_SIZE ||
+        (value == NULL && length > 0)) {
+        return false;
+    }
+
+    const uint16_t keyHash = hash(key, (uint8_t) keyLength);
+    uint32_t slot;
+    const bool exists = find(key, (uint8_t) keyLength, keyHash, slot);
+    if (!exists && count >= FLASHKV_MAX_KEYS) {
+        PRINTF("KV too many keys\r\n");
+        return false;
+    }
+
+    // the live data has to fit into a single page, so the garbage collection can always move it;
+    // the old version of an updated key is moved as well, until the new one has been appended
+    const uint16_t size = (uint16_t) FlashLog::getRecordSize(
+            (uint16_t) (FLASHKV_RECORD_HEADER_SIZE + keyLength + length));
+    const uint16_t oldSize = exists ? index[slot].size : (uint16_t) 0;
+    if (liveBytes + size > getCapacity()) {
+        PRINTF("KV no space left\r\n");
+        return false;
+    }
+
+    // the garbage collection may update the location of this key, but not its slot
+    uint32_t location;
+    if (!append(record, key, (uint8_t) keyLength, 0, value, length, location)) {
+        return false;
+    }
+
+    if (!exists) count++;
+    index[slot].location = location;
+    index[slot].hash = keyHash;
+    index[slot].size = size;
+    liveBytes = liveBytes - oldSize + size;
+    return true;
+}
+
+bool FlashKV::get(const char *key, uint8_t *value, uint16_t size, uint16_t &length) {
+    const size_t keyLength = key ? strlen(key) : 0;
+    length = 0;
+    if (keyLength == 0 || keyLength > FLASHKV_MAX_KEY_SIZE) {
+        return false;
+    }
+
+    uint32_t slot;
+    uint16_t recordLength;
+    if (!find(key, (uint8_t) keyLength, hash(key, (uint8_t) keyLength), slot) ||
+        !log.readRecord(index[slot].location, record, sizeof(record), recordLength)) {
+        return false;
+    }
+
+    length = (uint16_t) (recordLength - FLASHKV_RECORD_HEADER_SIZE - keyLength);
+    if (length > size) {
+        return false;
+    }
+    memcpy(value, record + FLASHKV_RECORD_HEADER_SIZE + keyLength, length);
+    return true;
+}
+
+bool FlashKV::remove(const char *key) {
+    const size_t keyLength = key ? strlen(key) : 0;
+    if (keyLength == 0 || keyLength > FLASHKV_MAX_KEY_SIZE) {
+        return false;
+    }
+
+    uint32_t slot;
+    if (!find(key, (uint8_t) keyLength, hash(key, (uint8_t) keyLength), slot)) {
+        return false;
+    }
+
+    // the tombstone follows any version moved by the garbage collection
+    uint32_t location;
+    if (!append(record, key, (uint8_t) keyLength, FLASHKV_FLAG_DELETED, NULL, 0, location)) {
+        return false;
+    }
+
+    liveBytes -= index[slot].size;
+    count--;
+    removeSlot(slot);
+    return true;
+}
+
+uint16_t FlashKV::hash(const char *key, uint8_t keyLength) {
+    // FNV-1a, folded to 16 bits
+    uint32_t h = 2166136261U;
+    for (uint8_t i = 0; i < keyLength; i++) {
+        h = (h ^ (uint8_t) key[i]) * 16777619U;
+    }
+    return (uint16_t) ((h >> 16) ^ h);
+}
+
+bool FlashKV::find(const char *key, uint8_t keyLength, uint16_t keyHash, uint32_t &slot) {
+    // linear probing, the index always has empty slots
+    for (slot = keyHash % FLASHKV_INDEX_SIZE; index[slot].location != FLASHKV_EMPTY;
+         slot = (slot + 1) % FLASHKV_INDEX_SIZE) {
+        if (index[slot].hash != keyHash) continue;
+
+        uint8_t stored[FLASHKV_RECORD_HEADER_SIZE + FLASHKV_MAX_KEY_SIZE];
+        if (storage.readData(index[slot].location + FLASHLOG_RECORD_HEADER_SIZE, stored,
+                             (uint16_t) (FLASHKV_RECORD_HEADER_SIZE + keyLength)) &&
+            stored[0] == keyLength && memcmp(stored + FLASHKV_RECORD_HEADER_SIZE, key, keyLength) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FlashKV::removeSlot(uint32_t slot) {
+    // move following entries of the probe sequence into the gap
+    uint32_t next = slot;
+    while (true) {
+        next = (next + 1) % FLASHKV_INDEX_SIZE;
+        if (index[next].location == FLASHKV_EMPTY) break;
+
+        const uint32_t home = index[next].hash % FLASHKV_INDEX_SIZE;
+        const bool between = slot <= next ? (slot < home && home <= next) : (slot < home || home <= next);
+        if (!between) {
+            index[slot] = index[next];
+            slot = next;
+        }
+    }
+    index[slot].location = FLASHKV_EMPTY;
+}
+
+void FlashKV::clearIndex() {
+    for (uint32_t slot = 0; slot < FLASHKV_INDEX_SIZE; slot++) {
+        index[slot].location = FLASHKV_EMPTY;
+    }
+    count = 0;
+    liveBytes = 0;
+}
+
+bool FlashKV::append(uint8_t *buffer, const char *key, uint8_t keyLength, uint8_t flags,
+                     const uint8_t *value, uint16_t length, uint32_t &location) {
+    buffer[0] = keyLength;
+    buffer[1] = flags;
+    memcpy(buffer + FLASHKV_RECORD_HEADER_SIZE, key, keyLength);
+    if (length) memcpy(buffer + FLASHKV_RECORD_HEADER_SIZE + keyLength, value, length);
+    return log.append(buffer, (uint16_t) (FLASHKV_RECORD_HEADER_SIZE + keyLength + length), &location);
+}
+
+bool FlashKV::reclaim(void *context, uint32_t sequence, uint32_t location) {
+    FlashKV *kv = (FlashKV *) context;
+    const uint32_t end = location + kv->storage.getPageSize();
+
+    // append the latest versions in the page again, everything else is garbage
+    FlashLogCursor cursor = {sequence, FLASHLOG_PAGE_HEADER_SIZE};
+    uint16_t length;
+    uint32_t recordLocation;
+    while (kv->log.next(cursor, kv->moved, sizeof(kv->moved), length, &recordLocation) &&
+           recordLocation >= location && recordLocation < end) {
+        const uint8_t keyLength = kv->moved[0];
+        if ((kv->moved[1] & FLASHKV_FLAG_DELETED) || keyLength == 0 || keyLength > FLASHKV_MAX_KEY_SIZE ||
+            FLASHKV_RECORD_HEADER_SIZE + keyLength > length) {
+            continue;
+        }
+
+        const char *key = (const char *) kv->moved + FLASHKV_RECORD_HEADER_SIZE;
+        uint32_t slot;
+        if (!kv->find(key, keyLength, hash(key, keyLength), slot) || kv->index[slot].location != recordLocation) {
+            continue;
+        }
+        if (!kv->log.append(kv->moved, length, &kv->index[slot].location)) {
+            PRINTF("KV failed to move record at 0x%08x\r\n", recordLocation);
+            return false;
+        }
+    }
+
+    kv->erases++;
+    return true;
+}
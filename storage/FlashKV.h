@@ -0,0 +1,176 @@
+/*!
+ * @file
+ * @brief FlashKV.h
+ *
+ * Key-value store on top of the flash record log.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#ifndef UBIRCH_MBED_NRF52_STORAGE_FLASHKV_H
+#define UBIRCH_MBED_NRF52_STORAGE_FLASHKV_H
+
+#include "FlashLog.h"
+
+// maximum number of keys
+#ifndef FLASHKV_MAX_KEYS
+#define FLASHKV_MAX_KEYS 48
+#endif
+
+// number of slots of the RAM index, larger than FLASHKV_MAX_KEYS to keep the probe sequences short
+#ifndef FLASHKV_INDEX_SIZE
+#define FLASHKV_INDEX_SIZE 64
+#endif
+
+// maximum length of a key
+#ifndef FLASHKV_MAX_KEY_SIZE
+#define FLASHKV_MAX_KEY_SIZE 32
+#endif
+
+// maximum length of a value
+#ifndef FLASHKV_MAX_VALUE_SIZE
+#define FLASHKV_MAX_VALUE_SIZE 256
+#endif
+
+/**
+ * Key-value store.
+ *
+ * Every put() appends a new version of the key to a FlashLog, nothing is
+ * overwritten or erased in place. A RAM index maps the hash of every key to
+ * the location of its latest version, so a lookup reads the flash only at that
+ * location. The index is built by mount() from the log.
+ *
+ * When the log runs full, the live versions in its oldest page are appended
+ * again and the page is erased. The log uses its pages as a ring, so the erases
+ * are spread evenly across all pages. The live data, including the old version
+ * of a key being updated, is limited to one page, the less live data, the less
+ * has to be copied per erase.
+ *
+ * A record consists of the key length, flags, the key and the value.
+ */
+class FlashKV {
+
+public:
+
+    /*!
+     * @brief   Constructor
+     *
+     * @param storage       the underlying storage
+     * @param firstPage     first page of the storage used by the store
+     * @param numPages      number of pages used by the store (at least 2)
+     */
+    FlashKV(FlashStorage &storage, uint8_t firstPage, uint8_t numPages);
+
+    /*!
+     * Recover the store from the flash and build the index. An empty storage is formatted.
+     *
+     * @return true, if the store is ready to use
+     */
+    bool mount();
+
+    /*!
+     * Erase all pages of the store.
+     *
+     * @return true, if the store is ready to use
+     */
+    bool format();
+
+    /*!
+     * Store a value.
+     *
+     * @param key       the key, a string of 1 to FLASHKV_MAX_KEY_SIZE characters
+     * @param value     the value
+     * @param length    length of the value, 0 to FLASHKV_MAX_VALUE_SIZE
+     *
+     * @return true, if the value has been stored, false if there is no space left
+     */
+    bool put(const char *key, const uint8_t *value, uint16_t length);
+
+    /*!
+     * Get a value.
+     *
+     * @param key       the key
+     * @param value     buffer for the value
+     * @param size      size of the buffer
+     * @param length    receives the length of the value
+     *
+     * @return true, if the key exists and the value fits into the buffer
+     */
+    bool get(const char *key, uint8_t *value, uint16_t size, uint16_t &length);
+
+    /*!
+     * Remove a key.
+     *
+     * @return true, if the key existed and has been removed
+     */
+    bool remove(const char *key);
+
+    /*!
+     * Get the number of keys.
+     */
+    uint32_t getCount() const { return count; }
+
+    /*!
+     * Get the flash space used by the latest versions of all keys.
+     */
+    uint32_t getLiveBytes() const { return liveBytes; }
+
+    /*!
+     * Get the maximum flash space for the latest versions of all keys.
+     */
+    uint32_t getCapacity() const { return log.getPageCapacity(); }
+
+    /*!
+     * Get the number of pages erased by the garbage collection.
+     */
+    uint32_t getErases() const { return erases; }
+
+protected:
+    struct Entry {
+        uint32_t location;      // location of the latest version, FLASHKV_EMPTY if unused
+        uint16_t hash;
+        uint16_t size;          // flash space of the record
+    };
+
+    FlashStorage &storage;
+    FlashLog log;
+
+    Entry index[FLASHKV_INDEX_SIZE];
+    uint32_t count;
+    uint32_t liveBytes;
+    uint32_t erases;
+
+    // record buffers for the caller and the garbage collection, which may run during put()
+    uint8_t record[2 + FLASHKV_MAX_KEY_SIZE + FLASHKV_MAX_VALUE_SIZE];
+    uint8_t moved[2 + FLASHKV_MAX_KEY_SIZE + FLASHKV_MAX_VALUE_SIZE];
+
+    static uint16_t hash(const char *key, uint8_t keyLength);
+
+    bool find(const char *key, uint8_t keyLength, uint16_t keyHash, uint32_t &slot);
+
+    void removeSlot(uint32_t slot);
+
+    void clearIndex();
+
+    bool append(uint8_t *buffer, const char *key, uint8_t keyLength, uint8_t flags,
+                const uint8_t *value, uint16_t length, uint32_t &location);
+
+    static bool reclaim(void *context, uint32_t sequence, uint32_t location);
+};
+
+#endif //UBIRCH_MBED_NRF52_STORAGE_FLASHKV_H
@@ -0,0 +1,312 @@
+/*!
+ * @file
+ * @brief FlashLog.cpp
+ *
+ * Append-only log of variable length records on top of a flash storage.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#include "FlashLog.h"
+
+#define PRINTF(...)
+//#define PRINTF printf
+
+#define BLANK_WORD 0xFFFFFFFF
+
+FlashLog::FlashLog(FlashStorage &storage, uint8_t firstPage, uint8_t numPages)
+        : storage(storage), firstPage(firstPage), numPages(numPages), pageSize(storage.getPageSize()),
+          mounted(false), reclaiming(false), headPage(0), tailPage(0), tailOffset(0), sequence(0),
+          reclaimHandler(NULL), reclaimContext(NULL) {}
+
+bool FlashLog::mount() {
+    mounted = false;
+    if (numPages < 2 || storage.getEndAddress() - storage.getStartAddress() < pageLocation(numPages)) {
+        PRINTF("LOG invalid page range\r\n");
+        return false;
+    }
+
+    // the newest page has the highest sequence number, a torn header belongs to an
+    // interrupted rotation and is no candidate for the tail
+    bool found = false;
+    for (uint8_t page = 0; page < numPages; page++) {
+        bool valid;
+        uint32_t pageSequence;
+        if (!readHeader(page, valid, pageSequence)) return false;
+        if (valid && (!found || pageSequence > sequence)) {
+            found = true;
+            tailPage = page;
+            sequence = pageSequence;
+        }
+    }
+    if (!found) {
+        PRINTF("LOG no log found, formatting\r\n");
+        return format();
+    }
+
+    // the older pages precede it with consecutive sequence numbers
+    headPage = tailPage;
+    for (uint8_t i = 1; i < numPages; i++) {
+        const uint8_t page = (uint8_t) ((tailPage + numPages - i) % numPages);
+        bool valid;
+        uint32_t pageSequence;
+        if (!readHeader(page, valid, pageSequence)) return false;
+        if (!valid || pageSequence != sequence - i) break;
+        headPage = page;
+    }
+
+    // all other pages have to be erased, they may contain an interrupted erase, the torn
+    // header of an interrupted rotation or a stale page
+    for (uint8_t page = (uint8_t) ((tailPage + 1) % numPages); page != headPage;
+         page = (uint8_t) ((page + 1) % numPages)) {
+        if (!storage.isErased(pageLocation(page), pageSize)) {
+            PRINTF("LOG erasing stale page %u\r\n", page);
+            if (!storage.erasePage((uint8_t) (firstPage + page), 1)) return false;
+        }
+    }
+
+    tailOffset = scanPage(tailPage);
+    mounted = true;
+    PRINTF("LOG mounted pages %u-%u, tail at 0x%04x\r\n", headPage, tailPage, tailOffset);
+    return true;
+}
+
+bool FlashLog::format() {
+    mounted = false;
+    if (numPages < 2 || !storage.erasePage(firstPage, numPages)) {
+        return false;
+    }
+    headPage = 0;
+    mounted = startPage(0, sequence + 1);
+    return mounted;
+}
+
+bool FlashLog::append(const uint8_t *data, uint16_t length, uint32_t *p_location) {
+    if (!mounted || data == NULL || length == 0 || length > getMaxRecordSize()) {
+        return false;
+    }
+
+    // a rotation was interrupted by a reset, finish it while the tail page has room
+    if (usedPages() == numPages && !reclaiming && !reclaim()) {
+        return false;
+    }
+
+    // records moved by the reclaim handler may fill the new page again, give up
+    // once every page has been reclaimed without making room
+    const uint32_t size = getRecordSize(length);
+    for (uint8_t rotations = 0; tailOffset + size > pageSize; rotations++) {
+        if (rotations == numPages || !rotate()) return false;
+    }
+
+    // the header is written first, an interrupted write leaves a record with a bad CRC
+    const uint32_t location = pageLocation(tailPage) + tailOffset;
+    const uint32_t header = length | ((uint32_t) crc16(data, length) << 16);
+    if (!storage.programData(location, (const uint8_t *) &header, FLASHLOG_RECORD_HEADER_SIZE)) {
+        return false;
+    }
+    tailOffset += size;
+    if (!storage.programData(location + FLASHLOG_RECORD_HEADER_SIZE, data, length)) {
+        return false;
+    }
+
+    if (p_location) *p_location = location;
+    return true;
+}
+
+FlashLogCursor FlashLog::begin() const {
+    FlashLogCursor cursor = {getHeadSequence(), FLASHLOG_PAGE_HEADER_SIZE};
+    return cursor;
+}
+
+bool FlashLog::next(FlashLogCursor &cursor, uint8_t *buffer, uint16_t size, uint16_t &length,
+                    uint32_t *p_location) {
+    length = 0;
+    if (!mounted) {
+        return false;
+    }
+
+    while (true) {
+        // the page has been reclaimed, continue with the oldest record
+        if (cursor.sequence < getHeadSequence()) {
+            cursor = begin();
+        }
+        if (cursor.sequence > sequence) {
+            return false;
+        }
+
+        const uint8_t page = (uint8_t) ((headPage + cursor.sequence - getHeadSequence()) % numPages);
+        const uint32_t end = cursor.sequence == sequence ? tailOffset : pageSize;
+        uint32_t header = BLANK_WORD;
+        if (cursor.offset + FLASHLOG_RECORD_HEADER_SIZE <= end &&
+            !storage.readData(pageLocation(page) + cursor.offset, (uint8_t *) &header, sizeof(header))) {
+            return false;
+        }
+
+        const uint16_t recordLength = (uint16_t) (header & 0xFFFF);
+        if (header == BLANK_WORD || recordLength == 0 || cursor.offset + getRecordSize(recordLength) > end) {
+            // end of the page
+            if (cursor.sequence == sequence) {
+                return false;
+            }
+            cursor.sequence++;
+            cursor.offset = FLASHLOG_PAGE_HEADER_SIZE;
+            continue;
+        }
+
+        if (recordLength > size) {
+            length = recordLength;
+            return false;
+        }
+
+        const uint32_t location = pageLocation(page) + cursor.offset;
+        if (!storage.readData(location + FLASHLOG_RECORD_HEADER_SIZE, buffer, recordLength)) {
+            return false;
+        }
+        cursor.offset += getRecordSize(recordLength);
+
+        if (crc16(buffer, recordLength) != (header >> 16)) {
+            PRINTF("LOG skipping record with bad CRC at 0x%08x\r\n", location);
+            continue;
+        }
+
+        length = recordLength;
+        if (p_location) *p_location = location;
+        return true;
+    }
+}
+
+bool FlashLog::readRecord(uint32_t location, uint8_t *buffer, uint16_t size, uint16_t &length) {
+    length = 0;
+    if (location < pageLocation(0) || location >= pageLocation(numPages)) {
+        return false;
+    }
+    const uint32_t offset = (location - pageLocation(0)) % pageSize;
+    if (offset < FLASHLOG_PAGE_HEADER_SIZE || offset + FLASHLOG_RECORD_HEADER_SIZE > pageSize) {
+        return false;
+    }
+
+    uint32_t header;
+    if (!storage.readData(location, (uint8_t *) &header, sizeof(header))) {
+        return false;
+    }
+    const uint16_t recordLength = (uint16_t) (header & 0xFFFF);
+    if (header == BLANK_WORD || recordLength == 0 || offset + getRecordSize(recordLength) > pageSize) {
+        return false;
+    }
+
+    length = recordLength;
+    return recordLength <= size
+           && storage.readData(location + FLASHLOG_RECORD_HEADER_SIZE, buffer, recordLength)
+           && crc16(buffer, recordLength) == (header >> 16);
+}
+
+void FlashLog::setReclaimHandler(FlashLogReclaimHandler handler, void *context) {
+    reclaimHandler = handler;
+    reclaimContext = context;
+}
+
+uint16_t FlashLog::getMaxRecordSize() const {
+    // a length of 0xFFFF could result in a blank header
+    const uint32_t max = pageSize - FLASHLOG_PAGE_HEADER_SIZE - FLASHLOG_RECORD_HEADER_SIZE;
+    return (uint16_t) (max < 0xFFFE ? max : 0xFFFE);
+}
+
+uint16_t FlashLog::crc16(const uint8_t *data, uint32_t length, uint16_t crc) {
+    for (uint32_t i = 0; i < length; i++) {
+        crc = (uint16_t) ((crc >> 8) | (crc << 8));
+        crc ^= data[i];
+        crc ^= (uint16_t) ((crc & 0xFF) >> 4);
+        crc ^= (uint16_t) (crc << 12);
+        crc ^= (uint16_t) ((crc & 0xFF) << 5);
+    }
+    return crc;
+}
+
+bool FlashLog::readHeader(uint8_t page, bool &valid, uint32_t &pageSequence) {
+    uint32_t header[3];
+    if (!storage.readData(pageLocation(page), (uint8_t *) header, sizeof(header))) {
+        return false;
+    }
+    // the complement is programmed last, it only matches a completely programmed header
+    valid = header[0] == FLASHLOG_MAGIC && header[1] != BLANK_WORD && header[2] == ~header[1];
+    pageSequence = header[1];
+    return true;
+}
+
+bool FlashLog::startPage(uint8_t page, uint32_t pageSequence) {
+    const uint32_t header[3] = {FLASHLOG_MAGIC, pageSequence, ~pageSequence};
+    if (!storage.programData(pageLocation(page), (const uint8_t *) header, sizeof(header))) {
+        return false;
+    }
+    tailPage = page;
+    tailOffset = FLASHLOG_PAGE_HEADER_SIZE;
+    sequence = pageSequence;
+    return true;
+}
+
+bool FlashLog::reclaim() {
+    PRINTF("LOG reclaiming page %u\r\n", headPage);
+    if (reclaimHandler) {
+        reclaiming = true;
+        const bool reclaimed = reclaimHandler(reclaimContext, getHeadSequence(), pageLocation(headPage));
+        reclaiming = false;
+        if (!reclaimed) {
+            PRINTF("LOG page %u not reclaimed\r\n", headPage);
+            return false;
+        }
+    }
+    if (!storage.erasePage((uint8_t) (firstPage + headPage), 1)) {
+        return false;
+    }
+    headPage = (uint8_t) ((headPage + 1) % numPages);
+    return true;
+}
+
+bool FlashLog::rotate() {
+    // records appended while reclaiming have to fit into the tail page
+    if (reclaiming) {
+        return false;
+    }
+
+    if (!startPage((uint8_t) ((tailPage + 1) % numPages), sequence + 1)) {
+        return false;
+    }
+
+    // keep one erased page ahead of the tail
+    return usedPages() < numPages || reclaim();
+}
+
+uint32_t FlashLog::scanPage(uint8_t page) {
+    uint32_t offset = FLASHLOG_PAGE_HEADER_SIZE;
+    while (offset + FLASHLOG_RECORD_HEADER_SIZE <= pageSize) {
+        uint32_t header;
+        if (!storage.readData(pageLocation(page) + offset, (uint8_t *) &header, sizeof(header))) {
+            return pageSize;
+        }
+        if (header == BLANK_WORD) {
+            break;
+        }
+        const uint16_t recordLength = (uint16_t) (header & 0xFFFF);
+        if (recordLength == 0 || offset + getRecordSize(recordLength) > pageSize) {
+            // a corrupted header, do not append to this page anymore
+            return pageSize;
+        }
+        offset += getRecordSize(recordLength);
+    }
+    return offset;
+}
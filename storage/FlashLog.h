@@ -0,0 +1,226 @@
+/*!
+ * @file
+ * @brief FlashLog.h
+ *
+ * Append-only log of variable length records on top of a flash storage.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#ifndef UBIRCH_MBED_NRF52_STORAGE_FLASHLOG_H
+#define UBIRCH_MBED_NRF52_STORAGE_FLASHLOG_H
+
+#include "FlashStorage.h"
+
+// marks a page that belongs to a log ("FLOG")
+#define FLASHLOG_MAGIC 0x474F4C46
+
+// size of the page header (magic, sequence number, inverted sequence number)
+#define FLASHLOG_PAGE_HEADER_SIZE 12
+
+// size of the record header (length, crc16)
+#define FLASHLOG_RECORD_HEADER_SIZE 4
+
+/**
+ * Position in the log, used to iterate over the records.
+ */
+struct FlashLogCursor {
+    uint32_t sequence;          //!< sequence number of the page
+    uint32_t offset;            //!< offset of the next record in the page
+};
+
+/**
+ * Called before the oldest page of the log is erased.
+ *
+ * @param context   context given to setReclaimHandler()
+ * @param sequence  sequence number of the page, its records can still be read with next()
+ * @param location  storage location of the page
+ *
+ * @return true, if the page may be erased
+ */
+typedef bool (*FlashLogReclaimHandler)(void *context, uint32_t sequence, uint32_t location);
+
+/**
+ * Append-only record log.
+ *
+ * The log uses a range of pages of the storage as a ring. Every page starts with
+ * a header containing a magic word, a sequence number and its complement, followed
+ * by the records. A header torn by a reset fails the complement check.
+ * A record is a header word (length in the lower, crc16 of the data in the upper
+ * half word) followed by the data, padded to whole words.
+ *
+ * The log keeps track of its tail, so appending needs no blank check and no scan.
+ * One page ahead of the tail is always kept erased. If the log runs full, the
+ * oldest page is handed to the reclaim handler and erased.
+ *
+ * mount() recovers the log after a reset: it reads the page headers and walks the
+ * record headers of the newest page only, so recovery is bounded by the size of
+ * a page. A record that was interrupted while writing fails its CRC and is skipped,
+ * a page with an invalid header is an interrupted rotation and belongs to no log.
+ */
+class FlashLog {
+
+public:
+
+    /*!
+     * @brief   Constructor
+     *
+     * @param storage       the underlying storage
+     * @param firstPage     first page of the storage used by the log
+     * @param numPages      number of pages used by the log (at least 2)
+     */
+    FlashLog(FlashStorage &storage, uint8_t firstPage, uint8_t numPages);
+
+    /*!
+     * Recover the log from the flash. An empty storage is formatted.
+     *
+     * @return true, if the log is ready to use
+     */
+    bool mount();
+
+    /*!
+     * Erase all pages of the log and start an empty log.
+     *
+     * @return true, if the log is ready to use
+     */
+    bool format();
+
+    /*!
+     * Append a record.
+     *
+     * @param data          record data
+     * @param length        length of the record, 1 to getMaxRecordSize()
+     * @param p_location    if not NULL, receives the storage location of the record
+     *
+     * @return true, if the record has been stored
+     */
+    bool append(const uint8_t *data, uint16_t length, uint32_t *p_location = NULL);
+
+    /*!
+     * Get a cursor pointing to the oldest record.
+     */
+    FlashLogCursor begin() const;
+
+    /*!
+     * Read the record at the cursor and advance the cursor. Records with a bad
+     * CRC are skipped. If the cursor points to a reclaimed page, it continues
+     * with the oldest record.
+     *
+     * @param cursor        the position in the log
+     * @param buffer        buffer for the record data
+     * @param size          size of the buffer
+     * @param length        receives the length of the record, 0 at the end of the log
+     * @param p_location    if not NULL, receives the storage location of the record
+     *
+     * @return true, if a record has been read, false at the end of the log or if
+     *         the buffer is too small (the cursor is not advanced then)
+     */
+    bool next(FlashLogCursor &cursor, uint8_t *buffer, uint16_t size, uint16_t &length,
+              uint32_t *p_location = NULL);
+
+    /*!
+     * Read the record at a location returned by append() or next().
+     *
+     * @param location      storage location of the record
+     * @param buffer        buffer for the record data
+     * @param size          size of the buffer
+     * @param length        receives the length of the record
+     *
+     * @return true, if the record is valid and fits into the buffer
+     */
+    bool readRecord(uint32_t location, uint8_t *buffer, uint16_t size, uint16_t &length);
+
+    /*!
+     * Set the handler called before the oldest page is erased. Records appended
+     * by the handler must fit into the newest page.
+     */
+    void setReclaimHandler(FlashLogReclaimHandler handler, void *context);
+
+    /*!
+     * Get the maximum length of a record.
+     */
+    uint16_t getMaxRecordSize() const;
+
+    /*!
+     * Get the number of bytes available for records in a page.
+     */
+    uint32_t getPageCapacity() const { return pageSize - FLASHLOG_PAGE_HEADER_SIZE; }
+
+    /*!
+     * Get the flash space used by a record, including its header and padding.
+     */
+    static uint32_t getRecordSize(uint16_t length) {
+        return FLASHLOG_RECORD_HEADER_SIZE + (((uint32_t) length + 3) & ~3U);
+    }
+
+    /*!
+     * Get the number of bytes that can be appended before the next page is started.
+     */
+    uint32_t getTailFree() const { return pageSize - tailOffset; }
+
+    /*!
+     * Get the sequence number of the oldest page.
+     */
+    uint32_t getHeadSequence() const { return sequence - usedPages() + 1; }
+
+    /*!
+     * Get the sequence number of the newest page.
+     */
+    uint32_t getTailSequence() const { return sequence; }
+
+    /*!
+     * Calculate the CRC-16/CCITT of the data.
+     *
+     * @param data      data
+     * @param length    length of the data
+     * @param crc       initial value or the CRC of the preceding data
+     */
+    static uint16_t crc16(const uint8_t *data, uint32_t length, uint16_t crc = 0xFFFF);
+
+protected:
+    FlashStorage &storage;
+    uint8_t firstPage;
+    uint8_t numPages;
+    uint32_t pageSize;
+
+    bool mounted;
+    bool reclaiming;
+    uint8_t headPage;           // oldest page
+    uint8_t tailPage;           // page the records are appended to
+    uint32_t tailOffset;        // offset of the next record in the tail page
+    uint32_t sequence;          // sequence number of the tail page
+
+    FlashLogReclaimHandler reclaimHandler;
+    void *reclaimContext;
+
+    uint32_t pageLocation(uint8_t page) const { return (firstPage + page) * pageSize; }
+
+    uint32_t usedPages() const { return (uint32_t) ((tailPage + numPages - headPage) % numPages) + 1; }
+
+    bool readHeader(uint8_t page, bool &valid, uint32_t &pageSequence);
+
+    bool startPage(uint8_t page, uint32_t pageSequence);
+
+    bool reclaim();
+
+    bool rotate();
+
+    uint32_t scanPage(uint8_t page);
+};
+
+#endif //UBIRCH_MBED_NRF52_STORAGE_FLASHLOG_H
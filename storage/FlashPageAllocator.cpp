@@ -0,0 +1,146 @@
+/*!
+ * @file
+ * @brief FlashPageAllocator.cpp
+ *
+ * Wear-aware allocation of flash pages with persistent erase counters.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#include "FlashPageAllocator.h"
+
+#define PRINTF(...)
+//#define PRINTF printf
+
+#define MARKER_FREE 0xFFFFFFFF
+#define MARKER_ALLOCATED 0x00000000
+
+FlashPageAllocator::FlashPageAllocator(FlashStorage &storage, uint8_t firstPage, uint8_t numPages)
+        : storage(storage), firstPage(firstPage), numPages(numPages), pageSize(storage.getPageSize()) {}
+
+bool FlashPageAllocator::mount() {
+    uint32_t maxCount = 0;
+    for (uint8_t page = firstPage; page < firstPage + numPages; page++) {
+        uint32_t count;
+        if (getEraseCount(page, count) && count > maxCount) maxCount = count;
+    }
+
+    for (uint8_t page = firstPage; page < firstPage + numPages; page++) {
+        uint32_t header[3];
+        if (!readHeader(page, header)) {
+            return false;
+        }
+        if (header[0] == FLASHWEAR_MAGIC) {
+            continue;
+        }
+
+        PRINTF("WEAR page %u has no header\r\n", page);
+        if (storage.isErased(page * pageSize, pageSize)) {
+            // the erase has been done, only the header is missing
+            const uint32_t newHeader[3] = {FLASHWEAR_MAGIC, maxCount, MARKER_FREE};
+            if (!storage.programData(page * pageSize, (const uint8_t *) newHeader, sizeof(newHeader))) {
+                return false;
+            }
+        } else if (!erase(page, maxCount + 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool FlashPageAllocator::allocateFreshPage(uint8_t &page) {
+    bool found = false;
+    uint32_t minCount = 0;
+    for (uint8_t candidate = firstPage; candidate < firstPage + numPages; candidate++) {
+        uint32_t header[3];
+        if (!readHeader(candidate, header) || header[0] != FLASHWEAR_MAGIC || header[2] != MARKER_FREE) {
+            continue;
+        }
+        if (!found || header[1] < minCount) {
+            found = true;
+            minCount = header[1];
+            page = candidate;
+        }
+    }
+    if (!found) {
+        PRINTF("WEAR no free page\r\n");
+        return false;
+    }
+
+    // clearing the bits of the marker needs no erase
+    const uint32_t marker = MARKER_ALLOCATED;
+    return storage.programData(page * pageSize + 2 * sizeof(uint32_t), (const uint8_t *) &marker, sizeof(marker));
+}
+
+bool FlashPageAllocator::freePage(uint8_t page) {
+    uint32_t count;
+    if (!getEraseCount(page, count)) {
+        return false;
+    }
+    return erase(page, count + 1);
+}
+
+bool FlashPageAllocator::isAllocated(uint8_t page) {
+    uint32_t header[3];
+    return readHeader(page, header) && header[0] == FLASHWEAR_MAGIC && header[2] != MARKER_FREE;
+}
+
+bool FlashPageAllocator::getEraseCount(uint8_t page, uint32_t &count) {
+    uint32_t header[3];
+    if (!readHeader(page, header) || header[0] != FLASHWEAR_MAGIC) {
+        return false;
+    }
+    count = header[1];
+    return true;
+}
+
+bool FlashPageAllocator::getHealth(FlashWearHealth &health) {
+    uint64_t total = 0;
+    health.minErases = 0xFFFFFFFF;
+    health.maxErases = 0;
+    for (uint8_t page = firstPage; page < firstPage + numPages; page++) {
+        uint32_t count;
+        if (!getEraseCount(page, count)) {
+            return false;
+        }
+        if (count < health.minErases) health.minErases = count;
+        if (count > health.maxErases) health.maxErases = count;
+        total += count;
+    }
+
+    const uint64_t rated = (uint64_t) FLASH_ENDURANCE_CYCLES * numPages;
+    health.meanErases = numPages ? (uint32_t) (total / numPages) : 0;
+    health.remainingCycles = health.maxErases < FLASH_ENDURANCE_CYCLES ?
+                             FLASH_ENDURANCE_CYCLES - health.maxErases : 0;
+    health.projectedCycles = total < rated ? (uint32_t) (rated - total) : 0;
+    return numPages > 0;
+}
+
+bool FlashPageAllocator::readHeader(uint8_t page, uint32_t *header) {
+    if (page < firstPage || page >= firstPage + numPages) {
+        return false;
+    }
+    return storage.readData(page * pageSize, (uint8_t *) header, 3 * sizeof(uint32_t));
+}
+
+bool FlashPageAllocator::erase(uint8_t page, uint32_t count) {
+    // a reset between erase and header is detected by mount()
+    const uint32_t header[3] = {FLASHWEAR_MAGIC, count, MARKER_FREE};
+    return storage.erasePage(page, 1)
+           && storage.programData(page * pageSize, (const uint8_t *) header, sizeof(header));
+}
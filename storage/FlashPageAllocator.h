@@ -0,0 +1,146 @@
+/*!
+ * @file
+ * @brief FlashPageAllocator.h
+ *
+ * Wear-aware allocation of flash pages with persistent erase counters.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#ifndef UBIRCH_MBED_NRF52_STORAGE_FLASHPAGEALLOCATOR_H
+#define UBIRCH_MBED_NRF52_STORAGE_FLASHPAGEALLOCATOR_H
+
+#include "FlashStorage.h"
+
+// rated erase cycles of a page (nRF52832 endurance, 10 000 write/erase cycles)
+#ifndef FLASH_ENDURANCE_CYCLES
+#define FLASH_ENDURANCE_CYCLES 10000
+#endif
+
+// marks a page managed by the allocator ("FWEA")
+#define FLASHWEAR_MAGIC 0x41455746
+
+// size of the page header (magic, erase count, allocation marker)
+#define FLASHWEAR_HEADER_SIZE 12
+
+/**
+ * Wear statistics of the pages of an allocator.
+ */
+struct FlashWearHealth {
+    uint32_t minErases;         //!< erase count of the least worn page
+    uint32_t maxErases;         //!< erase count of the most worn page
+    uint32_t meanErases;        //!< mean erase count
+    uint32_t remainingCycles;   //!< erases left on the most worn page until the rated endurance
+    uint32_t projectedCycles;   //!< erases left on all pages, if the wear stays leveled
+};
+
+/**
+ * Wear-aware page allocator.
+ *
+ * Every page starts with a header containing a magic word, the number of times
+ * the page has been erased and an allocation marker. The header is written right
+ * after each erase, so the erase counters survive a reset. allocateFreshPage()
+ * hands out the erased page with the lowest erase count, freePage() erases the
+ * page and returns it to the pool.
+ *
+ * The data of an allocated page starts at getDataLocation().
+ */
+class FlashPageAllocator {
+
+public:
+
+    /*!
+     * @brief   Constructor
+     *
+     * @param storage       the underlying storage
+     * @param firstPage     first page of the storage managed by the allocator
+     * @param numPages      number of pages managed by the allocator
+     */
+    FlashPageAllocator(FlashStorage &storage, uint8_t firstPage, uint8_t numPages);
+
+    /*!
+     * Check the page headers. Pages without a valid header (never managed or an
+     * erase interrupted by a reset) are erased and get the highest erase count
+     * of all pages, so their wear is not underestimated.
+     *
+     * @return true, if all pages have a valid header
+     */
+    bool mount();
+
+    /*!
+     * Allocate the least worn free page.
+     *
+     * @param page      receives the storage page number
+     *
+     * @return true, if a page has been allocated, false if there is no free page
+     */
+    bool allocateFreshPage(uint8_t &page);
+
+    /*!
+     * Erase an allocated page and return it to the pool.
+     *
+     * @param page      storage page number
+     *
+     * @return true, if the page has been erased
+     */
+    bool freePage(uint8_t page);
+
+    /*!
+     * Check, if a page is allocated.
+     */
+    bool isAllocated(uint8_t page);
+
+    /*!
+     * Get the number of times a page has been erased.
+     *
+     * @param page      storage page number
+     * @param count     receives the erase count
+     *
+     * @return true, if the page has a valid header
+     */
+    bool getEraseCount(uint8_t page, uint32_t &count);
+
+    /*!
+     * Get the wear statistics of all pages.
+     *
+     * @return true, if all pages have a valid header
+     */
+    bool getHealth(FlashWearHealth &health);
+
+    /*!
+     * Get the storage location of the data area of a page.
+     */
+    uint32_t getDataLocation(uint8_t page) const { return page * pageSize + FLASHWEAR_HEADER_SIZE; }
+
+    /*!
+     * Get the size of the data area of a page.
+     */
+    uint32_t getDataSize() const { return pageSize - FLASHWEAR_HEADER_SIZE; }
+
+protected:
+    FlashStorage &storage;
+    uint8_t firstPage;
+    uint8_t numPages;
+    uint32_t pageSize;
+
+    bool readHeader(uint8_t page, uint32_t *header);
+
+    bool erase(uint8_t page, uint32_t count);
+};
+
+#endif //UBIRCH_MBED_NRF52_STORAGE_FLASHPAGEALLOCATOR_H
@@ -0,0 +1,337 @@
+/*!
+ * @file
+ * @brief FlashRingBuffer.cpp
+ *
+ * Circular FIFO of entries with logarithmic recovery.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#include "FlashRingBuffer.h"
+#include "FlashLog.h"
+
+#define PRINTF(...)
+//#define PRINTF printf
+
+#define BLANK_WORD 0xFFFFFFFF
+
+// first word of a slot: length in the lower half word (0 for a continuation), crc in bits 16..30
+// and the pending bit, cleared when the entry is consumed; a length below 0xFFFF keeps it from being blank
+#define SLOT_PENDING 0x80000000
+#define SLOT_CONTINUATION 0xFFFF0000
+#define SLOT_LENGTH(word) ((word) & 0xFFFF)
+#define SLOT_CRC(word) (((word) >> 16) & 0x7FFF)
+
+FlashRingBuffer::FlashRingBuffer(FlashStorage &storage, uint8_t firstPage, uint8_t numPages, uint16_t slotSize)
+        : storage(storage), firstPage(firstPage), numPages(numPages), pageSize(storage.getPageSize()),
+          slotSize(slotSize), slotsPerPage(0), mounted(false), headPage(0), tailPage(0), tailSlot(0),
+          readPage(0), readSlot(0), sequence(0), droppedPages(0), peekSlots(0) {
+    if (slotSize >= 8 && (slotSize & 3) == 0 && pageSize > FLASHRING_PAGE_HEADER_SIZE) {
+        slotsPerPage = (pageSize - FLASHRING_PAGE_HEADER_SIZE) / slotSize;
+    }
+}
+
+bool FlashRingBuffer::mount() {
+    mounted = false;
+    peekSlots = 0;
+    if (numPages < 2 || slotsPerPage == 0 ||
+        storage.getEndAddress() - storage.getStartAddress() < (firstPage + numPages) * pageSize) {
+        PRINTF("RING invalid page range or slot size\r\n");
+        return false;
+    }
+
+    // pages are written in ring order, the pages from the first one to the tail have
+    // sequence numbers of at least the one of the first page, the others lower ones or none
+    const uint32_t first = pageSequence(0);
+    if (first == 0) {
+        // the erase of the first page at a wrap may have been interrupted
+        if (pageSequence((uint8_t) (numPages - 1)) == 0) {
+            PRINTF("RING no pages found, formatting\r\n");
+            return format();
+        }
+        tailPage = (uint8_t) (numPages - 1);
+    } else {
+        uint32_t low = 0;
+        uint32_t high = numPages;
+        while (high - low > 1) {
+            const uint32_t mid = (low + high) / 2;
+            if (pageSequence((uint8_t) mid) >= first) {
+                low = mid;
+            } else {
+                high = mid;
+            }
+        }
+        tailPage = (uint8_t) low;
+    }
+    sequence = pageSequence(tailPage);
+
+    // the oldest page follows the tail, unless it has been erased at a wrap or the ring never wrapped
+    headPage = nextPage(tailPage);
+    if (pageSequence(headPage) == 0) {
+        headPage = nextPage(headPage);
+        if (pageSequence(headPage) == 0) headPage = 0;
+    }
+    tailSlot = usedSlots(tailPage);
+
+    // the pages starting with a consumed entry are a prefix of the pages from the head to the tail
+    const uint32_t pages = (tailPage + numPages - headPage) % numPages + 1;
+    uint32_t low = 0;
+    uint32_t high = pages;
+    while (low < high) {
+        const uint32_t mid = (low + high) / 2;
+        if (isConsumed((uint8_t) ((headPage + mid) % numPages), 0)) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    readPage = headPage;
+    readSlot = 0;
+    if (low > 0) {
+        readPage = (uint8_t) ((headPage + low - 1) % numPages);
+        const uint32_t used = readPage == tailPage ? tailSlot : usedSlots(readPage);
+        readSlot = consumedSlots(readPage, used);
+        if (readSlot >= used && readPage != tailPage) {
+            readPage = nextPage(readPage);
+            readSlot = 0;
+        }
+    }
+
+    mounted = true;
+    PRINTF("RING mounted head %u, read %u:%u, tail %u:%u, sequence %u\r\n",
+           headPage, readPage, readSlot, tailPage, tailSlot, sequence);
+    return true;
+}
+
+bool FlashRingBuffer::format() {
+    mounted = false;
+    peekSlots = 0;
+    const uint32_t header[2] = {FLASHRING_MAGIC, 1};
+    if (numPages < 2 || slotsPerPage == 0 || !storage.erasePage(firstPage, numPages) ||
+        !storage.programData(pageLocation(0), (const uint8_t *) header, sizeof(header))) {
+        return false;
+    }
+    headPage = tailPage = readPage = 0;
+    tailSlot = readSlot = 0;
+    sequence = 1;
+    mounted = true;
+    return true;
+}
+
+bool FlashRingBuffer::push(const uint8_t *data, uint16_t length) {
+    if (!mounted || data == NULL || length == 0 || length > getMaxEntrySize()) {
+        return false;
+    }
+    const uint32_t payload = slotSize - 4;
+    const uint32_t slots = (length + payload - 1) / payload;
+    if (tailSlot + slots > slotsPerPage && !advance()) {
+        return false;
+    }
+
+    // the header is programmed before the data, the slots are used as soon as it is written
+    const uint32_t slot = tailSlot;
+    const uint32_t header = SLOT_PENDING | ((uint32_t) (FlashLog::crc16(data, length) & 0x7FFF) << 16) | length;
+    bool ok = storage.programData(slotLocation(tailPage, slot), (const uint8_t *) &header, sizeof(header));
+    if (!ok && readWord(slotLocation(tailPage, slot)) == BLANK_WORD) {
+        // nothing has been programmed, the slots stay free
+        return false;
+    }
+    tailSlot += slots;
+
+    // the continuation marks are programmed even if the data fails, so the used slots are
+    // never blank; the broken entry fails its CRC and is skipped by peek()
+    const uint32_t continuation = SLOT_CONTINUATION;
+    for (uint32_t i = 0; i < slots; i++) {
+        const uint32_t location = slotLocation(tailPage, slot + i);
+        const uint32_t offset = i * payload;
+        const uint32_t chunk = length - offset < payload ? length - offset : payload;
+        if (i > 0 && !storage.programData(location, (const uint8_t *) &continuation, sizeof(continuation))) {
+            ok = false;
+        }
+        if (ok && !storage.programData(location + 4, data + offset, chunk)) {
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+bool FlashRingBuffer::peek(uint8_t *buffer, uint16_t size, uint16_t &length) {
+    length = 0;
+    peekSlots = 0;
+    if (!mounted || buffer == NULL) {
+        return false;
+    }
+
+    const uint32_t payload = slotSize - 4;
+    while (!isEmpty()) {
+        const uint32_t word = readSlot < slotsPerPage ? readWord(slotLocation(readPage, readSlot)) : BLANK_WORD;
+        if (word == BLANK_WORD) {
+            // the rest of a page that did not fit the next entry
+            if (readPage == tailPage) break;
+            readPage = nextPage(readPage);
+            readSlot = 0;
+            continue;
+        }
+
+        // continuations of an entry torn by a reset or partly consumed are skipped
+        const uint32_t entryLength = SLOT_LENGTH(word);
+        uint32_t slots = entryLength == 0 ? 1 : (entryLength + payload - 1) / payload;
+        bool valid = entryLength != 0 && (word & SLOT_PENDING) && readSlot + slots <= slotsPerPage;
+        if (valid && entryLength > size) {
+            length = (uint16_t) entryLength;
+            return false;
+        }
+        for (uint32_t i = 0; valid && i < slots; i++) {
+            const uint32_t location = slotLocation(readPage, readSlot + i);
+            const uint32_t offset = i * payload;
+            const uint32_t chunk = entryLength - offset < payload ? entryLength - offset : payload;
+            if (i > 0 && (readWord(location) | SLOT_PENDING) != SLOT_CONTINUATION) {
+                // the entry has been torn, the next one starts here
+                slots = i;
+                valid = false;
+            } else if (!storage.readData(location + 4, buffer + offset, chunk)) {
+                return false;
+            }
+        }
+        if (valid && (FlashLog::crc16(buffer, entryLength) & 0x7FFF) == SLOT_CRC(word)) {
+            length = (uint16_t) entryLength;
+            peekSlots = slots;
+            return true;
+        }
+
+        // consume the broken entry, the consumed slots have to stay a prefix
+        PRINTF("RING skipping %u broken slots at %u:%u\r\n", slots, readPage, readSlot);
+        if (readSlot + slots > slotsPerPage) slots = slotsPerPage - readSlot;
+        markConsumed(slots);
+    }
+    return false;
+}
+
+bool FlashRingBuffer::pop(uint8_t *buffer, uint16_t size, uint16_t &length) {
+    return peek(buffer, size, length) && markConsumed(peekSlots);
+}
+
+bool FlashRingBuffer::consume() {
+    uint8_t buffer[64];
+    uint16_t length;
+    if (peek(buffer, sizeof(buffer), length)) {
+        return markConsumed(peekSlots);
+    }
+    // the entry did not fit into the buffer, consume it without reading it
+    if (length == 0) {
+        return false;
+    }
+    const uint32_t payload = slotSize - 4;
+    return markConsumed((length + payload - 1) / payload);
+}
+
+uint16_t FlashRingBuffer::getMaxEntrySize() const {
+    const uint32_t max = slotsPerPage * (slotSize - 4);
+    return (uint16_t) (max < 0xFFFE ? max : 0xFFFE);
+}
+
+uint32_t FlashRingBuffer::readWord(uint32_t location) {
+    uint32_t word;
+    if (!storage.readData(location, (uint8_t *) &word, sizeof(word))) {
+        return BLANK_WORD;
+    }
+    return word;
+}
+
+uint32_t FlashRingBuffer::pageSequence(uint8_t page) {
+    uint32_t header[2];
+    if (!storage.readData(pageLocation(page), (uint8_t *) header, sizeof(header)) ||
+        header[0] != FLASHRING_MAGIC || header[1] == BLANK_WORD) {
+        return 0;
+    }
+    return header[1];
+}
+
+uint32_t FlashRingBuffer::usedSlots(uint8_t page) {
+    // slots are used in order and the first word of a used slot is never blank
+    uint32_t low = 0;
+    uint32_t high = slotsPerPage;
+    while (low < high) {
+        const uint32_t mid = (low + high) / 2;
+        if (readWord(slotLocation(page, mid)) == BLANK_WORD) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return low;
+}
+
+uint32_t FlashRingBuffer::consumedSlots(uint8_t page, uint32_t used) {
+    // slots are consumed in order
+    uint32_t low = 0;
+    uint32_t high = used;
+    while (low < high) {
+        const uint32_t mid = (low + high) / 2;
+        if (isConsumed(page, mid)) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+bool FlashRingBuffer::isConsumed(uint8_t page, uint32_t slot) {
+    return (readWord(slotLocation(page, slot)) & SLOT_PENDING) == 0;
+}
+
+bool FlashRingBuffer::markConsumed(uint32_t slots) {
+    // programming clears the pending bit only, the other bits are programmed with 1s
+    const uint32_t consumed = ~SLOT_PENDING;
+    bool ok = true;
+    for (uint32_t i = 0; i < slots; i++) {
+        ok &= storage.programData(slotLocation(readPage, readSlot + i), (const uint8_t *) &consumed, sizeof(consumed));
+    }
+    readSlot += slots;
+    peekSlots = 0;
+    return ok;
+}
+
+bool FlashRingBuffer::advance() {
+    const uint8_t next = nextPage(tailPage);
+
+    // the oldest page is erased when the ring wraps, an interrupted erase is repeated
+    if (!storage.isErased(pageLocation(next), pageSize)) {
+        if (readPage == next && readSlot < slotsPerPage && readWord(slotLocation(next, readSlot)) != BLANK_WORD) {
+            droppedPages++;
+        }
+        if (!storage.erasePage((uint8_t) (firstPage + next), 1)) {
+            return false;
+        }
+        if (headPage == next) headPage = nextPage(next);
+        if (readPage == next) {
+            readPage = headPage;
+            readSlot = 0;
+        }
+    }
+
+    const uint32_t header[2] = {FLASHRING_MAGIC, sequence + 1};
+    if (!storage.programData(pageLocation(next), (const uint8_t *) header, sizeof(header))) {
+        return false;
+    }
+    tailPage = next;
+    tailSlot = 0;
+    sequence++;
+    return true;
+}
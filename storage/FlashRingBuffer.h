@@ -0,0 +1,200 @@
+/*!
+ * @file
+ * @brief FlashRingBuffer.h
+ *
+ * Circular FIFO of entries with logarithmic recovery.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#ifndef UBIRCH_MBED_NRF52_STORAGE_FLASHRINGBUFFER_H
+#define UBIRCH_MBED_NRF52_STORAGE_FLASHRINGBUFFER_H
+
+#include "FlashStorage.h"
+
+// marks a page that belongs to a ring buffer ("FRNG")
+#define FLASHRING_MAGIC 0x474E5246
+
+// size of the page header (magic, sequence number)
+#define FLASHRING_PAGE_HEADER_SIZE 8
+
+// default size of a slot, the unit entries are stored in
+#ifndef FLASHRING_SLOT_SIZE
+#define FLASHRING_SLOT_SIZE 32
+#endif
+
+/**
+ * FIFO of entries, e.g. sensor samples, in a ring of pages.
+ *
+ * Every page starts with a header containing a magic word and a sequence
+ * number, followed by slots of a fixed size. An entry takes one slot, or several
+ * consecutive slots of a page, if it is larger. The first word of every slot is
+ * never blank: the first slot of an entry holds the length and a CRC of the
+ * data, the others a continuation mark. Fixed-size entries waste no space with
+ * a slot size of the entry size plus 4 bytes.
+ *
+ * push() appends to the tail page and starts the next page when it is full.
+ * When the ring wraps, the oldest page is erased, even if it holds entries that
+ * have not been popped yet (see getDroppedPages()). pop() clears the pending bit
+ * in the first word of the slots of the head entry, so the entries are consumed
+ * in the flash as well.
+ *
+ * Pages are written in ring order with increasing sequence numbers, slots in
+ * order and consumed in order, so mount() recovers the tail and the head with
+ * binary searches: over the page sequence numbers, over the first words of the
+ * slots for the blank boundary and over the pending bits. Recovery reads
+ * O(log pages + log slots) words instead of scanning the storage.
+ *
+ * @code
+ * FlashRingBuffer samples(flashStorage, 0, STORAGE_PAGES, sizeof(sample) + 4);
+ *
+ * samples.mount();
+ * samples.push((const uint8_t *) &sample, sizeof(sample));
+ * while (samples.pop((uint8_t *) &sample, sizeof(sample), length)) send(sample);
+ * @endcode
+ */
+class FlashRingBuffer {
+
+public:
+
+    /*!
+     * @brief   Constructor
+     *
+     * @param storage       the underlying storage
+     * @param firstPage     first page of the storage used by the ring
+     * @param numPages      number of pages used by the ring (at least 2)
+     * @param slotSize      size of a slot in bytes, a multiple of 4 of at least 8
+     */
+    FlashRingBuffer(FlashStorage &storage, uint8_t firstPage, uint8_t numPages,
+                    uint16_t slotSize = FLASHRING_SLOT_SIZE);
+
+    /*!
+     * Recover the head and the tail from the flash. An empty storage is formatted.
+     *
+     * @return true, if the ring is ready to use
+     */
+    bool mount();
+
+    /*!
+     * Erase all pages of the ring and start an empty ring.
+     *
+     * @return true, if the ring is ready to use
+     */
+    bool format();
+
+    /*!
+     * Append an entry at the tail.
+     *
+     * @param data          entry data
+     * @param length        length of the entry, 1 to getMaxEntrySize()
+     *
+     * @return true, if the entry has been stored
+     */
+    bool push(const uint8_t *data, uint16_t length);
+
+    /*!
+     * Read the entry at the head without consuming it. Entries with a bad CRC
+     * are skipped and consumed.
+     *
+     * @param buffer        buffer for the entry data
+     * @param size          size of the buffer
+     * @param length        receives the length of the entry, 0 if the ring is empty
+     *
+     * @return true, if an entry has been read, false if the ring is empty or
+     *         the buffer is too small
+     */
+    bool peek(uint8_t *buffer, uint16_t size, uint16_t &length);
+
+    /*!
+     * Read and consume the entry at the head.
+     *
+     * @return true, if an entry has been read and consumed, see peek()
+     */
+    bool pop(uint8_t *buffer, uint16_t size, uint16_t &length);
+
+    /*!
+     * Consume the entry at the head without reading it.
+     *
+     * @return true, if an entry has been consumed
+     */
+    bool consume();
+
+    /*!
+     * Check, if all entries have been consumed.
+     */
+    bool isEmpty() const { return readPage == tailPage && readSlot >= tailSlot; }
+
+    /*!
+     * Get the maximum length of an entry, the slots of a page.
+     */
+    uint16_t getMaxEntrySize() const;
+
+    /*!
+     * Get the number of pages erased with entries that were not consumed.
+     */
+    uint32_t getDroppedPages() const { return droppedPages; }
+
+    /*!
+     * Get the sequence number of the tail page.
+     */
+    uint32_t getTailSequence() const { return sequence; }
+
+protected:
+    FlashStorage &storage;
+    uint8_t firstPage;
+    uint8_t numPages;
+    uint32_t pageSize;
+    uint32_t slotSize;
+    uint32_t slotsPerPage;
+
+    bool mounted;
+    uint8_t headPage;           // oldest page
+    uint8_t tailPage;           // page the entries are pushed to
+    uint32_t tailSlot;          // next free slot of the tail page
+    uint8_t readPage;           // page of the next entry to pop
+    uint32_t readSlot;          // slot of the next entry to pop
+    uint32_t sequence;          // sequence number of the tail page
+    uint32_t droppedPages;
+
+    // the entry found by peek()
+    uint32_t peekSlots;
+
+    uint32_t pageLocation(uint8_t page) const { return (firstPage + page) * pageSize; }
+
+    uint32_t slotLocation(uint8_t page, uint32_t slot) const {
+        return pageLocation(page) + FLASHRING_PAGE_HEADER_SIZE + slot * slotSize;
+    }
+
+    uint8_t nextPage(uint8_t page) const { return (uint8_t) ((page + 1) % numPages); }
+
+    uint32_t readWord(uint32_t location);
+
+    uint32_t pageSequence(uint8_t page);
+
+    uint32_t usedSlots(uint8_t page);
+
+    uint32_t consumedSlots(uint8_t page, uint32_t used);
+
+    bool isConsumed(uint8_t page, uint32_t slot);
+
+    bool markConsumed(uint32_t slots);
+
+    bool advance();
+};
+
+#endif //UBIRCH_MBED_NRF52_STORAGE_FLASHRINGBUFFER_H
@@ -33,15 +33,18 @@
  *  see documentation for mbed fstorage
  */
 
+#include <string.h>
 #include "FlashStorage.h"
-#include <nrf_soc.h>
 
-bool FlashStorage::conv8to32(const unsigned char *d8, uint32_t *d32, uint16_t length8){
+// shared by all storages, so callers do not need a page sized buffer on their stack
+static uint32_t pageBuffer[STORAGE_PAGE_BUFFER_WORDS];
+
+bool FlashStorage::conv8to32(const unsigned char *d8, uint32_t *d32, uint32_t length8){
     if (d8 == NULL || d32 == NULL || length8 == 0) {
         return false;
     }
 
-    for (int i = 0; i < (length8 >> 2); ++i) {
+    for (uint32_t i = 0; i < (length8 >> 2); ++i) {
         d32[i] = (uint32_t) ((d8[(i << 2) + 3] << 24) | (d8[(i << 2) + 2] << 16) | (d8[(i << 2) + 1] << 8) |
                              (d8[(i << 2)]));
     }
@@ -49,12 +52,12 @@ bool FlashStorage::conv8to32(const unsigned char *d8, uint32_t *d32, uint16_t le
 }
 
 
-bool FlashStorage::conv32to8(const uint32_t *d32, unsigned char *d8, uint16_t length8){
+bool FlashStorage::conv32to8(const uint32_t *d32, unsigned char *d8, uint32_t length8){
     if (d8 == NULL || d32 == NULL || length8 == 0) {
         return false;
     }
     uint32_t temp;                            // temporary data storage
-    for (uint16_t j = 0; j < (length8 >> 2); ++j) {
+    for (uint32_t j = 0; j < (length8 >> 2); ++j) {
         temp = d32[j];
         for (int i = 0; i < 4; ++i) {
             d8[(j << 2) + i] = (unsigned char) (temp & 0xFF);
@@ -63,3 +66,254 @@ bool FlashStorage::conv32to8(const uint32_t *d32, unsigned char *d8, uint16_t le
     }
     return true;
 }
+
+
+bool FlashStorage::programData(uint32_t p_location, const unsigned char *buffer, uint32_t length8) {
+    return writeData(p_location, buffer, length8);
+}
+
+
+bool FlashStorage::updateData(uint32_t p_location, const unsigned char *buffer, uint32_t length8) {
+    if (buffer == NULL || length8 == 0) {
+        return false;
+    }
+    const uint32_t size = getEndAddress() - getStartAddress();
+    if (p_location >= size || length8 > size - p_location) {
+        return false;
+    }
+
+    const uint32_t pageSize = getPageSize();
+    while (length8 > 0) {
+        uint32_t chunk = pageSize - p_location % pageSize;
+        if (chunk > length8) chunk = length8;
+        if (!updatePage(p_location, buffer, chunk)) {
+            return false;
+        }
+        p_location += chunk;
+        buffer += chunk;
+        length8 -= chunk;
+    }
+    return true;
+}
+
+
+bool FlashStorage::updatePage(uint32_t p_location, const unsigned char *buffer, uint32_t length8) {
+    // blank: program directly
+    if (isErased(p_location, length8)) {
+        return programData(p_location, buffer, length8);
+    }
+
+    const uint32_t pageSize = getPageSize();
+    if (pageSize > sizeof(pageBuffer)) {
+        return false;
+    }
+    const uint32_t pageStart = p_location - p_location % pageSize;
+    const uint32_t offset = p_location - pageStart;
+    uint8_t *page = (uint8_t *) pageBuffer;
+    if (!readData(pageStart, page, pageSize)) {
+        return false;
+    }
+
+    // only bits from 1 to 0: program in place
+    uint32_t index = 0;
+    while (index < length8 && (page[offset + index] & buffer[index]) == buffer[index]) index++;
+    if (index == length8) {
+        return programData(p_location, buffer, length8);
+    }
+
+    // erase the page and program it again, up to the last non-blank word
+    memcpy(page + offset, buffer, length8);
+    if (!erasePage((uint8_t) (pageStart / pageSize), 1)) {
+        return false;
+    }
+    uint32_t words = pageSize >> 2;
+    while (words > 0 && pageBuffer[words - 1] == 0xFFFFFFFF) words--;
+    return words == 0 || programData(pageStart, page, words << 2);
+}
+
+
+bool FlashStorage::writeDataAsync(uint32_t p_location, const unsigned char *buffer, uint32_t length8,
+                                  FlashStorageCallback callback, void *context) {
+    if (!writeData(p_location, buffer, length8)) {
+        return false;
+    }
+    if (callback != NULL) {
+        callback(context, FS_SUCCESS);
+    }
+    return true;
+}
+
+
+bool FlashStorage::erasePageAsync(uint8_t page, uint8_t numPages,
+                                  FlashStorageCallback callback, void *context) {
+    if (!erasePage(page, numPages)) {
+        return false;
+    }
+    if (callback != NULL) {
+        callback(context, FS_SUCCESS);
+    }
+    return true;
+}
+
+
+bool FlashStorage::waitUntil(bool (*met)(void *), void *context) {
+    if (met(context)) {
+        return true;
+    }
+    lastError = FS_ERR_OPERATION_TIMEOUT;
+    return false;
+}
+
+
+bool FlashStorage::eraseSlice(uint8_t page, bool &done) {
+    done = erasePage(page, 1);
+    return done;
+}
+
+
+const uint8_t *FlashStorage::map(uint32_t p_location, uint32_t length8) {
+    (void) p_location;
+    (void) length8;
+    return NULL;
+}
+
+
+uint32_t FlashStorage::getPageSize() {
+    return STORAGE_PAGE_SIZE;
+}
+
+
+uint32_t FlashStorage::findFirstNonBlank(uint32_t p_location, uint32_t length8) {
+    unsigned char buffer8[16];
+    for (uint32_t index = 0; index < length8; index += sizeof(buffer8)) {
+        uint32_t chunk = length8 - index < sizeof(buffer8) ? length8 - index : (uint32_t) sizeof(buffer8);
+        if (!readData(p_location + index, buffer8, chunk)) {
+            return index;
+        }
+        uint32_t offset = scanBlank(buffer8, chunk);
+        if (offset < chunk) {
+            return index + offset;
+        }
+    }
+    return length8;
+}
+
+
+uint32_t FlashStorage::scanBlank(const uint8_t *memory, uint32_t length8) {
+    const uint8_t *p = memory;
+    const uint8_t *end = memory + length8;
+
+    // bytes up to the first word boundary
+    while (p < end && ((uintptr_t) p & 0x03)) {
+        if (*p != 0xFF) return (uint32_t) (p - memory);
+        p++;
+    }
+
+    // whole words, four at a time and then one at a time
+    const uint32_t *p32 = (const uint32_t *) p;
+    const uint32_t words = (uint32_t) (end - p) >> 2;
+    const uint32_t *end32 = p32 + words;
+    while (end32 - p32 >= 4 && (p32[0] & p32[1] & p32[2] & p32[3]) == 0xFFFFFFFF) p32 += 4;
+    while (p32 < end32 && *p32 == 0xFFFFFFFF) p32++;
+
+    // the remaining bytes, including the exact position inside a non-blank word
+    p = (const uint8_t *) p32;
+    while (p < end) {
+        if (*p != 0xFF) return (uint32_t) (p - memory);
+        p++;
+    }
+    return length8;
+}
+
+
+uint32_t FlashStorage::compareMapped(const uint8_t *memory, const unsigned char *buffer, uint32_t length8) {
+    uint32_t index = 0;
+
+    // bytes up to the first word boundary of the memory
+    while (index < length8 && ((uintptr_t) (memory + index) & 0x03)) {
+        if (memory[index] != buffer[index]) return index;
+        index++;
+    }
+
+    // whole words, the data is loaded bytewise if it is not aligned like the memory
+    const uint32_t *p32 = (const uint32_t *) (memory + index);
+    if (!((uintptr_t) (buffer + index) & 0x03)) {
+        const uint32_t *s32 = (const uint32_t *) (buffer + index);
+        while (length8 - index >= 4 && *p32 == *s32) {
+            p32++;
+            s32++;
+            index += 4;
+        }
+    } else {
+        uint32_t word;
+        while (length8 - index >= 4) {
+            memcpy(&word, buffer + index, sizeof(word));
+            if (*p32 != word) break;
+            p32++;
+            index += 4;
+        }
+    }
+
+    // the remaining bytes, including the exact position inside a differing word
+    while (index < length8) {
+        if (memory[index] != buffer[index]) return index;
+        index++;
+    }
+    return length8;
+}
+
+
+bool FlashStorage::verifyMapped(const uint8_t *memory, uint32_t address,
+                                const unsigned char *buffer, uint32_t length8) {
+    const uint32_t offset = compareMapped(memory, buffer, length8);
+    if (offset == length8) {
+        return true;
+    }
+    verifyFailure = address + offset;
+    lastError = FS_ERR_INTERNAL;
+    return false;
+}
+
+
+bool FlashStorage::verifyData(uint32_t p_location, const unsigned char *buffer, uint32_t length8) {
+    if (buffer == NULL || length8 == 0) {
+        return false;
+    }
+    const uint8_t *memory = map(p_location, length8);
+    if (memory != NULL) {
+        return verifyMapped(memory, getStartAddress() + p_location, buffer, length8);
+    }
+
+    // not mapped, compare in small pieces
+    unsigned char buffer8[16];
+    for (uint32_t index = 0; index < length8; index += sizeof(buffer8)) {
+        uint32_t chunk = length8 - index < sizeof(buffer8) ? length8 - index : (uint32_t) sizeof(buffer8);
+        if (!readData(p_location + index, buffer8, chunk) ||
+            !verifyMapped(buffer8, getStartAddress() + p_location + index, buffer + index, chunk)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+bool FlashStorage::getStats(FlashStorageStats &result, bool reset) {
+#if STORAGE_STATS
+    result = stats;
+    if (reset) {
+        resetStats();
+    }
+    return true;
+#else
+    (void) reset;
+    memset(&result, 0, sizeof(result));
+    return false;
+#endif
+}
+
+
+void FlashStorage::resetStats() {
+#if STORAGE_STATS
+    memset(&stats, 0, sizeof(stats));
+#endif
+}
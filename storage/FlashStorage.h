@@ -37,11 +37,84 @@
 #define UBIRCH_FLASH_STORAGE_H
 
 #include <cstdio>
+#include <stdint.h>
+#include "FlashTrace.h"
 
 extern "C" {
 #include <fstorage.h>
 }
 
+// size of the shared page buffer used by updateData(), at least one flash page
+#ifndef STORAGE_PAGE_BUFFER_WORDS
+#define STORAGE_PAGE_BUFFER_WORDS 1024
+#endif
+
+// page size of storages that do not override getPageSize(), a flash page of the nRF52
+#ifndef STORAGE_PAGE_SIZE
+#define STORAGE_PAGE_SIZE 4096
+#endif
+
+// collect operation statistics, readable with getStats(), set to 0 to compile them out
+#ifndef STORAGE_STATS
+#define STORAGE_STATS 1
+#endif
+
+// duration of one slice of eraseSlice() in ms, where the flash supports a partial page erase
+#ifndef STORAGE_ERASE_SLICE_MS
+#define STORAGE_ERASE_SLICE_MS 2
+#endif
+
+/**
+ * Operation statistics of one path to the flash (with or without softdevice).
+ */
+struct FlashStoragePathStats {
+    uint32_t reads;                 //!< number of read operations
+    uint32_t writes;                //!< number of write operations
+    uint32_t erases;                //!< number of pages erased
+    uint32_t bytesRead;             //!< number of bytes read
+    uint32_t bytesWritten;          //!< number of bytes written
+    uint32_t wordsProgrammed;       //!< number of words programmed, including padded words
+    uint32_t blankCheckFailures;    //!< writes refused, because the area was not blank
+    uint32_t waits;                 //!< number of times the caller was blocked waiting for the flash
+    uint32_t waitTimeUs;            //!< cumulative time blocked waiting for the flash
+    uint32_t maxWaitUs;             //!< longest time blocked waiting for the flash
+    uint32_t eraseSlices;           //!< number of erase slices, see eraseSlice()
+    uint32_t maxSliceUs;            //!< longest time blocked by one erase slice
+    uint32_t chunks;                //!< number of flash operations completed by fstorage
+    uint32_t chunkFailures;         //!< flash operations fstorage gave up on
+    uint32_t chunkTimeUs;           //!< cumulative time fstorage took for the operations
+    uint32_t maxChunkUs;            //!< longest time fstorage took for one operation
+    uint32_t verifyFailures;        //!< writes that did not read back as written, see setVerify()
+};
+
+/**
+ * Operation statistics of a storage.
+ */
+struct FlashStorageStats {
+    FlashStoragePathStats softdevice;   //!< operations through the softdevice
+    FlashStoragePathStats nosd;         //!< operations directly on the NVMC
+};
+
+#if STORAGE_STATS
+#define STORAGE_STATS_ADD(counter, value) ((counter) += (value))
+#define STORAGE_STATS_START(start) const uint32_t start = STORAGE_STATS_CLOCK_US()
+#define STORAGE_STATS_WAIT(path, start) FlashStorage::addWait(path, STORAGE_STATS_CLOCK_US() - (start))
+#define STORAGE_STATS_SLICE(path, start) FlashStorage::addSlice(path, STORAGE_STATS_CLOCK_US() - (start))
+#else
+#define STORAGE_STATS_ADD(counter, value) ((void) 0)
+#define STORAGE_STATS_START(start)
+#define STORAGE_STATS_WAIT(path, start) ((void) 0)
+#define STORAGE_STATS_SLICE(path, start) ((void) 0)
+#endif
+
+/**
+ * Completion callback of an asynchronous flash operation.
+ *
+ * @param context       the context given when the operation was started
+ * @param result        fstorage result of the operation, FS_SUCCESS if successful
+ */
+typedef void (*FlashStorageCallback)(void *context, fs_ret_t result);
+
 /**
  * A flash storage abstraction.
  */
@@ -52,7 +125,7 @@ public:
     /*!
      * @brief   Constructor
      */
-     FlashStorage() {};
+     FlashStorage() : lastError(FS_SUCCESS), verifyWrites(false), verifyFailure(0) { resetStats(); };
 
     virtual /*!
      * @brief   Destructor
@@ -79,7 +152,7 @@ public:
      *
      * @return int 			true, if reading successful, else false
      */
-    virtual bool readData(uint32_t p_location, unsigned char *buffer, uint16_t length8) = 0;
+    virtual bool readData(uint32_t p_location, unsigned char *buffer, uint32_t length8) = 0;
 
     /*!
      * Erase a page in the key storage
@@ -97,7 +170,136 @@ public:
      *
      * @return int 			true, if writing successful, else false
      */
-    virtual bool writeData(uint32_t p_location, const unsigned char *buffer, uint16_t length8) = 0;
+    virtual bool writeData(uint32_t p_location, const unsigned char *buffer, uint32_t length8) = 0;
+
+    /*!
+     * Program data into the key storage without checking that the area is blank.
+     * Flash can only change bits from 1 to 0, so programming over existing data
+     * results in the AND of the old and the new data. Use this if the caller
+     * knows the area is blank, e.g. the tail of a log.
+     *
+     * @note    the default implementation uses writeData(), including the blank check
+     *
+     * @param p_location 	location (pointer) inside the configured data space (32 Bit)
+     * @param *buffer		pointer to the buffer with the data (8 Bit)
+     * @param length8 		length of data elements to write (8 Bit)
+     *
+     * @return bool			true, if writing successful, else false
+     */
+    virtual bool programData(uint32_t p_location, const unsigned char *buffer, uint32_t length8);
+
+    /*!
+     * Change data in the key storage, regardless of what is stored there now.
+     * If the area is blank or the new data only clears bits (1 to 0), the data is
+     * programmed in place. Otherwise each affected page is copied to a shared RAM
+     * page buffer, erased and programmed again with the new data.
+     *
+     * @note    not reentrant, the page buffer is shared by all storages;
+     *          a reset during the erase and rewrite loses the page
+     *
+     * @param p_location 	location (pointer) inside the configured data space (32 Bit)
+     * @param *buffer		pointer to the buffer with the data (8 Bit)
+     * @param length8 		length of data elements to write (8 Bit)
+     *
+     * @return bool			true, if the data is stored, else false
+     */
+    bool updateData(uint32_t p_location, const unsigned char *buffer, uint32_t length8);
+
+    /*!
+     * Write data to the key storage without waiting for the flash operation to finish.
+     * The data is copied, so the buffer can be reused right away.
+     *
+     * @note    the default implementation writes synchronously and calls the callback before returning
+     *
+     * @param p_location 	location (pointer) inside the configured data space (32 Bit)
+     * @param *buffer		pointer to the buffer with the data (8 Bit)
+     * @param length8 		length of data elements to write (8 Bit)
+     * @param callback		called when the operation is finished, may be NULL
+     * @param context		passed to the callback
+     *
+     * @return bool			true, if the operation has been started, else false (the callback is not called)
+     */
+    virtual bool writeDataAsync(uint32_t p_location, const unsigned char *buffer, uint32_t length8,
+                                FlashStorageCallback callback, void *context);
+
+    /*!
+     * Erase pages in the key storage without waiting for the flash operation to finish.
+     *
+     * @note    the default implementation erases synchronously and calls the callback before returning
+     *
+     * @param page			first page to erase
+     * @param numPages		number of pages to erase
+     * @param callback		called when the operation is finished, may be NULL
+     * @param context		passed to the callback
+     *
+     * @return bool			true, if the operation has been started, else false (the callback is not called)
+     */
+    virtual bool erasePageAsync(uint8_t page, uint8_t numPages,
+                                FlashStorageCallback callback, void *context);
+
+    /*!
+     * Wait until a condition set by the callback of an asynchronous operation is
+     * met, with the wait strategy and the timeout of the blocking operations.
+     *
+     * @note    the default implementation completes the operations before they return,
+     *          so it checks the condition only
+     *
+     * @param met			condition to wait for, called with the context
+     * @param context		passed to the condition
+     *
+     * @return bool			true, if the condition is met, else false (FS_ERR_OPERATION_TIMEOUT)
+     */
+    virtual bool waitUntil(bool (*met)(void *), void *context);
+
+    /*!
+     * Erase a page in slices of bounded duration. Each call blocks for one slice
+     * of STORAGE_ERASE_SLICE_MS only, call it again (e.g. from a scheduler or an
+     * idle hook) until `done` is set. The page is erased only after the last slice,
+     * it must not be read, written or erased in between. Starting the slices of
+     * another page abandons the erase of the previous one.
+     *
+     * @note    the default implementation erases the whole page in one slice
+     *
+     * @param page			page to erase
+     * @param done			set, if the page is erased completely
+     *
+     * @return bool			true, if the slice succeeded, else false
+     */
+    virtual bool eraseSlice(uint8_t page, bool &done);
+
+    /*!
+     * Find the first byte that is not blank (0xFF) in the key storage.
+     *
+     * @param p_location	location (pointer) inside the configured data space (32 Bit)
+     * @param length8 		length of the area to check (8 Bit)
+     *
+     * @return uint32_t		offset of the first non-blank byte relative to p_location,
+     * 						length8 if the whole area is blank
+     */
+    virtual uint32_t findFirstNonBlank(uint32_t p_location, uint32_t length8);
+
+    /*!
+     * Check if an area of the key storage is erased (all bytes 0xFF).
+     *
+     * @param p_location	location (pointer) inside the configured data space (32 Bit)
+     * @param length8 		length of the area to check (8 Bit)
+     *
+     * @return bool			true, if the area is erased, else false
+     */
+    bool isErased(uint32_t p_location, uint32_t length8) {
+        return findFirstNonBlank(p_location, length8) == length8;
+    }
+
+    /*!
+     * Map an area of the key storage for direct read access, without copying it.
+     *
+     * @param p_location	location (pointer) inside the configured data space (32 Bit)
+     * @param length8 		length of the area to map (8 Bit)
+     *
+     * @return const uint8_t*	pointer to the data, NULL if the area is outside the storage
+     * 						or the storage is not memory mapped
+     */
+    virtual const uint8_t *map(uint32_t p_location, uint32_t length8);
 
     /*!
      * Convert 32 Bit array into 8 bit array.
@@ -108,7 +310,7 @@ public:
      *
      * @return int			true, if successful, else false
      */
-    bool conv32to8(const uint32_t *d32, unsigned char *d8, uint16_t length8);
+    bool conv32to8(const uint32_t *d32, unsigned char *d8, uint32_t length8);
 
     /*!
      * Convert 8 Bit array into 32 Bit array
@@ -119,8 +321,49 @@ public:
      *
      * @return int			true if successful, else false
      */
-    bool conv8to32(const unsigned char *d8, uint32_t *d32, uint16_t length8);
+    bool conv8to32(const unsigned char *d8, uint32_t *d32, uint32_t length8);
 
+protected:
+    /*!
+     * Find the first non-blank byte in directly accessible memory.
+     * The area is checked a word at a time, with byte-wise head and tail handling.
+     *
+     * @param *memory		pointer to the memory to check
+     * @param length8		length of the memory (8 Bit)
+     *
+     * @return uint32_t		offset of the first non-blank byte, length8 if all bytes are blank
+     */
+    static uint32_t scanBlank(const uint8_t *memory, uint32_t length8);
+
+    /*!
+     * Find the first byte of directly accessible memory that differs from the data.
+     * Whole words are compared where the memory is word aligned, the data may be unaligned.
+     *
+     * @param *memory		pointer to the memory to check
+     * @param *buffer		pointer to the expected data
+     * @param length8		length of the data (8 Bit)
+     *
+     * @return uint32_t		offset of the first differing byte, length8 if all bytes match
+     */
+    static uint32_t compareMapped(const uint8_t *memory, const unsigned char *buffer, uint32_t length8);
+
+    /*!
+     * Compare written data with the memory, a mismatch sets the verify failure
+     * address and FS_ERR_INTERNAL as last error.
+     *
+     * @param *memory		pointer to the written memory
+     * @param address		address of the memory reported by getVerifyFailure()
+     * @param *buffer		pointer to the written data
+     * @param length8		length of the data (8 Bit)
+     *
+     * @return bool			true, if the memory holds the data
+     */
+    bool verifyMapped(const uint8_t *memory, uint32_t address, const unsigned char *buffer, uint32_t length8);
+
+    /*!
+     * Change data inside a single page, see updateData().
+     */
+    bool updatePage(uint32_t p_location, const unsigned char *buffer, uint32_t length8);
 
 public:
     /*!
@@ -137,6 +380,93 @@ public:
      */
     virtual uint32_t getEndAddress() = 0;
 
+    /*!
+     * Get the size of a flash page, the unit of erasePage(). The default is
+     * STORAGE_PAGE_SIZE.
+     *
+     * @return page size in bytes
+     */
+    virtual uint32_t getPageSize();
+
+    /*!
+     * Compare data with the contents of the storage, e.g. after a writeDataAsync()
+     * or to verify a single writeData() without setVerify(). Mapped flash is
+     * compared a word at a time, without copying it.
+     *
+     * @param p_location 	location (pointer) inside the configured data space (32 Bit)
+     * @param *buffer		pointer to the expected data (8 Bit)
+     * @param length8 		length of the data (8 Bit)
+     *
+     * @return bool			true, if the storage holds the data, else false (see getVerifyFailure())
+     */
+    bool verifyData(uint32_t p_location, const unsigned char *buffer, uint32_t length8);
+
+    /*!
+     * Verify every write after programming, writeData() and programData() fail
+     * with FS_ERR_INTERNAL if the flash does not read back as written. The data
+     * is compared with the mapped flash, so the cost is a read of the written
+     * words, TestBenchmarkVerify measures it.
+     *
+     * @param verify        true to verify the writes of this storage
+     */
+    void setVerify(bool verify) { verifyWrites = verify; }
+
+    /*!
+     * Check, if the writes are verified.
+     */
+    bool getVerify() const { return verifyWrites; }
+
+    /*!
+     * Get the address of the last byte that did not read back as written.
+     *
+     * @return address in the address space of getStartAddress()
+     */
+    uint32_t getVerifyFailure() const { return verifyFailure; }
+
+    /*!
+     * Get the result of the last flash operation, to tell a flash failure from
+     * a timeout (FS_ERR_OPERATION_TIMEOUT) or a busy flash (FS_ERR_QUEUE_FULL)
+     * when an operation returned false. Operations refused by the argument
+     * checks do not change it.
+     *
+     * @return fstorage result, FS_SUCCESS if the last operation succeeded
+     */
+    fs_ret_t getLastError() const { return lastError; }
+
+    /*!
+     * Get the operation statistics.
+     *
+     * @param result        receives the statistics, zero if they are compiled out
+     * @param reset         reset the statistics after reading them
+     *
+     * @return true, if statistics are collected (STORAGE_STATS)
+     */
+    virtual bool getStats(FlashStorageStats &result, bool reset = false);
+
+    /*!
+     * Reset the operation statistics.
+     */
+    virtual void resetStats();
+
+protected:
+    fs_ret_t lastError;
+    bool verifyWrites;
+    uint32_t verifyFailure;
+
+#if STORAGE_STATS
+    FlashStorageStats stats;
+
+    static void addWait(FlashStoragePathStats &path, uint32_t us) {
+        path.waits++;
+        path.waitTimeUs += us;
+        if (us > path.maxWaitUs) path.maxWaitUs = us;
+    }
+
+    static void addSlice(FlashStoragePathStats &path, uint32_t us) {
+        path.eraseSlices++;
+        if (us > path.maxSliceUs) path.maxSliceUs = us;
+    }
+#endif
 };
 
 #endif //UBIRCH_FLASH_STORAGE_H
@@ -0,0 +1,166 @@
+/*!
+ * @file
+ * @brief FlashStream.cpp
+ *
+ * Sequential stream writer and reader with a cursor over a flash storage.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#include "FlashStream.h"
+
+#define PRINTF(...)
+//#define PRINTF printf
+
+static uint32_t areaEnd(FlashStorage &storage, uint32_t location, uint32_t length) {
+    const uint32_t size = storage.getEndAddress() - storage.getStartAddress();
+    if (location >= size) {
+        return location;
+    }
+    return length > size - location ? size : location + length;
+}
+
+FlashStreamWriter::FlashStreamWriter(FlashStorage &storage, uint32_t location, uint32_t length)
+        : storage(storage), location(location), end(areaEnd(storage, location, length)),
+          blankEnd(location), tail(0xFFFFFFFF), dirty(false), partialWord(0xFFFFFFFF) {}
+
+FlashStreamWriter::~FlashStreamWriter() {
+    flush();
+}
+
+bool FlashStreamWriter::write(const unsigned char *buffer, uint32_t length8) {
+    if (buffer == NULL || length8 > end - location) {
+        PRINTF("ERROR STREAM WRITE OUTSIDE OF AREA \r\n");
+        return false;
+    }
+    if (!checkBlank(location + length8)) {
+        PRINTF("ERROR FLASH NOT EMPTY \r\n");
+        return false;
+    }
+
+    while (length8 > 0) {
+        const uint32_t offset = location & 0x03;
+        if (offset == 0 && length8 >= 4) {
+            // whole words go to the storage directly
+            const uint32_t words = length8 & ~3U;
+            if (!storage.programData(location, buffer, words)) {
+                return false;
+            }
+            location += words;
+            buffer += words;
+            length8 -= words;
+            continue;
+        }
+
+        // the tail buffer is in the byte order of the flash
+        ((uint8_t *) &tail)[offset] = *buffer++;
+        location++;
+        length8--;
+        dirty = true;
+        if ((location & 0x03) == 0 && !flush()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool FlashStreamWriter::write(uint8_t byte) {
+    return write(&byte, 1);
+}
+
+bool FlashStreamWriter::flush() {
+    if (!dirty) {
+        return true;
+    }
+
+    // bytes before the area and not yet written are 0xFF and leave the flash untouched
+    const uint32_t wordLocation = (location - 1) & ~3U;
+    const bool partial = (location & 0x03) != 0;
+    if (partial && partialWord == wordLocation) {
+        // the word is programmed a second time when it is complete, not more often
+        PRINTF("stream word 0x%08x flushed before\r\n", wordLocation);
+        return false;
+    }
+    PRINTF("stream flush 0x%08x\r\n", wordLocation);
+    if (!storage.programData(wordLocation, (const uint8_t *) &tail, sizeof(tail))) {
+        return false;
+    }
+    dirty = false;
+    if (partial) {
+        partialWord = wordLocation;
+    } else {
+        tail = 0xFFFFFFFF;
+    }
+    return true;
+}
+
+bool FlashStreamWriter::checkBlank(uint32_t to) {
+    // check the rest of each page once, when the cursor enters it
+    const uint32_t pageSize = storage.getPageSize();
+    while (blankEnd < to) {
+        uint32_t pageEnd = blankEnd - blankEnd % pageSize + pageSize;
+        if (pageEnd > end) pageEnd = end;
+        if (!storage.isErased(blankEnd, pageEnd - blankEnd)) {
+            return false;
+        }
+        blankEnd = pageEnd;
+    }
+    return true;
+}
+
+FlashStreamReader::FlashStreamReader(FlashStorage &storage, uint32_t location, uint32_t length)
+        : storage(storage), location(location), end(areaEnd(storage, location, length)),
+          word(0xFFFFFFFF), wordEnd(0) {}
+
+bool FlashStreamReader::read(unsigned char *buffer, uint32_t length8) {
+    if (buffer == NULL || length8 > end - location) {
+        PRINTF("ERROR STREAM READ OUTSIDE OF AREA \r\n");
+        return false;
+    }
+
+    while (length8 > 0) {
+        // bytes of the buffered word
+        if (location < wordEnd) {
+            *buffer++ = ((const uint8_t *) &word)[location & 0x03];
+            location++;
+            length8--;
+            continue;
+        }
+
+        // larger reads go to the storage directly
+        if (length8 >= sizeof(word)) {
+            if (!storage.readData(location, buffer, length8)) {
+                return false;
+            }
+            location += length8;
+            break;
+        }
+
+        // load the word at the cursor for this and the following small reads
+        const uint32_t wordLocation = location & ~3U;
+        if (!storage.readData(wordLocation, (uint8_t *) &word, sizeof(word))) {
+            return false;
+        }
+        wordEnd = wordLocation + sizeof(word);
+    }
+    return true;
+}
+
+bool FlashStreamReader::read(uint8_t &byte) {
+    return read(&byte, 1);
+}
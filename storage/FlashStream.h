@@ -0,0 +1,156 @@
+/*!
+ * @file
+ * @brief FlashStream.h
+ *
+ * Sequential stream writer and reader with a cursor over a flash storage.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#ifndef UBIRCH_MBED_NRF52_STORAGE_FLASHSTREAM_H
+#define UBIRCH_MBED_NRF52_STORAGE_FLASHSTREAM_H
+
+#include "FlashStorage.h"
+
+/**
+ * Sequential writer for an area of the storage.
+ *
+ * Bytes are collected in a one word tail buffer and programmed as whole words,
+ * whole words of larger writes go to the storage directly. The area is checked
+ * to be blank once per page when the cursor enters it, not on every write, so
+ * the stream owns the area from its start to its end.
+ *
+ * Bytes still in the tail buffer are lost on a reset, call flush() to program
+ * them. Flushing programs the partial word padded with 0xFF, the word is
+ * programmed again with the following bytes. A word may be programmed twice
+ * only before it is erased (nWRITE of the nRF52840), so a word is flushed
+ * partially once, until it is complete.
+ */
+class FlashStreamWriter {
+
+public:
+
+    /*!
+     * @brief   Constructor
+     *
+     * @param storage       the underlying storage
+     * @param location      start of the area in the storage
+     * @param length        length of the area, may span several pages
+     */
+    FlashStreamWriter(FlashStorage &storage, uint32_t location, uint32_t length);
+
+    /*!
+     * @brief   Destructor, programs the bytes in the tail buffer
+     */
+    ~FlashStreamWriter();
+
+    /*!
+     * Write data at the cursor and advance the cursor.
+     *
+     * @return true, if the data has been buffered or programmed, false if it
+     *         does not fit into the area, the area is not blank or programming failed
+     */
+    bool write(const unsigned char *buffer, uint32_t length8);
+
+    /*!
+     * Write a single byte at the cursor and advance the cursor.
+     */
+    bool write(uint8_t byte);
+
+    /*!
+     * Program the bytes in the tail buffer.
+     *
+     * @return true, if there was nothing to program or programming succeeded, false
+     *         if the partial word has been flushed before, its bytes stay buffered
+     *         until the word is complete
+     */
+    bool flush();
+
+    /*!
+     * Get the storage location of the cursor.
+     */
+    uint32_t getLocation() const { return location; }
+
+    /*!
+     * Get the number of bytes left in the area.
+     */
+    uint32_t getRemaining() const { return end - location; }
+
+protected:
+    FlashStorage &storage;
+    uint32_t location;          // cursor
+    uint32_t end;               // first byte after the area
+    uint32_t blankEnd;          // first byte after the area checked to be blank
+    uint32_t tail;              // word at (location & ~3), bytes before the cursor not yet programmed
+    bool dirty;                 // the tail buffer has bytes that are not programmed
+    uint32_t partialWord;       // location of the word flushed partially, 0xFFFFFFFF if none
+
+    bool checkBlank(uint32_t to);
+};
+
+/**
+ * Sequential reader for an area of the storage.
+ *
+ * Small reads are served from a one word buffer, so reading byte by byte
+ * accesses the storage once per word. Larger reads go to the storage directly.
+ */
+class FlashStreamReader {
+
+public:
+
+    /*!
+     * @brief   Constructor
+     *
+     * @param storage       the underlying storage
+     * @param location      start of the area in the storage
+     * @param length        length of the area, may span several pages
+     */
+    FlashStreamReader(FlashStorage &storage, uint32_t location, uint32_t length);
+
+    /*!
+     * Read data at the cursor and advance the cursor.
+     *
+     * @return true, if the data has been read, false if it is outside the area
+     *         or reading failed
+     */
+    bool read(unsigned char *buffer, uint32_t length8);
+
+    /*!
+     * Read a single byte at the cursor and advance the cursor.
+     */
+    bool read(uint8_t &byte);
+
+    /*!
+     * Get the storage location of the cursor.
+     */
+    uint32_t getLocation() const { return location; }
+
+    /*!
+     * Get the number of bytes left in the area.
+     */
+    uint32_t getRemaining() const { return end - location; }
+
+protected:
+    FlashStorage &storage;
+    uint32_t location;          // cursor
+    uint32_t end;               // first byte after the area
+    uint32_t word;              // buffered word at (location & ~3)
+    uint32_t wordEnd;           // first byte after the buffered word, the word is valid if location < wordEnd
+};
+
+#endif //UBIRCH_MBED_NRF52_STORAGE_FLASHSTREAM_H
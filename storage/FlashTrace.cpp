@@ -0,0 +1,144 @@
+/*!
+ * @file
+ * @brief FlashTrace.cpp
+ *
+ * Ring buffer trace of flash operations with cycle timestamps.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#include <stdio.h>
+#include "FlashTrace.h"
+
+#if STORAGE_TRACE
+
+#if defined(NRF52) || defined(NRF52840_XXAA)
+#include <cmsis.h>
+#include <platform/mbed_critical.h>
+#define TRACE_LOCK() core_util_critical_section_enter()
+#define TRACE_UNLOCK() core_util_critical_section_exit()
+#else
+#include <time.h>
+#define TRACE_LOCK()
+#define TRACE_UNLOCK()
+#endif
+
+static FlashTraceEvent traceEvents[STORAGE_TRACE_EVENTS];
+static uint32_t traceHead;              // next event to write
+static uint32_t traceCount;             // events recorded since the last clear
+static uint32_t (*traceClock)() = NULL;
+static uint32_t traceClockHz = 0;
+
+static const char *const traceNames[] = {
+        "read", "write-begin", "write-end", "erase-begin", "erase-end",
+        "store-submit", "erase-submit", "callback", "wait-begin", "wait-end"
+};
+
+static uint32_t defaultClock() {
+#if defined(NRF52) || defined(NRF52840_XXAA)
+    // enable the cycle counter on first use
+    if (!(DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk)) {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CYCCNT = 0;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+    return DWT->CYCCNT;
+#else
+    return (uint32_t) clock();
+#endif
+}
+
+void FlashTrace::record(FlashTraceOp op, uint32_t address, uint32_t length, uint16_t result) {
+    TRACE_LOCK();
+    FlashTraceEvent *event = &traceEvents[traceHead];
+    event->timestamp = traceClock != NULL ? traceClock() : defaultClock();
+    event->address = address;
+    event->length = length;
+    event->op = (uint16_t) op;
+    event->result = result;
+    traceHead = (traceHead + 1) % STORAGE_TRACE_EVENTS;
+    traceCount++;
+    TRACE_UNLOCK();
+}
+
+uint32_t FlashTrace::read(FlashTraceEvent *events, uint32_t max) {
+    TRACE_LOCK();
+    const uint32_t available = traceCount < STORAGE_TRACE_EVENTS ? traceCount : STORAGE_TRACE_EVENTS;
+    const uint32_t n = available < max ? available : max;
+    const uint32_t first = (traceHead + STORAGE_TRACE_EVENTS - available) % STORAGE_TRACE_EVENTS;
+    for (uint32_t i = 0; i < n; i++) {
+        events[i] = traceEvents[(first + i) % STORAGE_TRACE_EVENTS];
+    }
+    TRACE_UNLOCK();
+    return n;
+}
+
+void FlashTrace::dump() {
+    TRACE_LOCK();
+    const uint32_t count = traceCount;
+    const uint32_t available = count < STORAGE_TRACE_EVENTS ? count : STORAGE_TRACE_EVENTS;
+    const uint32_t first = (traceHead + STORAGE_TRACE_EVENTS - available) % STORAGE_TRACE_EVENTS;
+    TRACE_UNLOCK();
+
+    printf("# flash trace: %u of %u events, %u Hz\r\n",
+           (unsigned int) available, (unsigned int) count, (unsigned int) getClockHz());
+    printf("index,timestamp,op,address,length,result\r\n");
+    for (uint32_t i = 0; i < available; i++) {
+        TRACE_LOCK();
+        const FlashTraceEvent event = traceEvents[(first + i) % STORAGE_TRACE_EVENTS];
+        TRACE_UNLOCK();
+        printf("%u,%u,%s,0x%08x,%u,%u\r\n", (unsigned int) (count - available + i), (unsigned int) event.timestamp,
+               getName(event.op), (unsigned int) event.address, (unsigned int) event.length,
+               (unsigned int) event.result);
+    }
+}
+
+void FlashTrace::clear() {
+    TRACE_LOCK();
+    traceHead = 0;
+    traceCount = 0;
+    TRACE_UNLOCK();
+}
+
+uint32_t FlashTrace::getCount() {
+    return traceCount;
+}
+
+void FlashTrace::setClock(uint32_t (*clock)(), uint32_t hz) {
+    TRACE_LOCK();
+    traceClock = clock;
+    traceClockHz = clock != NULL ? hz : 0;
+    TRACE_UNLOCK();
+}
+
+uint32_t FlashTrace::getClockHz() {
+    if (traceClock != NULL) {
+        return traceClockHz;
+    }
+#if defined(NRF52) || defined(NRF52840_XXAA)
+    return SystemCoreClock;
+#else
+    return CLOCKS_PER_SEC;
+#endif
+}
+
+const char *FlashTrace::getName(uint16_t op) {
+    return op < sizeof(traceNames) / sizeof(traceNames[0]) ? traceNames[op] : "unknown";
+}
+
+#endif
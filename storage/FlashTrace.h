@@ -0,0 +1,141 @@
+/*!
+ * @file
+ * @brief FlashTrace.h
+ *
+ * Ring buffer trace of flash operations with cycle timestamps.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#ifndef UBIRCH_MBED_NRF52_STORAGE_FLASHTRACE_H
+#define UBIRCH_MBED_NRF52_STORAGE_FLASHTRACE_H
+
+#include <stdint.h>
+
+// record the flash operations in a ring buffer, set to 1 to enable the trace
+#ifndef STORAGE_TRACE
+#define STORAGE_TRACE 0
+#endif
+
+// number of events kept in the ring buffer (16 bytes each)
+#ifndef STORAGE_TRACE_EVENTS
+#define STORAGE_TRACE_EVENTS 64
+#endif
+
+/**
+ * Traced operations, operations taking time have a begin and an end event.
+ */
+enum FlashTraceOp {
+    FLASH_TRACE_READ = 0,           //!< readData()
+    FLASH_TRACE_WRITE_BEGIN,        //!< programData() called, also for writeData()
+    FLASH_TRACE_WRITE_END,          //!< programData() returns, result is the fstorage result
+    FLASH_TRACE_ERASE_BEGIN,        //!< erasePage() called
+    FLASH_TRACE_ERASE_END,          //!< erasePage() returns
+    FLASH_TRACE_STORE_SUBMIT,       //!< fs_store() or nosd_store() returned
+    FLASH_TRACE_ERASE_SUBMIT,       //!< fs_erase() or nosd_erase_page() returned
+    FLASH_TRACE_CALLBACK,           //!< fstorage completed a queued operation
+    FLASH_TRACE_WAIT_BEGIN,         //!< the caller starts waiting (completion or NVMC READY)
+    FLASH_TRACE_WAIT_END            //!< the caller stops waiting
+};
+
+/**
+ * A traced event.
+ */
+struct FlashTraceEvent {
+    uint32_t timestamp;     //!< clock ticks, see FlashTrace::getClockHz()
+    uint32_t address;       //!< location in the storage
+    uint32_t length;        //!< length in bytes
+    uint16_t op;            //!< FlashTraceOp
+    uint16_t result;        //!< fs_ret_t of end, submit and callback events
+};
+
+#if STORAGE_TRACE
+#define STORAGE_TRACE_EVENT(op, address, length, result) \
+    FlashTrace::record(op, address, length, (uint16_t) (result))
+#else
+#define STORAGE_TRACE_EVENT(op, address, length, result) ((void) 0)
+#endif
+
+#if STORAGE_TRACE
+
+/**
+ * Trace of the flash operations of all storages.
+ *
+ * The events are recorded in a static ring buffer of STORAGE_TRACE_EVENTS
+ * entries, the oldest events are overwritten. On the nRF52 the timestamps are
+ * taken from the DWT cycle counter, the host build uses clock() unless another
+ * clock is set. dump() prints the trace as CSV to rebuild the timeline of the
+ * operations offline.
+ */
+class FlashTrace {
+
+public:
+
+    /*!
+     * Record an event, safe to call from interrupts.
+     */
+    static void record(FlashTraceOp op, uint32_t address, uint32_t length, uint16_t result);
+
+    /*!
+     * Copy the recorded events, oldest first.
+     *
+     * @param events        buffer for the events
+     * @param max           size of the buffer in events
+     *
+     * @return number of events copied
+     */
+    static uint32_t read(FlashTraceEvent *events, uint32_t max);
+
+    /*!
+     * Print the recorded events as CSV, oldest first.
+     */
+    static void dump();
+
+    /*!
+     * Remove all events.
+     */
+    static void clear();
+
+    /*!
+     * Get the number of events recorded since the last clear(), including
+     * the overwritten ones.
+     */
+    static uint32_t getCount();
+
+    /*!
+     * Replace the clock of the timestamps.
+     *
+     * @param clock         clock function, NULL for the default clock
+     * @param hz            ticks per second of the clock
+     */
+    static void setClock(uint32_t (*clock)(), uint32_t hz);
+
+    /*!
+     * Get the ticks per second of the timestamps.
+     */
+    static uint32_t getClockHz();
+
+    /*!
+     * Get the name of an operation.
+     */
+    static const char *getName(uint16_t op);
+};
+
+#endif
+
+#endif //UBIRCH_MBED_NRF52_STORAGE_FLASHTRACE_H
@@ -0,0 +1,235 @@
+/*!
+ * @file
+ * @brief FlashTransaction.cpp
+ *
+ * Atomic multi-record transactions with a single commit word.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#include "FlashTransaction.h"
+
+#define PRINTF(...)
+//#define PRINTF printf
+
+#define BLANK_WORD 0xFFFFFFFF
+
+// the start and the end of a transaction in words in 13 bits each, the commit word is never blank
+// as start < end; the upper 6 bits count the 0 bits of the offsets
+#define COMMIT_OFFSET_MASK 0x1FFF
+#define COMMIT_OFFSETS_MASK 0x3FFFFFF
+#define COMMIT_START(word) ((word) & COMMIT_OFFSET_MASK)
+#define COMMIT_END(word) (((word) >> 13) & COMMIT_OFFSET_MASK)
+#define COMMIT_CHECK(word) ((word) >> 26)
+
+// a torn commit word has 1 bits where 0 bits are missing: the offsets have fewer 0 bits than
+// counted and the count is larger, so both never match (a Berger code)
+static uint32_t commitCheck(uint32_t word) {
+    uint32_t zeros = 0;
+    for (uint32_t offsets = ~word & COMMIT_OFFSETS_MASK; offsets; offsets &= offsets - 1) zeros++;
+    return zeros;
+}
+
+FlashTransaction::FlashTransaction(FlashStorage &storage, uint8_t firstPage, uint8_t numPages)
+        : storage(storage), firstPage(firstPage), numPages(numPages), pageSize(storage.getPageSize()),
+          dataWords(0), mounted(false), open(false), nextSlot(1), lastSlot(0), end(0), start(0), tail(0) {
+    // the commit word holds the offsets in 13 bits
+    if (numPages > 1) dataWords = (numPages - 1) * (pageSize >> 2);
+    if (dataWords > COMMIT_OFFSET_MASK) dataWords = COMMIT_OFFSET_MASK;
+}
+
+bool FlashTransaction::mount() {
+    mounted = false;
+    open = false;
+    if (numPages < 2 || storage.getEndAddress() - storage.getStartAddress() < (firstPage + numPages) * pageSize) {
+        PRINTF("TXN invalid page range\r\n");
+        return false;
+    }
+    if (readWord(commitLocation(0)) != FLASHTXN_MAGIC) {
+        PRINTF("TXN no commit table found, formatting\r\n");
+        return format();
+    }
+
+    // the used slots are followed by blank slots only
+    uint32_t low = 1;
+    uint32_t high = slots();
+    while (low < high) {
+        const uint32_t mid = (low + high) / 2;
+        if (readWord(commitLocation(mid)) == BLANK_WORD) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    nextSlot = low;
+
+    // a commit word torn by a reset is ignored, only the last ones can be torn
+    lastSlot = 0;
+    end = 0;
+    for (uint32_t slot = nextSlot - 1; slot > 0; slot--) {
+        const uint32_t word = readWord(commitLocation(slot));
+        uint32_t header;
+        uint32_t location;
+        if (walkRecords(word, 0xFFFF, header, location)) {
+            lastSlot = slot;
+            end = COMMIT_END(word);
+            break;
+        }
+        PRINTF("TXN ignoring torn commit in slot %u\r\n", slot);
+    }
+
+    // skip the records written after the last commit, they are rolled back
+    tail = end;
+    while (tail < dataWords) {
+        const uint32_t header = readWord(dataLocation(tail));
+        if (header == BLANK_WORD) {
+            break;
+        }
+        const uint32_t size = getRecordSize((uint16_t) (header >> 16)) >> 2;
+        if ((header >> 16) == 0 || size > dataWords - tail) {
+            // a corrupted header, do not write to the rest of the area anymore
+            tail = dataWords;
+            break;
+        }
+        tail += size;
+    }
+
+    mounted = true;
+    PRINTF("TXN mounted %u commits, end 0x%04x, tail 0x%04x\r\n", nextSlot - 1, end << 2, tail << 2);
+    return true;
+}
+
+bool FlashTransaction::format() {
+    mounted = false;
+    open = false;
+    const uint32_t magic = FLASHTXN_MAGIC;
+    if (numPages < 2 || !storage.erasePage(firstPage, numPages) ||
+        !storage.programData(commitLocation(0), (const uint8_t *) &magic, sizeof(magic))) {
+        return false;
+    }
+    nextSlot = 1;
+    lastSlot = 0;
+    end = 0;
+    tail = 0;
+    mounted = true;
+    return true;
+}
+
+bool FlashTransaction::begin() {
+    if (!mounted || nextSlot >= slots()) {
+        return false;
+    }
+    open = true;
+    start = tail;
+    return true;
+}
+
+bool FlashTransaction::stage(uint16_t id, const uint8_t *data, uint16_t length) {
+    if (!open || data == NULL || length == 0 || id == 0xFFFF) {
+        return false;
+    }
+    const uint32_t size = getRecordSize(length) >> 2;
+    if (size > dataWords - tail) {
+        return false;
+    }
+
+    // the space is used as soon as the header is written, even if the data is not
+    const uint32_t location = dataLocation(tail);
+    const uint32_t header = id | ((uint32_t) length << 16);
+    if (!storage.programData(location, (const uint8_t *) &header, FLASHTXN_RECORD_HEADER_SIZE)) {
+        open = false;
+        return false;
+    }
+    tail += size;
+    if (!storage.programData(location + FLASHTXN_RECORD_HEADER_SIZE, data, length)) {
+        open = false;
+        return false;
+    }
+    return true;
+}
+
+bool FlashTransaction::commit() {
+    if (!open) {
+        return false;
+    }
+    open = false;
+    if (tail == start) {
+        return true;
+    }
+
+    // the slot is used, even if the commit word could not be written completely
+    const uint32_t offsets = start | (tail << 13);
+    const uint32_t word = offsets | (commitCheck(offsets) << 26);
+    const uint32_t slot = nextSlot++;
+    if (!storage.programData(commitLocation(slot), (const uint8_t *) &word, sizeof(word))) {
+        return false;
+    }
+    lastSlot = slot;
+    end = tail;
+    return true;
+}
+
+bool FlashTransaction::read(uint16_t id, uint8_t *buffer, uint16_t size, uint16_t &length) {
+    length = 0;
+    if (!mounted || buffer == NULL) {
+        return false;
+    }
+
+    // the newest transaction first
+    for (uint32_t slot = lastSlot; slot > 0; slot--) {
+        uint32_t header;
+        uint32_t location;
+        if (walkRecords(readWord(commitLocation(slot)), id, header, location) && header != BLANK_WORD) {
+            length = (uint16_t) (header >> 16);
+            return length <= size && storage.readData(location + FLASHTXN_RECORD_HEADER_SIZE, buffer, length);
+        }
+    }
+    return false;
+}
+
+uint32_t FlashTransaction::readWord(uint32_t location) {
+    uint32_t word;
+    if (!storage.readData(location, (uint8_t *) &word, sizeof(word))) {
+        return BLANK_WORD;
+    }
+    return word;
+}
+
+bool FlashTransaction::walkRecords(uint32_t word, uint16_t id, uint32_t &header, uint32_t &location) {
+    header = BLANK_WORD;
+    uint32_t from = COMMIT_START(word);
+    const uint32_t to = COMMIT_END(word);
+    if (word == BLANK_WORD || COMMIT_CHECK(word) != commitCheck(word) || from >= to || to > dataWords) {
+        return false;
+    }
+
+    // a transaction may contain several versions of a record, the last one counts
+    while (from < to) {
+        const uint32_t record = readWord(dataLocation(from));
+        const uint32_t size = getRecordSize((uint16_t) (record >> 16)) >> 2;
+        if (record == BLANK_WORD || (record >> 16) == 0 || size > to - from) {
+            return false;
+        }
+        if ((record & 0xFFFF) == id) {
+            header = record;
+            location = dataLocation(from);
+        }
+        from += size;
+    }
+    return true;
+}
@@ -0,0 +1,189 @@
+/*!
+ * @file
+ * @brief FlashTransaction.h
+ *
+ * Atomic multi-record transactions with a single commit word.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#ifndef UBIRCH_MBED_NRF52_STORAGE_FLASHTRANSACTION_H
+#define UBIRCH_MBED_NRF52_STORAGE_FLASHTRANSACTION_H
+
+#include "FlashStorage.h"
+
+// marks the commit table of the transactions ("FTXN")
+#define FLASHTXN_MAGIC 0x4E585446
+
+// size of the record header (id, length)
+#define FLASHTXN_RECORD_HEADER_SIZE 4
+
+/**
+ * Power-fail-safe transactions of several records.
+ *
+ * The first page is the commit table, starting with a magic word, the other
+ * pages hold the records. A transaction writes its records back to back after
+ * the previous one, every record is a header word (id in the lower, length in
+ * the upper half word) followed by the data, padded to whole words. commit()
+ * then programs one word into the next slot of the commit table: the start and
+ * the end of the transaction in words and the number of 0 bits in them. Data
+ * without a commit word does not exist for read(). The offsets have 13 bits, the
+ * record area is limited to 32 KB.
+ *
+ * The commit words are programmed in order and are never blank, so mount()
+ * finds the last one with a binary search of the commit table. The records of
+ * the last transaction have to end exactly at its end, a commit word torn by a
+ * reset is ignored. After it only the records of a transaction that was
+ * interrupted by a reset are walked, to find the end of the data. Recovery is
+ * bounded by the size of a transaction, nothing is erased: the interrupted
+ * records are skipped and stay in the flash until format().
+ *
+ * @code
+ * FlashTransaction provisioning(flashStorage, 0, 2);
+ *
+ * provisioning.mount();
+ * provisioning.begin();
+ * provisioning.stage(DEVICE_KEY, key, sizeof(key));
+ * provisioning.stage(CERTIFICATE, certificate, certificateLength);
+ * provisioning.stage(COUNTER_BASE, (const uint8_t *) &counterBase, sizeof(counterBase));
+ * provisioning.commit();
+ * @endcode
+ */
+class FlashTransaction {
+
+public:
+
+    /*!
+     * @brief   Constructor
+     *
+     * @param storage       the underlying storage
+     * @param firstPage     first page of the storage used for the transactions
+     * @param numPages      number of pages, the commit table and at least one page of records
+     *                      (up to 32 KB are used for the records)
+     */
+    FlashTransaction(FlashStorage &storage, uint8_t firstPage, uint8_t numPages);
+
+    /*!
+     * Find the committed transactions and the end of the data. An interrupted
+     * transaction is rolled back, its records are ignored.
+     *
+     * @return true, if the transactions are ready to use
+     */
+    bool mount();
+
+    /*!
+     * Erase all pages and drop all transactions.
+     *
+     * @return true, if the transactions are ready to use
+     */
+    bool format();
+
+    /*!
+     * Start a transaction, a transaction that was not committed is dropped.
+     *
+     * @return true, if the transaction has been started, false if the commit table is full
+     */
+    bool begin();
+
+    /*!
+     * Write a record of the transaction, it can be read after the commit only.
+     *
+     * @param id            id of the record, 0 to 0xFFFE
+     * @param data          record data
+     * @param length        length of the record, 1 to 0xFFFF
+     *
+     * @return true, if the record has been written
+     */
+    bool stage(uint16_t id, const uint8_t *data, uint16_t length);
+
+    /*!
+     * Commit the transaction with a single word, all of its records become
+     * valid at once.
+     *
+     * @return true, if the transaction has been committed
+     */
+    bool commit();
+
+    /*!
+     * Drop the transaction, its records stay in the flash but are ignored.
+     */
+    void abort() { open = false; }
+
+    /*!
+     * Read the newest committed version of a record.
+     *
+     * @param id            id of the record
+     * @param buffer        buffer for the record data
+     * @param size          size of the buffer
+     * @param length        receives the length of the record, 0 if there is none
+     *
+     * @return true, if the record exists and fits into the buffer
+     */
+    bool read(uint16_t id, uint8_t *buffer, uint16_t size, uint16_t &length);
+
+    /*!
+     * Get the number of used slots of the commit table, the committed transactions.
+     */
+    uint32_t getCommitted() const { return nextSlot - 1; }
+
+    /*!
+     * Get the number of bytes available for records.
+     */
+    uint32_t getFree() const { return (dataWords - tail) << 2; }
+
+    /*!
+     * Get the flash space used by a record, including its header and padding.
+     */
+    static uint32_t getRecordSize(uint16_t length) {
+        return FLASHTXN_RECORD_HEADER_SIZE + (((uint32_t) length + 3) & ~3U);
+    }
+
+protected:
+    FlashStorage &storage;
+    uint8_t firstPage;
+    uint8_t numPages;
+    uint32_t pageSize;
+    uint32_t dataWords;         // size of the record area in words
+
+    bool mounted;
+    bool open;
+    uint32_t nextSlot;          // next free slot of the commit table
+    uint32_t lastSlot;          // slot of the last valid commit, 0 if there is none
+    uint32_t end;               // end of the last committed transaction in words
+    uint32_t start;             // start of the open transaction in words
+    uint32_t tail;              // next free word of the record area
+
+    uint32_t commitLocation(uint32_t slot) const { return firstPage * pageSize + (slot << 2); }
+
+    uint32_t dataLocation(uint32_t word) const { return (firstPage + 1) * pageSize + (word << 2); }
+
+    uint32_t readWord(uint32_t location);
+
+    uint32_t slots() const { return pageSize >> 2; }
+
+    /*
+     * Walk the records of a committed transaction and find the last version of
+     * a record (header BLANK if there is none). A commit word torn by a reset
+     * fails the count of its 0 bits.
+     *
+     * @return true, if the commit word is valid
+     */
+    bool walkRecords(uint32_t word, uint16_t id, uint32_t &header, uint32_t &location);
+};
+
+#endif //UBIRCH_MBED_NRF52_STORAGE_FLASHTRANSACTION_H
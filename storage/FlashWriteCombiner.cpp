@@ -0,0 +1,222 @@
+/*!
+ * @file
+ * @brief FlashWriteCombiner.cpp
+ *
+ * Write combining layer that merges small adjacent writes into a single
+ * flash store operation.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#include <string.h>
+#include "FlashWriteCombiner.h"
+
+#define PRINTF(...)
+//#define PRINTF printf
+
+FlashWriteCombiner::FlashWriteCombiner(FlashStorage &storage, uint32_t (*clock)(), uint32_t timeoutMs)
+        : storage(storage), clock(clock), timeoutMs(timeoutMs),
+          stageBase(0), stageStart(0), stageEnd(0), stagedAt(0) {
+    resetCounters();
+}
+
+FlashWriteCombiner::~FlashWriteCombiner() {
+    flush();
+}
+
+void FlashWriteCombiner::resetCounters() {
+    writes = 0;
+    bytesWritten = 0;
+    stores = 0;
+}
+
+bool FlashWriteCombiner::init() {
+    return storage.init();
+}
+
+bool FlashWriteCombiner::readData(uint32_t p_location, unsigned char *buffer, uint32_t length8) {
+    if (!storage.readData(p_location, buffer, length8)) {
+        return false;
+    }
+
+    // read your writes: overlay the staged data
+    if (overlapsStage(p_location, length8)) {
+        uint32_t from = p_location > stageStart ? p_location : stageStart;
+        uint32_t to = p_location + length8 < stageEnd ? p_location + length8 : stageEnd;
+        memcpy(buffer + (from - p_location), (const uint8_t *) staged + (from - stageBase), to - from);
+    }
+    return true;
+}
+
+bool FlashWriteCombiner::erasePage(uint8_t page, uint8_t numPages) {
+    flush();
+    return storage.erasePage(page, numPages);
+}
+
+bool FlashWriteCombiner::writeData(uint32_t p_location, const unsigned char *buffer, uint32_t length8) {
+    if (buffer == NULL || length8 == 0) {
+        PRINTF("ERROR NULL  \r\n");
+        return false;
+    }
+
+    const uint32_t size = getEndAddress() - getStartAddress();
+    if (p_location >= size || length8 > size - p_location) {
+        PRINTF("ERROR WRITE OUTSIDE OF STORAGE \r\n");
+        return false;
+    }
+
+    // staged data counts as written, the blank gaps between staged writes do not
+    if (isStaged(p_location, length8) || !storage.isErased(p_location, length8)) {
+        PRINTF("ERROR FLASH NOT EMPTY \r\n");
+        return false;
+    }
+
+    // combine if the data follows the staged data, possibly with a small blank gap, or fills a gap
+    const bool combine = stageEnd != stageStart
+                         && p_location >= stageStart
+                         && p_location <= stageEnd + STORAGE_COMBINE_MAX_GAP
+                         && p_location + length8 - stageBase <= STORAGE_COMBINE_BUFFER_SIZE
+                         && (p_location <= stageEnd || storage.isErased(stageEnd, p_location - stageEnd));
+
+    if (!combine) {
+        if (!flush()) {
+            return false;
+        }
+
+        // too large to be staged, write it right away
+        if ((p_location & 0x03) + length8 > STORAGE_COMBINE_BUFFER_SIZE) {
+            stores++;
+            if (!storage.writeData(p_location, buffer, length8)) {
+                return false;
+            }
+            writes++;
+            bytesWritten += length8;
+            return true;
+        }
+
+        memset(staged, 0xFF, sizeof(staged));
+        memset(stagedMask, 0, sizeof(stagedMask));
+        stageBase = p_location & ~0x03U;
+        stageStart = p_location;
+        stageEnd = p_location;
+        stagedAt = clock ? clock() : 0;
+    }
+
+    memcpy((uint8_t *) staged + (p_location - stageBase), buffer, length8);
+    for (uint32_t index = p_location - stageBase; index < p_location + length8 - stageBase; index++) {
+        stagedMask[index >> 5] |= 1U << (index & 31);
+    }
+    if (p_location + length8 > stageEnd) stageEnd = p_location + length8;
+    writes++;
+    bytesWritten += length8;
+
+    // store right away if the buffer is full
+    if (stageEnd - stageBase == STORAGE_COMBINE_BUFFER_SIZE) {
+        return flush();
+    }
+    return true;
+}
+
+bool FlashWriteCombiner::programData(uint32_t p_location, const unsigned char *buffer, uint32_t length8) {
+    if (!flush()) {
+        return false;
+    }
+    stores++;
+    return storage.programData(p_location, buffer, length8);
+}
+
+uint32_t FlashWriteCombiner::findFirstNonBlank(uint32_t p_location, uint32_t length8) {
+    uint32_t offset = storage.findFirstNonBlank(p_location, length8);
+
+    if (overlapsStage(p_location, length8)) {
+        uint32_t from = p_location > stageStart ? p_location : stageStart;
+        uint32_t to = p_location + length8 < stageEnd ? p_location + length8 : stageEnd;
+        for (uint32_t index = from; index < to && index - p_location < offset; index++) {
+            if (((const uint8_t *) staged)[index - stageBase] != 0xFF) {
+                return index - p_location;
+            }
+        }
+    }
+    return offset;
+}
+
+const uint8_t *FlashWriteCombiner::map(uint32_t p_location, uint32_t length8) {
+    if (overlapsStage(p_location, length8) && !flush()) {
+        return NULL;
+    }
+    return storage.map(p_location, length8);
+}
+
+uint32_t FlashWriteCombiner::getStartAddress() {
+    return storage.getStartAddress();
+}
+
+uint32_t FlashWriteCombiner::getEndAddress() {
+    return storage.getEndAddress();
+}
+
+uint32_t FlashWriteCombiner::getPageSize() {
+    return storage.getPageSize();
+}
+
+bool FlashWriteCombiner::getStats(FlashStorageStats &result, bool reset) {
+    return storage.getStats(result, reset);
+}
+
+void FlashWriteCombiner::resetStats() {
+    storage.resetStats();
+}
+
+bool FlashWriteCombiner::flush() {
+    if (stageEnd == stageStart) {
+        return true;
+    }
+
+    const uint32_t location = stageStart;
+    const uint32_t length = stageEnd - stageStart;
+
+    // the staged data is kept until it has been stored, a later flush() or poll() retries
+    PRINTF("combined write 0x%08x (%u bytes)\r\n", location, length);
+    stores++;
+    if (!storage.writeData(location, (const uint8_t *) staged + (location - stageBase), length)) {
+        return false;
+    }
+    stageStart = stageEnd;
+    return true;
+}
+
+bool FlashWriteCombiner::isStaged(uint32_t p_location, uint32_t length8) const {
+    if (!overlapsStage(p_location, length8)) {
+        return false;
+    }
+    const uint32_t from = p_location > stageStart ? p_location : stageStart;
+    const uint32_t to = p_location + length8 < stageEnd ? p_location + length8 : stageEnd;
+    for (uint32_t index = from - stageBase; index < to - stageBase; index++) {
+        if (stagedMask[index >> 5] & (1U << (index & 31))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool FlashWriteCombiner::poll() {
+    if (stageEnd != stageStart && clock != NULL && clock() - stagedAt >= timeoutMs) {
+        return flush();
+    }
+    return true;
+}
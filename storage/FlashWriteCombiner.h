@@ -0,0 +1,179 @@
+/*!
+ * @file
+ * @brief FlashWriteCombiner.h
+ *
+ * Write combining layer that merges small adjacent writes into a single
+ * flash store operation.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#ifndef UBIRCH_MBED_NRF52_STORAGE_FLASHWRITECOMBINER_H
+#define UBIRCH_MBED_NRF52_STORAGE_FLASHWRITECOMBINER_H
+
+#include "FlashStorage.h"
+
+// size of the staging buffer in bytes (multiple of 4)
+#ifndef STORAGE_COMBINE_BUFFER_SIZE
+#define STORAGE_COMBINE_BUFFER_SIZE 256
+#endif
+
+// maximum number of blank bytes between two writes that are still combined
+#ifndef STORAGE_COMBINE_MAX_GAP
+#define STORAGE_COMBINE_MAX_GAP 4
+#endif
+
+/**
+ * Flash storage that combines small writes.
+ *
+ * Contiguous or nearby writes are collected in a RAM staging buffer and stored
+ * with a single writeData() on the underlying storage when the buffer is full,
+ * a write to another location arrives, flush() is called or the staged data
+ * is older than the flush timeout (checked by poll()). Reads and blank checks
+ * include the staged data.
+ */
+class FlashWriteCombiner : public FlashStorage {
+
+public:
+
+    /*!
+     * @brief   Constructor
+     *
+     * @param storage       the underlying storage
+     * @param clock         millisecond clock used for the flush timeout, NULL to disable the timeout
+     * @param timeoutMs     maximum time data stays in the staging buffer, checked by poll()
+     */
+    FlashWriteCombiner(FlashStorage &storage, uint32_t (*clock)() = NULL, uint32_t timeoutMs = 0);
+
+    /*!
+     * @brief   Destructor, stores any staged data
+     */
+    ~FlashWriteCombiner();
+
+    bool init();
+
+    /*!
+     * Read data, including data that is still staged.
+     */
+    bool readData(uint32_t p_location, unsigned char *buffer, uint32_t length8);
+
+    /*!
+     * Erase pages, staged data is stored before.
+     */
+    bool erasePage(uint8_t page, uint8_t numPages);
+
+    /*!
+     * Write data. The data is staged if it can be combined with the staged
+     * data, otherwise the staged data is stored first.
+     *
+     * @return true, if the data has been staged or written, false if the area
+     *         is outside the storage, not blank or storing the staged data failed
+     */
+    bool writeData(uint32_t p_location, const unsigned char *buffer, uint32_t length8);
+
+    /*!
+     * Program data without blank check, staged data is stored before.
+     */
+    bool programData(uint32_t p_location, const unsigned char *buffer, uint32_t length8);
+
+    uint32_t findFirstNonBlank(uint32_t p_location, uint32_t length8);
+
+    /*!
+     * Map an area of the storage, staged data in that area is stored before.
+     */
+    const uint8_t *map(uint32_t p_location, uint32_t length8);
+
+    uint32_t getStartAddress();
+
+    uint32_t getEndAddress();
+
+    uint32_t getPageSize();
+
+    /*!
+     * Get the operation statistics of the underlying storage.
+     */
+    bool getStats(FlashStorageStats &result, bool reset = false);
+
+    /*!
+     * Reset the operation statistics of the underlying storage.
+     */
+    void resetStats();
+
+    /*!
+     * Store the staged data. If storing fails, the data stays staged and a later
+     * flush() or poll() tries again.
+     *
+     * @return true, if there was nothing to store or storing succeeded
+     */
+    bool flush();
+
+    /*!
+     * Store the staged data if it is older than the flush timeout.
+     * Call this regularly, e.g. from an EventQueue::call_every().
+     *
+     * @return true, if there was nothing to store or storing succeeded
+     */
+    bool poll();
+
+    /*!
+     * Get the number of writeData() calls.
+     */
+    uint32_t getWrites() const { return writes; }
+
+    /*!
+     * Get the number of bytes written with writeData().
+     */
+    uint32_t getBytesWritten() const { return bytesWritten; }
+
+    /*!
+     * Get the number of writes on the underlying storage.
+     */
+    uint32_t getStores() const { return stores; }
+
+    /*!
+     * Reset the write counters.
+     */
+    void resetCounters();
+
+protected:
+    FlashStorage &storage;
+    uint32_t (*clock)();
+    uint32_t timeoutMs;
+
+    uint32_t staged[STORAGE_COMBINE_BUFFER_SIZE / 4];
+    uint32_t stageBase;         // word aligned location of staged[0]
+    uint32_t stageStart;        // first staged byte
+    uint32_t stageEnd;          // first byte after the staged data, == stageStart if empty
+    uint32_t stagedAt;          // clock when the data was staged
+    uint32_t stagedMask[STORAGE_COMBINE_BUFFER_SIZE / 32];  // bytes of staged[] written, not blank gaps
+
+    uint32_t writes;
+    uint32_t bytesWritten;
+    uint32_t stores;
+
+    bool overlapsStage(uint32_t p_location, uint32_t length8) const {
+        return stageEnd != stageStart && p_location < stageEnd && p_location + length8 > stageStart;
+    }
+
+    /*
+     * Check, if any byte of an area has been staged, the blank gaps between combined writes have not.
+     */
+    bool isStaged(uint32_t p_location, uint32_t length8) const;
+};
+
+#endif //UBIRCH_MBED_NRF52_STORAGE_FLASHWRITECOMBINER_H
@@ -0,0 +1,96 @@
+/*!
+ * @file
+ * @brief NRF52FlashPartitions.cpp
+ *
+ * Named flash partitions with their own fstorage registration.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#include <string.h>
+#include <nrf52_bitfields.h>
+#include "NRF52FlashPartitions.h"
+
+#define PRINTF(...)
+//#define PRINTF printf
+
+/*
+ * true, if the pages [start, end) of two storages overlap
+ */
+static bool overlaps(NRF52FlashStorage *a, NRF52FlashStorage *b) {
+    return a->getStartAddress() < b->getEndAddress() && b->getStartAddress() < a->getEndAddress();
+}
+
+NRF52FlashPartitionTable::NRF52FlashPartitionTable(const NRF52FlashPartition *partitions, uint8_t count)
+        : partitions(partitions), count(count) {
+}
+
+bool NRF52FlashPartitionTable::init() {
+    NRF52FlashStorage library;
+    return library.init() && check();
+}
+
+bool NRF52FlashPartitionTable::check() const {
+    NRF52FlashStorage library;
+    const uint32_t flashSize = NRF_FICR->CODEPAGESIZE * NRF_FICR->CODESIZE;
+    const uint32_t pageSize = library.getPageSize();
+    for (uint8_t i = 0; i < count; i++) {
+        const NRF52FlashPartition &partition = partitions[i];
+        if (partition.name == NULL || partition.storage == NULL) {
+            PRINTF("PARTITION %d INCOMPLETE\r\n", i);
+            return false;
+        }
+        const uint32_t start = partition.storage->getStartAddress();
+        const uint32_t end = partition.storage->getEndAddress();
+        if (start >= end || start % pageSize || end > flashSize) {
+            PRINTF("PARTITION %s INVALID 0x%08x-0x%08x\r\n", partition.name, start, end);
+            return false;
+        }
+        if (overlaps(partition.storage, &library)) {
+            PRINTF("PARTITION %s OVERLAPS THE LIBRARY STORAGE\r\n", partition.name);
+            return false;
+        }
+        for (uint8_t j = 0; j < i; j++) {
+            if (!strcmp(partition.name, partitions[j].name)) {
+                PRINTF("PARTITION %s DUPLICATE NAME\r\n", partition.name);
+                return false;
+            }
+            if (overlaps(partition.storage, partitions[j].storage)) {
+                PRINTF("PARTITION %s OVERLAPS %s\r\n", partition.name, partitions[j].name);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+NRF52FlashStorage *NRF52FlashPartitionTable::find(const char *name) const {
+    if (name == NULL) {
+        return NULL;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        if (partitions[i].name != NULL && !strcmp(partitions[i].name, name)) {
+            return partitions[i].storage;
+        }
+    }
+    return NULL;
+}
+
+const NRF52FlashPartition *NRF52FlashPartitionTable::get(uint8_t index) const {
+    return index < count ? &partitions[index] : NULL;
+}
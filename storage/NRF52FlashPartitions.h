@@ -0,0 +1,133 @@
+/*!
+ * @file
+ * @brief NRF52FlashPartitions.h
+ *
+ * Named flash partitions with their own fstorage registration.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#ifndef UBIRCH_MBED_NRF52_STORAGE_NRF52FLASHPARTITIONS_H
+#define UBIRCH_MBED_NRF52_STORAGE_NRF52FLASHPARTITIONS_H
+
+#include "NRF52FlashStorage.h"
+
+/*
+ * Register a partition of pages with fstorage and declare its storage, use it
+ * once per partition at file scope. fstorage places the registrations at the
+ * end of the flash ordered by priority, every registration needs its own priority
+ * (the library storage of STORAGE_PAGES uses 0xFE).
+ */
+#define STORAGE_PARTITION(name, numPages, fsPriority)                  \
+    FS_REGISTER_CFG(fs_config_t name##_fs_config) = {                   \
+            .p_start_addr = 0,                                          \
+            .p_end_addr = (const uint32_t *) PAGE_SIZE_WORDS,           \
+            .callback = NRF52FlashStorage::eventHandler,                \
+            .num_pages = (numPages),                                    \
+            .priority = (fsPriority)                                    \
+    };                                                                  \
+    NRF52FlashStorage name(name##_fs_config)
+
+// entry of the partition table for a partition declared with STORAGE_PARTITION()
+#define STORAGE_PARTITION_ENTRY(name) { #name, &name }
+
+/**
+ * An entry of the partition table.
+ */
+struct NRF52FlashPartition {
+    const char *name;               //!< unique name of the partition
+    NRF52FlashStorage *storage;     //!< storage of the partition
+};
+
+/**
+ * A static table of the partitions of the firmware.
+ *
+ * fstorage assigns the pages of the registrations in fs_init(), so the table
+ * checks them after the initialization: every partition has pages, starts at a
+ * page boundary, lies inside the code flash and overlaps neither another
+ * partition nor the storage of the library. Services look their storage up by name.
+ *
+ * @code
+ * STORAGE_PARTITION(keys, 1, 0xFD);
+ * STORAGE_PARTITION(telemetry, 4, 0xFC);
+ *
+ * static const NRF52FlashPartition partitions[] = {
+ *         STORAGE_PARTITION_ENTRY(keys),
+ *         STORAGE_PARTITION_ENTRY(telemetry),
+ * };
+ * NRF52FlashPartitionTable partitionTable(partitions, 2);
+ *
+ * partitionTable.init();
+ * FlashStorage *log = partitionTable.find("telemetry");
+ * @endcode
+ */
+class NRF52FlashPartitionTable {
+
+public:
+
+    /*!
+     * @brief   Constructor
+     *
+     * @param partitions    the partitions, the table keeps the pointer
+     * @param count         number of partitions
+     */
+    NRF52FlashPartitionTable(const NRF52FlashPartition *partitions, uint8_t count);
+
+    /*!
+     * Initialize fstorage and check the partitions.
+     *
+     * @return  true, if fstorage is initialized and all partitions are valid
+     */
+    bool init();
+
+    /*!
+     * Check the partitions, fstorage has to be initialized.
+     *
+     * @return  true, if all partitions are valid and do not overlap
+     */
+    bool check() const;
+
+    /*!
+     * Find the storage of a partition.
+     *
+     * @param name          name of the partition
+     *
+     * @return  the storage, NULL if there is no partition of that name
+     */
+    NRF52FlashStorage *find(const char *name) const;
+
+    /*!
+     * Get the number of partitions.
+     */
+    uint8_t getCount() const { return count; }
+
+    /*!
+     * Get a partition.
+     *
+     * @param index         index in the table
+     *
+     * @return  the partition, NULL if the index is out of range
+     */
+    const NRF52FlashPartition *get(uint8_t index) const;
+
+private:
+    const NRF52FlashPartition *partitions;
+    uint8_t count;
+};
+
+#endif //UBIRCH_MBED_NRF52_STORAGE_NRF52FLASHPARTITIONS_H
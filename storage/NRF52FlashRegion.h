@@ -0,0 +1,161 @@
+/*!
+ * @file
+ * @brief NRF52FlashRegion.h
+ *
+ * Flash storage for Nordic nRF52 with a compile-time geometry.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#ifndef UBIRCH_MBED_NRF52_STORAGE_NRF52FLASHREGION_H
+#define UBIRCH_MBED_NRF52_STORAGE_NRF52FLASHREGION_H
+
+#include "FlashGeometry.h"
+#include "NRF52FlashStorage.h"
+
+/**
+ * A region of the storage with a geometry fixed at compile time.
+ *
+ * The region starts BasePage pages into the storage registered with fstorage
+ * and has Pages pages of PageWords words. A page of the region may span several
+ * flash pages (PageWords a multiple of PAGE_SIZE_WORDS), erasing one erases all
+ * of them. Locations are relative to the start of the region.
+ *
+ * The bounds checks, page index and alignment masks are constants, so the hot
+ * paths do not load the storage size or divide by the page size. A geometry that
+ * does not fit into the STORAGE_PAGES registered pages does not compile.
+ *
+ * @note    updateData() works on pages of up to PAGE_SIZE_WORDS words only
+ *
+ * @code
+ * NRF52FlashRegion<2> config;                          // first two pages
+ * NRF52FlashRegion<1, 2 * PAGE_SIZE_WORDS, 1> log;     // one 8 KB page after them
+ * @endcode
+ */
+template<uint32_t Pages, uint32_t PageWords = PAGE_SIZE_WORDS, uint32_t BasePage = 0>
+class NRF52FlashRegion : public NRF52FlashStorage {
+
+public:
+    typedef FlashGeometry<Pages, PageWords> Geometry;
+
+    static const uint32_t FLASH_PAGES_PER_PAGE = PageWords / PAGE_SIZE_WORDS;   //!< flash pages per region page
+    static const uint32_t BASE = BasePage * Geometry::PAGE_SIZE;               //!< offset in the storage
+
+    FLASH_STATIC_ASSERT(PageWords % PAGE_SIZE_WORDS == 0 && PageWords >= PAGE_SIZE_WORDS,
+                        flash_region_page_not_multiple_of_flash_page);
+    FLASH_STATIC_ASSERT((BasePage + Pages) * FLASH_PAGES_PER_PAGE <= STORAGE_PAGES,
+                        flash_region_outside_of_storage_pages);
+
+    /*!
+     * @brief   Constructor
+     */
+    NRF52FlashRegion() {};
+
+    bool readData(uint32_t p_location, unsigned char *buffer, uint32_t length8) {
+        if (buffer == NULL || length8 == 0 || p_location >= Geometry::SIZE || length8 > Geometry::SIZE - p_location) {
+            return false;
+        }
+        return readMapped(BASE + p_location, buffer, length8);
+    }
+
+    bool writeData(uint32_t p_location, const unsigned char *buffer, uint32_t length8) {
+        if (buffer == NULL || length8 == 0 || !Geometry::contains(p_location, length8)) {
+            return false;
+        }
+        return writeIfBlank(BASE + p_location, buffer, length8);
+    }
+
+    bool programData(uint32_t p_location, const unsigned char *buffer, uint32_t length8) {
+        if (buffer == NULL || length8 == 0 || !Geometry::contains(p_location, length8)) {
+            return false;
+        }
+        return programChunks(BASE + p_location, buffer, length8);
+    }
+
+    bool writeDataAsync(uint32_t p_location, const unsigned char *buffer, uint32_t length8,
+                        FlashStorageCallback callback, void *context) {
+        if (!Geometry::contains(p_location, length8)) {
+            return false;
+        }
+        return NRF52FlashStorage::writeDataAsync(BASE + p_location, buffer, length8, callback, context);
+    }
+
+    /*!
+     * Erase pages of the region, erasePage() erases through this as well.
+     */
+    bool erasePageAsync(uint8_t page, uint8_t numPages, FlashStorageCallback callback, void *context) {
+        if (numPages == 0 || (uint32_t) page + numPages > Pages) {
+            lastError = FS_ERR_INVALID_ADDR;
+            return false;
+        }
+        return NRF52FlashStorage::erasePageAsync((uint8_t) ((BasePage + page) * FLASH_PAGES_PER_PAGE),
+                                                 (uint8_t) (numPages * FLASH_PAGES_PER_PAGE),
+                                                 callback, context);
+    }
+
+    /*!
+     * Erase a page of the region in slices, a page spanning several flash pages
+     * is erased completely in one slice.
+     */
+    bool eraseSlice(uint8_t page, bool &done) {
+        done = false;
+        if (page >= Pages) {
+            return false;
+        }
+        if (FLASH_PAGES_PER_PAGE > 1) {
+            done = erasePage(page, 1);
+            return done;
+        }
+        return NRF52FlashStorage::eraseSlice((uint8_t) (BasePage + page), done);
+    }
+
+    uint32_t findFirstNonBlank(uint32_t p_location, uint32_t length8) {
+        if (p_location >= Geometry::SIZE) {
+            return 0;
+        }
+        // everything after the end of the region is not usable, so it is not blank
+        if (length8 > Geometry::SIZE - p_location) length8 = Geometry::SIZE - p_location;
+        return scanBlank(mapped(p_location), length8);
+    }
+
+    const uint8_t *map(uint32_t p_location, uint32_t length8) {
+        if (p_location >= Geometry::SIZE || length8 > Geometry::SIZE - p_location) {
+            return NULL;
+        }
+        return mapped(p_location);
+    }
+
+    uint32_t getStartAddress() {
+        return NRF52FlashStorage::getStartAddress() + BASE;
+    }
+
+    uint32_t getEndAddress() {
+        return NRF52FlashStorage::getStartAddress() + BASE + Geometry::SIZE;
+    }
+
+    uint32_t getPageSize() {
+        return Geometry::PAGE_SIZE;
+    }
+
+private:
+    const uint8_t *mapped(uint32_t p_location) {
+        return (const uint8_t *) NRF52FlashStorage::getStartAddress() + BASE + p_location;
+    }
+};
+
+#endif //UBIRCH_MBED_NRF52_STORAGE_NRF52FLASHREGION_H
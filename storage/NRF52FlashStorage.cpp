@@ -36,10 +36,20 @@
  *  For more information about the flash-storage,
  *  see documentation for mbed fstorage
  */
+#include <string.h>
 #include "FlashStorage.h"
 #include <nrf_soc.h>
 #include <BLE.h>
 #include <nrf52_bitfields.h>
+#include <platform/SingletonPtr.h>
+#include <platform/PlatformMutex.h>
+#include <platform/mbed_critical.h>
+#include <hal/us_ticker_api.h>
+#include <cmsis.h>
+#ifdef MBED_CONF_RTOS_PRESENT
+#include <rtos/Semaphore.h>
+#include <rtos/Thread.h>
+#endif
 #include "NRF52FlashStorage.h"
 
 extern "C" {
@@ -50,20 +60,243 @@ extern "C" {
 #define PRINTF(...)
 //#define PRINTF printf
 
+#define STORAGE_STATS_CLOCK_US() us_ticker_read()
+
+// statistics of the path used for the flash operations right now
+#define STATS_PATH (fs_softdevice_enabled() ? stats.softdevice : stats.nosd)
+
 /*
-* flag for the callback, used to determine, when event handling is finished
-* so the rest of the program can continue
-*/
-static volatile uint8_t fs_callback_flag;
+ * pending asynchronous operations, fstorage completes them in the order they have been queued
+ */
+typedef struct {
+    FlashStorageCallback callback;                  // completion callback
+    void *context;                                  // context for the callback
+    NRF52FlashStorage *storage;                     // storage that queued the operation
+    uint32_t submitted;                             // time the operation was queued
+    uint32_t words;                                 // words to store, 0 for an erase
+    uint32_t location;                              // storage location, for the trace
+    uint32_t length;                                // length in bytes, for the trace
+    uint32_t data[STORAGE_ASYNC_BUFFER_WORDS];      // copy of the data to store
+} fs_async_op_t;
+
+static fs_async_op_t fs_ops[STORAGE_ASYNC_OPS];
+static volatile uint8_t fs_ops_head;           // next operation to complete, owned by the event handler
+static uint8_t fs_ops_tail;                     // next free operation, owned by the submitters
+static volatile uint8_t fs_ops_count;
+static uint32_t fs_ops_last_done;               // time the previous operation completed
+static volatile uint32_t fs_ops_completed;      // number of completed operations, the progress for the timeouts
+static void *volatile fs_ops_calling;           // context of the callback running right now
+
+// serializes the submitters, so the order of the queue matches the order of fstorage
+static SingletonPtr<PlatformMutex> fs_ops_mutex;
+
+#ifdef MBED_CONF_RTOS_PRESENT
+// wakes the threads waiting with FLASH_WAIT_SEMAPHORE on every completion
+static SingletonPtr<rtos::Semaphore> fs_ops_semaphore;
+static volatile uint8_t fs_ops_semaphore_waiters;
+#endif
+
+inline static bool fs_softdevice_enabled();
+
+/*
+ * wait for the next event of the fstorage event handler, at most waitMs (0 waits
+ * forever) with the semaphore, the caller checks its condition again
+ */
+static void fs_wait_event(FlashWaitStrategy strategy, uint32_t waitMs) {
+    switch (strategy) {
+        case FLASH_WAIT_SEMAPHORE:
+#ifdef MBED_CONF_RTOS_PRESENT
+            // the caller has registered as a waiter before it checked its condition
+            fs_ops_semaphore->wait(waitMs ? waitMs : osWaitForever);
+            break;
+#endif
+            // without RTOS the caller sleeps instead
+        case FLASH_WAIT_SLEEP:
+            // the softdevice events and the RTOS tick wake the CPU
+            if (fs_softdevice_enabled()) {
+                sd_app_evt_wait();
+            } else {
+                __WFE();
+            }
+            break;
+        default:
+            break;
+    }
+    (void) waitMs;
+}
+
+#ifdef MBED_CONF_RTOS_PRESENT
+/*
+ * register a waiter on the semaphore, the event handler releases it once per waiter,
+ * the tokens left when the last waiter is gone are dropped
+ */
+static void fs_semaphore_waiter(int8_t count) {
+    core_util_critical_section_enter();
+    fs_ops_semaphore_waiters = (uint8_t) (fs_ops_semaphore_waiters + count);
+    const bool last = fs_ops_semaphore_waiters == 0;
+    core_util_critical_section_exit();
+    if (last) {
+        while (fs_ops_semaphore->wait(0) > 0) /* drop */;
+    }
+}
+#endif
 
 inline static void fs_evt_handler(fs_evt_t const *const evt, fs_ret_t result) {
-    (void) evt;
-    if (result != FS_SUCCESS) {
-        PRINTF("    fstorage event handler ERROR   \r\n");
-    } else {
-        fs_callback_flag = 0;
+    NRF52FlashStorage::eventHandler(evt, result);
+}
+
+/*
+ * Wait until the condition is met. The timeout restarts with every completed
+ * operation, so it only expires when fstorage makes no progress.
+ *
+ * @return true, if the condition is met, false if the timeout expired
+ */
+static bool fs_wait_until(bool (*met)(void *), void *context, FlashWaitStrategy strategy, uint32_t timeoutMs) {
+#ifdef MBED_CONF_RTOS_PRESENT
+    // register before the condition is checked, so a completion in between releases the semaphore
+    const bool semaphore = strategy == FLASH_WAIT_SEMAPHORE;
+    if (semaphore) fs_semaphore_waiter(1);
+#endif
+    bool done = true;
+    uint32_t completed = fs_ops_completed;
+    uint32_t start = us_ticker_read();
+    while (!met(context)) {
+        if (completed != fs_ops_completed) {
+            completed = fs_ops_completed;
+            start = us_ticker_read();
+        }
+        const uint32_t elapsedMs = (us_ticker_read() - start) / 1000;
+        if (timeoutMs && elapsedMs >= timeoutMs) {
+            done = false;
+            break;
+        }
+        fs_wait_event(strategy, timeoutMs ? timeoutMs - elapsedMs : 0);
+    }
+#ifdef MBED_CONF_RTOS_PRESENT
+    if (semaphore) fs_semaphore_waiter(-1);
+#endif
+    return done;
+}
+
+/*
+ * Detach the pending operations of a wait that timed out from its context on
+ * the stack, they complete without a callback. A callback running right now
+ * is waited for.
+ */
+static void fs_ops_detach(void *context) {
+    core_util_critical_section_enter();
+    for (uint8_t n = 0; n < fs_ops_count; n++) {
+        fs_async_op_t *op = &fs_ops[(fs_ops_head + n) % STORAGE_ASYNC_OPS];
+        if (op->context == context) {
+            op->callback = NULL;
+            op->context = NULL;
+        }
+    }
+    core_util_critical_section_exit();
+    while (fs_ops_calling == context) /* do nothing */;
+}
+
+static bool fs_ops_free(void *context) {
+    (void) context;
+    return fs_ops_count < STORAGE_ASYNC_OPS;
+}
+
+/*
+ * back off before retrying an operation fstorage refused, the delay doubles with every attempt
+ */
+static void fs_backoff(uint8_t attempt, FlashWaitStrategy strategy) {
+    const uint32_t delay = (uint32_t) STORAGE_RETRY_BACKOFF_US << attempt;
+#ifdef MBED_CONF_RTOS_PRESENT
+    // the thread sleeps, with the resolution of the RTOS tick
+    if (strategy == FLASH_WAIT_SEMAPHORE) {
+        rtos::Thread::wait((delay + 999) / 1000);
+        return;
+    }
+#endif
+    // fstorage is busy with the queued operations, their events wake the CPU, the retry follows the first one
+    if (strategy != FLASH_WAIT_SPIN && fs_softdevice_enabled()) {
+        sd_app_evt_wait();
+        return;
+    }
+    const uint32_t start = us_ticker_read();
+    while (us_ticker_read() - start < delay) /* do nothing */;
+}
+
+/*
+ * completion of a blocking operation, used to wait for the asynchronous operation to finish
+ */
+typedef struct {
+    volatile bool done;
+    fs_ret_t result;
+} fs_completion_t;
+
+static void fs_complete(void *context, fs_ret_t result) {
+    fs_completion_t *completion = (fs_completion_t *) context;
+    completion->result = result;
+    completion->done = true;
+}
+
+static bool fs_completion_done(void *context) {
+    return ((fs_completion_t *) context)->done;
+}
+
+static fs_ret_t fs_wait(fs_completion_t *completion, FlashWaitStrategy strategy, uint32_t timeoutMs) {
+    if (!completion->done) {
+        STORAGE_TRACE_EVENT(FLASH_TRACE_WAIT_BEGIN, 0, 0, FS_SUCCESS);
+        if (!fs_wait_until(fs_completion_done, completion, strategy, timeoutMs)) {
+            fs_ops_detach(completion);
+            if (!completion->done) completion->result = FS_ERR_OPERATION_TIMEOUT;
+        }
+        STORAGE_TRACE_EVENT(FLASH_TRACE_WAIT_END, 0, 0, completion->result);
+    }
+    return completion->result;
+}
+
+/*
+ * completion of a batch of operations queued back to back, keeps the first error
+ */
+typedef struct {
+    volatile int32_t pending;
+    volatile fs_ret_t result;
+} fs_batch_t;
+
+static void fs_batch_add(fs_batch_t *batch, int32_t count) {
+    core_util_critical_section_enter();
+    batch->pending += count;
+    core_util_critical_section_exit();
+}
+
+static void fs_batch_complete(void *context, fs_ret_t result) {
+    fs_batch_t *batch = (fs_batch_t *) context;
+    if (result != FS_SUCCESS && batch->result == FS_SUCCESS) {
+        batch->result = result;
+    }
+    fs_batch_add(batch, -1);
+}
+
+static bool fs_batch_done(void *context) {
+    return ((fs_batch_t *) context)->pending <= 0;
+}
+
+static fs_ret_t fs_batch_wait(fs_batch_t *batch, FlashWaitStrategy strategy, uint32_t timeoutMs) {
+    if (batch->pending > 0) {
+        STORAGE_TRACE_EVENT(FLASH_TRACE_WAIT_BEGIN, 0, 0, FS_SUCCESS);
+        if (!fs_wait_until(fs_batch_done, batch, strategy, timeoutMs)) {
+            fs_ops_detach(batch);
+            if (batch->pending > 0) batch->result = FS_ERR_OPERATION_TIMEOUT;
+        }
+        STORAGE_TRACE_EVENT(FLASH_TRACE_WAIT_END, 0, 0, batch->result);
     }
-};
+    return batch->result;
+}
+
+inline static bool fs_softdevice_enabled() {
+#ifdef NRF52
+    return softdevice_handler_isEnabled();
+#elif NRF52840_XXAA
+    return softdevice_handler_is_enabled();
+#endif
+}
 
 /*
  * set the configuration
@@ -78,6 +311,118 @@ FS_REGISTER_CFG(fs_config_t fs_config) =
         };
 
 
+uint32_t NRF52FlashStorage::storeBurstWords = STORAGE_BURST_WORDS;
+volatile uint32_t NRF52FlashStorage::sdChunkWords = STORAGE_ASYNC_BUFFER_WORDS;
+uint32_t NRF52FlashStorage::connectionIntervalUs = 0;
+
+
+NRF52FlashStorage::NRF52FlashStorage()
+        : config(&fs_config), slicePage(0xFFFF), sliceMs(0), waitStrategy(STORAGE_WAIT_STRATEGY),
+          timeoutMs(STORAGE_TIMEOUT_MS) {
+}
+
+
+NRF52FlashStorage::NRF52FlashStorage(const fs_config_t &partition)
+        : config(&partition), slicePage(0xFFFF), sliceMs(0), waitStrategy(STORAGE_WAIT_STRATEGY),
+          timeoutMs(STORAGE_TIMEOUT_MS) {
+}
+
+
+void NRF52FlashStorage::eventHandler(fs_evt_t const *const evt, fs_ret_t result) {
+    (void) evt;
+    if (result != FS_SUCCESS) {
+        PRINTF("    fstorage event handler ERROR   \r\n");
+    }
+    if (fs_ops_count == 0) {
+        return;
+    }
+
+    // the operations are done one after the other, so the time of an operation
+    // starts when it was queued or when the previous one was done
+    fs_async_op_t *op = &fs_ops[fs_ops_head];
+    const uint32_t now = us_ticker_read();
+    const uint32_t start = now - op->submitted < now - fs_ops_last_done ? op->submitted : fs_ops_last_done;
+    fs_ops_last_done = now;
+    if (op->storage != NULL) {
+        op->storage->chunkComplete(now - start, op->words, result);
+    }
+
+    // release the operation before the callback, so a waiter sees it done; the callback
+    // runs in interrupt context and must not queue operations, a waiter that timed out
+    // may detach the callback up to here
+    STORAGE_TRACE_EVENT(FLASH_TRACE_CALLBACK, op->location, op->length, result);
+    core_util_critical_section_enter();
+    FlashStorageCallback callback = op->callback;
+    void *context = op->context;
+    fs_ops_calling = context;
+    fs_ops_head = (uint8_t) ((fs_ops_head + 1) % STORAGE_ASYNC_OPS);
+    fs_ops_count--;
+    fs_ops_completed++;
+    core_util_critical_section_exit();
+
+    if (callback != NULL) {
+        callback(context, result);
+    }
+    fs_ops_calling = NULL;
+#ifdef MBED_CONF_RTOS_PRESENT
+    for (uint8_t n = fs_ops_semaphore_waiters; n > 0; n--) {
+        fs_ops_semaphore->release();
+    }
+#endif
+}
+
+
+void NRF52FlashStorage::chunkComplete(uint32_t us, uint32_t words, fs_ret_t result) {
+    STORAGE_STATS_ADD(stats.softdevice.chunks, 1);
+    STORAGE_STATS_ADD(stats.softdevice.chunkTimeUs, us);
+#if STORAGE_STATS
+    if (us > stats.softdevice.maxChunkUs) stats.softdevice.maxChunkUs = us;
+#endif
+    if (result != FS_SUCCESS) {
+        STORAGE_STATS_ADD(stats.softdevice.chunkFailures, 1);
+    }
+
+    // erases take a page, whatever the chunk size is
+    if (words == 0 && result == FS_SUCCESS) {
+        return;
+    }
+
+    // additive increase after a full chunk in time, halve on failure or a missed connection interval
+    const uint32_t limit = chunkLimitWords();
+    uint32_t chunk = sdChunkWords;
+    if (result != FS_SUCCESS || (connectionIntervalUs && us > connectionIntervalUs)) {
+        chunk /= 2;
+    } else if (words >= chunk) {
+        chunk += STORAGE_SD_CHUNK_STEP_WORDS;
+    }
+    if (chunk > limit) chunk = limit;
+    if (chunk < STORAGE_SD_CHUNK_MIN_WORDS) chunk = STORAGE_SD_CHUNK_MIN_WORDS;
+    sdChunkWords = chunk;
+}
+
+
+uint32_t NRF52FlashStorage::chunkLimitWords() {
+    const uint32_t interval = connectionIntervalUs;
+    if (interval == 0) {
+        return STORAGE_ASYNC_BUFFER_WORDS;
+    }
+    const uint32_t words = interval > STORAGE_SD_RADIO_RESERVE_US
+                           ? (interval - STORAGE_SD_RADIO_RESERVE_US) / STORAGE_WORD_WRITE_US : 0;
+    if (words < STORAGE_SD_CHUNK_MIN_WORDS) return STORAGE_SD_CHUNK_MIN_WORDS;
+    return words < STORAGE_ASYNC_BUFFER_WORDS ? words : STORAGE_ASYNC_BUFFER_WORDS;
+}
+
+
+void NRF52FlashStorage::setConnectionInterval(uint32_t intervalUs) {
+    connectionIntervalUs = intervalUs;
+    if (sdChunkWords > chunkLimitWords()) sdChunkWords = chunkLimitWords();
+}
+
+
+uint32_t NRF52FlashStorage::getChunkWords() {
+    return sdChunkWords;
+}
+
 // adapted from an example found here:
 // https://devzone.nordicsemi.com/question/54763/sd_flash_write-implementation-without-softdevice/
 fs_ret_t NRF52FlashStorage::nosd_erase_page(const fs_config_t *p_config,
@@ -130,6 +475,55 @@ fs_ret_t NRF52FlashStorage::nosd_erase_page(const fs_config_t *p_config,
 }
 
 
+#ifdef STORAGE_PARTIAL_ERASE
+fs_ret_t NRF52FlashStorage::nosd_erase_page_partial(const fs_config_t *p_config,
+                                                    const uint32_t *page_address,
+                                                    uint32_t duration_ms) {
+    if (page_address == NULL) {
+        return FS_ERR_NULL_ARG;
+    }
+
+    // Check that the page is aligned to a page boundary.
+    if (((uint32_t) page_address % NRF_FICR->CODEPAGESIZE) != 0) {
+        return FS_ERR_UNALIGNED_ADDR;
+    }
+
+    // Check that the operation doesn't go outside the client's memory boundaries.
+    if ((page_address < p_config->p_start_addr) ||
+        (page_address + PAGE_SIZE_WORDS > p_config->p_end_addr)) {
+        return FS_ERR_INVALID_ADDR;
+    }
+
+    if (duration_ms == 0 || duration_ms > NVMC_ERASEPAGEPARTIALCFG_DURATION_Msk) {
+        return FS_ERR_INVALID_ARG;
+    }
+
+    // Turn on flash erase enable and wait until the NVMC is ready:
+    NRF_NVMC->CONFIG = (NVMC_CONFIG_WEN_Een << NVMC_CONFIG_WEN_Pos);
+
+    while (NRF_NVMC->READY == NVMC_READY_READY_Busy) {
+        // Do nothing.
+    }
+
+    PRINTF("NOSD partial erase(0x%08x, %d ms)\r\n", (unsigned int) page_address, duration_ms);
+    NRF_NVMC->ERASEPAGEPARTIALCFG = duration_ms << NVMC_ERASEPAGEPARTIALCFG_DURATION_Pos;
+    NRF_NVMC->ERASEPAGEPARTIAL = (uint32_t) page_address;
+
+    while (NRF_NVMC->READY == NVMC_READY_READY_Busy) {
+        // Do nothing.
+    }
+
+    // Turn off flash erase enable and wait until the NVMC is ready:
+    NRF_NVMC->CONFIG = (NVMC_CONFIG_WEN_Ren << NVMC_CONFIG_WEN_Pos);
+
+    while (NRF_NVMC->READY == NVMC_READY_READY_Busy) {
+        // Do nothing.
+    }
+    return FS_SUCCESS;
+}
+#endif
+
+
 fs_ret_t NRF52FlashStorage::nosd_store(const fs_config_t *p_config,
                                        uint32_t *p_dest,
                                        uint32_t *p_src,
@@ -155,7 +549,11 @@ fs_ret_t NRF52FlashStorage::nosd_store(const fs_config_t *p_config,
     }
 
     PRINTF("NOSD STORE 0x%08x (%d words)\r\n", (unsigned int) p_dest, size);
-    for (uint32_t i = 0; i < size; i++) {
+    while (size > 0) {
+        // program a burst of words with write enable turned on only once
+        uint32_t burst = size < storeBurstWords ? size : storeBurstWords;
+        size -= burst;
+
         // Turn on flash write enable and wait until the NVMC is ready:
         NRF_NVMC->CONFIG = (NVMC_CONFIG_WEN_Wen << NVMC_CONFIG_WEN_Pos);
 
@@ -163,11 +561,12 @@ fs_ret_t NRF52FlashStorage::nosd_store(const fs_config_t *p_config,
             // Do nothing.
         }
 
-        *p_dest = *p_src;
-        p_src++;
+        while (burst--) {
+            *(volatile uint32_t *) p_dest++ = *p_src++;
 
-        while (NRF_NVMC->READY == NVMC_READY_READY_Busy) {
-            // Do nothing.
+            while (NRF_NVMC->READY == NVMC_READY_READY_Busy) {
+                // Do nothing.
+            }
         }
 
         // Turn off flash write enable and wait until the NVMC is ready:
@@ -176,14 +575,27 @@ fs_ret_t NRF52FlashStorage::nosd_store(const fs_config_t *p_config,
         while (NRF_NVMC->READY == NVMC_READY_READY_Busy) {
             // Do nothing.
         }
-
-        p_dest++;
     }
 
     return FS_SUCCESS;
 }
 
 
+void NRF52FlashStorage::setStoreBurst(uint32_t words) {
+    storeBurstWords = words ? words : 1;
+}
+
+
+void NRF52FlashStorage::setWaitStrategy(FlashWaitStrategy strategy) {
+    waitStrategy = strategy;
+}
+
+
+void NRF52FlashStorage::setTimeout(uint32_t ms) {
+    timeoutMs = ms;
+}
+
+
 bool NRF52FlashStorage::init() {
     /*
      * initialize the storage and check for success
@@ -201,171 +613,466 @@ bool NRF52FlashStorage::init() {
 
 bool NRF52FlashStorage::readData(uint32_t p_location,
                                  unsigned char *buffer,
-                                 uint16_t length8) {
+                                 uint32_t length8) {
     if (buffer == NULL || length8 == 0) {
         return false;
     }
 
-    // determine the real location alligned to 32bit (4Byte) values
-    uint8_t preLength = (uint8_t) (p_location % 4);
-    uint32_t locationReal = p_location - preLength;
-    // determine the required length, considering the preLength
-    uint16_t lengthReal = (uint16_t) (length8 + preLength);
-    if (lengthReal % 4) {
-        lengthReal += 4 - (lengthReal % 4);
+    // the flash is memory mapped, so the read may go past the end of the storage,
+    // but it has to stay inside the code flash
+    const uint32_t address = (uint32_t) config->p_start_addr + p_location;
+    const uint32_t flashSize = NRF_FICR->CODEPAGESIZE * NRF_FICR->CODESIZE;
+    if (address < p_location || address > flashSize || length8 > flashSize - address) {
+        PRINTF("ERROR READ OUTSIDE OF FLASH \r\n");
+        return false;
     }
 
-    uint16_t length32 = lengthReal >> 2;
-    uint32_t buf32[length32];
-    PRINTF("Data read from flash address 0x%X (%d words)\r\n",
-           (uint32_t) (fs_config.p_start_addr) + locationReal,
-           length32);
-    for (uint16_t i = 0; i < length32; i++) {
-        buf32[i] = *(fs_config.p_start_addr + (locationReal >> 2) + i);
-//        PRINTF("(%u)[0x%X] = %X", i, ((uint32_t) fs_config.p_start_addr + (locationReal >> 2) + i), buf32[i]);
-    }
-//    PRINTF("\r\n");
+    return readMapped(p_location, buffer, length8);
+}
+
+
+bool NRF52FlashStorage::readMapped(uint32_t p_location,
+                                   unsigned char *buffer,
+                                   uint32_t length8) {
+    const uint32_t address = (uint32_t) config->p_start_addr + p_location;
+    STORAGE_TRACE_EVENT(FLASH_TRACE_READ, p_location, length8, FS_SUCCESS);
+    STORAGE_STATS_ADD(STATS_PATH.reads, 1);
+    STORAGE_STATS_ADD(STATS_PATH.bytesRead, length8);
+    PRINTF("Data read from flash address 0x%X (%d bytes)\r\n", address, length8);
+    // little endian, the bytes are in memory exactly as they have been written
+    memcpy(buffer, (const uint8_t *) address, length8);
+    return true;
+}
 
-    // create a new buffer, to fill all the data and convert the data into it
-    unsigned char bufferReal[lengthReal];
-    if (!conv32to8(buf32, bufferReal, lengthReal)) {
-        return false;            // ERROR
+
+const uint8_t *NRF52FlashStorage::map(uint32_t p_location, uint32_t length8) {
+    const uint32_t size = (uint32_t) config->p_end_addr - (uint32_t) config->p_start_addr;
+    if (p_location >= size || length8 > size - p_location) {
+        return NULL;
     }
+    return (const uint8_t *) config->p_start_addr + p_location;
+}
+
 
-    // shift the data to the right position
-    for (int j = 0; j < length8; j++) {
-        buffer[j] = bufferReal[j + preLength];
+bool NRF52FlashStorage::erasePage(uint8_t page, uint8_t numPages) {
+    const uint32_t pageSize = getPageSize();
+    STORAGE_TRACE_EVENT(FLASH_TRACE_ERASE_BEGIN, page * pageSize, numPages * pageSize, FS_SUCCESS);
+    STORAGE_STATS_START(waitStart);
+    fs_ret_t ret = numPages ? FS_SUCCESS : FS_ERR_INVALID_ARG;
+    // with the softdevice every page is an operation of its own, that fits into a flash timeslot
+    const uint8_t step = fs_softdevice_enabled() ? 1 : numPages;
+    for (uint8_t i = 0; i < numPages && ret == FS_SUCCESS; i = (uint8_t) (i + step)) {
+        fs_completion_t completion = {false, FS_SUCCESS};
+        bool queued;
+        for (uint8_t attempt = 0;; attempt++) {
+            queued = erasePageAsync((uint8_t) (page + i), step, fs_complete, &completion);
+            if (queued || lastError != FS_ERR_QUEUE_FULL || attempt == STORAGE_RETRIES) break;
+            fs_backoff(attempt, waitStrategy);
+        }
+        ret = queued ? fs_wait(&completion, waitStrategy, timeoutMs) : lastError;
+    }
+    lastError = ret;
+    STORAGE_TRACE_EVENT(FLASH_TRACE_ERASE_END, page * pageSize, numPages * pageSize, ret);
+    if (ret != FS_SUCCESS) {
+        PRINTF("    fstorage ERASE ERROR    \r\n");
+        return false;
     }
+    // without softdevice the wait is accounted by erasePageAsync()
+    if (fs_softdevice_enabled()) STORAGE_STATS_WAIT(stats.softdevice, waitStart);
+    PRINTF("    fstorage ERASE successful    \r\n");
     return true;
 }
 
 
-bool NRF52FlashStorage::erasePage(uint8_t page, uint8_t numPages) {
-    // Erase one page (page 0).
+bool NRF52FlashStorage::erasePageAsync(uint8_t page, uint8_t numPages,
+                                       FlashStorageCallback callback, void *context) {
     PRINTF("flash erase 0x%X\r\n",
-           (uint32_t) (fs_config.p_start_addr + (PAGE_SIZE_WORDS * page)));
+           (uint32_t) (config->p_start_addr + (PAGE_SIZE_WORDS * page)));
 
+    const uint32_t location = page * PAGE_SIZE_WORDS * sizeof(uint32_t);
+    const uint32_t length = numPages * PAGE_SIZE_WORDS * sizeof(uint32_t);
     fs_ret_t ret;
+    // the submitters lock a mutex, which is not allowed in interrupt context (e.g. a completion callback)
+    if (core_util_is_isr_active()) {
+        lastError = FS_ERR_INVALID_ARG;
+        return false;
+    }
+    fs_ops_mutex->lock();
+    if (fs_softdevice_enabled()) {
+        if (fs_ops_count == STORAGE_ASYNC_OPS) {
+            fs_ops_mutex->unlock();
+            STORAGE_TRACE_EVENT(FLASH_TRACE_ERASE_SUBMIT, location, length, FS_ERR_QUEUE_FULL);
+            PRINTF("    fstorage QUEUE FULL    \r\n");
+            lastError = FS_ERR_QUEUE_FULL;
+            return false;
+        }
+        fs_async_op_t *op = &fs_ops[fs_ops_tail];
+        op->callback = callback;
+        op->context = context;
+        op->storage = this;
+        op->submitted = us_ticker_read();
+        op->words = 0;
+        op->location = location;
+        op->length = length;
+
+        core_util_critical_section_enter();
+        fs_ops_count++;
+        core_util_critical_section_exit();
 #ifdef NRF52
-    if (softdevice_handler_isEnabled()) {
-        fs_callback_flag = 1;
-        ret = fs_erase(&fs_config, fs_config.p_start_addr + (PAGE_SIZE_WORDS * page), numPages);
+        ret = fs_erase(config, config->p_start_addr + (PAGE_SIZE_WORDS * page), numPages);
 #elif NRF52840_XXAA
-	if (softdevice_handler_is_enabled()) {
-		fs_callback_flag = 1;
-		ret = fs_erase(&fs_config, fs_config.p_start_addr + (PAGE_SIZE_WORDS * page), numPages, NULL);
+        ret = fs_erase(config, config->p_start_addr + (PAGE_SIZE_WORDS * page), numPages, NULL);
 #endif
-        while (fs_callback_flag == 1) /* do nothing */ ;
+        if (ret == FS_SUCCESS) {
+            fs_ops_tail = (uint8_t) ((fs_ops_tail + 1) % STORAGE_ASYNC_OPS);
+            STORAGE_STATS_ADD(stats.softdevice.erases, numPages);
+        } else {
+            core_util_critical_section_enter();
+            fs_ops_count--;
+            core_util_critical_section_exit();
+        }
+        STORAGE_TRACE_EVENT(FLASH_TRACE_ERASE_SUBMIT, location, length, ret);
+        fs_ops_mutex->unlock();
     } else {
-        ret = nosd_erase_page(&fs_config,
-                              fs_config.p_start_addr + (PAGE_SIZE_WORDS * page),
+        // without softdevice the erase is done right away, waiting for NVMC READY
+        STORAGE_STATS_START(waitStart);
+        STORAGE_TRACE_EVENT(FLASH_TRACE_WAIT_BEGIN, location, length, FS_SUCCESS);
+        ret = nosd_erase_page(config,
+                              config->p_start_addr + (PAGE_SIZE_WORDS * page),
                               numPages);
+        STORAGE_TRACE_EVENT(FLASH_TRACE_WAIT_END, location, length, ret);
+        STORAGE_TRACE_EVENT(FLASH_TRACE_ERASE_SUBMIT, location, length, ret);
+        STORAGE_STATS_WAIT(stats.nosd, waitStart);
+        if (ret == FS_SUCCESS) STORAGE_STATS_ADD(stats.nosd.erases, numPages);
+        fs_ops_mutex->unlock();
+        if (ret == FS_SUCCESS && callback != NULL) {
+            callback(context, ret);
+        }
     }
 
-    if (ret != FS_SUCCESS) {
-        PRINTF("    fstorage ERASE ERROR    \r\n");
+    lastError = ret;
+    return ret == FS_SUCCESS;
+}
+
+
+bool NRF52FlashStorage::waitUntil(bool (*met)(void *), void *context) {
+    if (!fs_wait_until(met, context, waitStrategy, timeoutMs)) {
+        lastError = FS_ERR_OPERATION_TIMEOUT;
         return false;
-    } else {
-        PRINTF("    fstorage ERASE successful    \r\n");
     }
+    return true;
+}
 
-    return ret == FS_SUCCESS;
+
+bool NRF52FlashStorage::eraseSlice(uint8_t page, bool &done) {
+    done = false;
+#ifdef STORAGE_PARTIAL_ERASE
+    if (!fs_softdevice_enabled()) {
+        const uint32_t pageSize = PAGE_SIZE_WORDS * sizeof(uint32_t);
+        if (page != slicePage) {
+            slicePage = page;
+            sliceMs = 0;
+        }
+
+        STORAGE_STATS_START(sliceStart);
+        STORAGE_TRACE_EVENT(FLASH_TRACE_WAIT_BEGIN, page * pageSize, pageSize, FS_SUCCESS);
+        fs_ops_mutex->lock();
+        const fs_ret_t ret = nosd_erase_page_partial(config,
+                                                     config->p_start_addr + (PAGE_SIZE_WORDS * page),
+                                                     STORAGE_ERASE_SLICE_MS);
+        fs_ops_mutex->unlock();
+        STORAGE_TRACE_EVENT(FLASH_TRACE_WAIT_END, page * pageSize, pageSize, ret);
+        STORAGE_STATS_SLICE(stats.nosd, sliceStart);
+        STORAGE_STATS_WAIT(stats.nosd, sliceStart);
+        lastError = ret;
+        if (ret != FS_SUCCESS) {
+            PRINTF("    fstorage PARTIAL ERASE ERROR    \r\n");
+            slicePage = 0xFFFF;
+            return false;
+        }
+
+        // the page reads blank before the erase is complete, so the full erase time has to pass
+        sliceMs += STORAGE_ERASE_SLICE_MS;
+        if (sliceMs < STORAGE_ERASE_PAGE_MS) {
+            return true;
+        }
+        if (NRF52FlashStorage::findFirstNonBlank(page * pageSize, pageSize) == pageSize) {
+            STORAGE_STATS_ADD(stats.nosd.erases, 1);
+            slicePage = 0xFFFF;
+            done = true;
+            return true;
+        }
+        // a page that is still not blank after twice the erase time is broken
+        if (sliceMs >= 2 * STORAGE_ERASE_PAGE_MS) {
+            PRINTF("    fstorage PARTIAL ERASE INCOMPLETE    \r\n");
+            slicePage = 0xFFFF;
+            return false;
+        }
+        return true;
+    }
+#endif
+    // no partial erase, the page is erased in one slice
+    STORAGE_STATS_START(sliceStart);
+    done = erasePage(page, 1);
+    STORAGE_STATS_SLICE(STATS_PATH, sliceStart);
+    return done;
 }
 
 
 bool NRF52FlashStorage::writeData(uint32_t p_location,
                                   const unsigned char *buffer,
-                                  uint16_t length8) {
+                                  uint32_t length8) {
     if (buffer == NULL || length8 == 0) {
         PRINTF("ERROR NULL  \r\n");
         return false;
     }
 
-    // determine the real location aligned to 32bit (4Byte) values
-    uint8_t preLength = (uint8_t) (p_location % 4);
-    uint32_t locationReal = p_location - preLength;
-    // determine the required length, considering the preLength
-    uint16_t lengthReal = (uint16_t) (length8 + preLength);
-    if (lengthReal % 4) {
-        lengthReal += 4 - (lengthReal % 4);
+    // the whole write has to fit into the storage, so it is not stored partially
+    const uint32_t size = (uint32_t) config->p_end_addr - (uint32_t) config->p_start_addr;
+    if (p_location >= size || length8 > size - p_location || ((p_location + length8 + 3) & ~3U) > size) {
+        PRINTF("ERROR WRITE OUTSIDE OF STORAGE \r\n");
+        return false;
     }
 
-    PRINTF("write start=0x%08x, address=0x%08x (offset=%08x, real=0x%08x)\r\n",
-           (uint32_t) fs_config.p_start_addr,
-           ((uint32_t) fs_config.p_start_addr) + locationReal,
-           p_location,
-           locationReal);
+    return writeIfBlank(p_location, buffer, length8);
+}
 
-    // check, if there is already data in the buffer
-    unsigned char buffer8[1];
-    for (int index = 0; index < length8; index++) {
-        this->readData((p_location + index), buffer8, sizeof(uint8_t));
-        if (buffer8[0] != 0xFF) {
-            PRINTF("ERROR FLASH NOT EMPTY \r\n");
-            return false;
+
+bool NRF52FlashStorage::writeIfBlank(uint32_t p_location,
+                                     const unsigned char *buffer,
+                                     uint32_t length8) {
+    // check, if there is already data in the flash
+    if (NRF52FlashStorage::findFirstNonBlank(p_location, length8) < length8) {
+        PRINTF("ERROR FLASH NOT EMPTY \r\n");
+        STORAGE_STATS_ADD(STATS_PATH.blankCheckFailures, 1);
+        return false;
+    }
+
+    return programChunks(p_location, buffer, length8);
+}
+
+
+bool NRF52FlashStorage::programData(uint32_t p_location,
+                                    const unsigned char *buffer,
+                                    uint32_t length8) {
+    if (buffer == NULL || length8 == 0) {
+        PRINTF("ERROR NULL  \r\n");
+        return false;
+    }
+
+    // the whole write has to fit into the storage, so it is not stored partially
+    const uint32_t size = (uint32_t) config->p_end_addr - (uint32_t) config->p_start_addr;
+    if (p_location >= size || length8 > size - p_location || ((p_location + length8 + 3) & ~3U) > size) {
+        PRINTF("ERROR WRITE OUTSIDE OF STORAGE \r\n");
+        return false;
+    }
+
+    return programChunks(p_location, buffer, length8);
+}
+
+
+bool NRF52FlashStorage::programChunks(uint32_t p_location,
+                                      const unsigned char *buffer,
+                                      uint32_t length8) {
+    STORAGE_TRACE_EVENT(FLASH_TRACE_WRITE_BEGIN, p_location, length8, FS_SUCCESS);
+    STORAGE_STATS_ADD(STATS_PATH.writes, 1);
+    STORAGE_STATS_ADD(STATS_PATH.bytesWritten, length8);
+
+    // store the data in word aligned chunks that fit into the buffer of an asynchronous operation,
+    // the chunks are queued back to back and only wait for a free operation;
+    // with the softdevice the chunks adapt to the flash timeslots
+    const bool softdevice = fs_softdevice_enabled();
+    fs_batch_t batch = {0, FS_SUCCESS};
+    STORAGE_STATS_START(waitStart);
+    fs_ret_t ret = FS_SUCCESS;
+    for (uint32_t offset = 0; offset < length8 && ret == FS_SUCCESS && batch.result == FS_SUCCESS;) {
+        const uint32_t location = p_location + offset;
+        const uint32_t chunkWords = softdevice ? sdChunkWords : STORAGE_ASYNC_BUFFER_WORDS;
+        uint32_t chunk = chunkWords * 4 - (location % 4);
+        if (chunk > length8 - offset) chunk = length8 - offset;
+
+        if (fs_ops_count == STORAGE_ASYNC_OPS) {
+            STORAGE_TRACE_EVENT(FLASH_TRACE_WAIT_BEGIN, location, chunk, FS_SUCCESS);
+            if (!fs_wait_until(fs_ops_free, NULL, waitStrategy, timeoutMs)) ret = FS_ERR_OPERATION_TIMEOUT;
+            STORAGE_TRACE_EVENT(FLASH_TRACE_WAIT_END, location, chunk, ret);
+            if (ret != FS_SUCCESS) break;
         }
+        // retry, while fstorage is busy with the operations of other modules
+        fs_batch_add(&batch, 1);
+        for (uint8_t attempt = 0;; attempt++) {
+            ret = storeAsync(location, buffer + offset, chunk, fs_batch_complete, &batch);
+            if (ret != FS_ERR_QUEUE_FULL || attempt == STORAGE_RETRIES) break;
+            fs_backoff(attempt, waitStrategy);
+        }
+        if (ret != FS_SUCCESS) {
+            fs_batch_add(&batch, -1);
+            break;
+        }
+        offset += chunk;
     }
 
-    unsigned char bufferReal[lengthReal];
-    // shift the data in the buffer to the right location
-    // and fill the remaining bytes with 0xFF to not overwrite existing data in the memory
-    for (int j = 0; j < preLength; j++) {
-        bufferReal[j] = 0xFF;
+    // the chunks queued so far refer to the batch, so wait for them after an error as well
+    const fs_ret_t batchResult = fs_batch_wait(&batch, waitStrategy, timeoutMs);
+    if (ret == FS_SUCCESS) ret = batchResult;
+
+    // compare the data with the mapped flash, marginal cells or a brownout may not have programmed every bit
+    if (ret == FS_SUCCESS && verifyWrites) {
+        const uint8_t *memory = (const uint8_t *) config->p_start_addr + p_location;
+        if (!verifyMapped(memory, (uint32_t) memory, buffer, length8)) {
+            PRINTF("ERROR VERIFY 0x%08x\r\n", verifyFailure);
+            STORAGE_STATS_ADD(STATS_PATH.verifyFailures, 1);
+            ret = FS_ERR_INTERNAL;
+        }
     }
-    for (int k = 0; k < length8; k++) {
-        bufferReal[k + preLength] = buffer[k];
+    lastError = ret;
+    STORAGE_TRACE_EVENT(FLASH_TRACE_WRITE_END, p_location, length8, ret);
+    if (ret != FS_SUCCESS) {
+        PRINTF("    fstorage WRITE ERROR    \r\n");
+        return false;
     }
-    for (int l = (preLength + length8); l < lengthReal; l++) {
-        bufferReal[l] = 0xFF;
+    // without softdevice the wait is accounted by storeAsync()
+    if (softdevice) STORAGE_STATS_WAIT(stats.softdevice, waitStart);
+    PRINTF("    fstorage WRITE successful    \r\n");
+    return true;
+}
+
+
+bool NRF52FlashStorage::writeDataAsync(uint32_t p_location,
+                                       const unsigned char *buffer,
+                                       uint32_t length8,
+                                       FlashStorageCallback callback, void *context) {
+    if (buffer == NULL || length8 == 0) {
+        PRINTF("ERROR NULL  \r\n");
+        return false;
+    }
+
+    // the data is copied into the buffer of the operation, so it has to fit
+    if (length8 > STORAGE_ASYNC_BUFFER_WORDS * 4 - p_location % 4) {
+        PRINTF("ERROR ASYNC WRITE TOO LARGE \r\n");
+        return false;
     }
 
-    // convert the data into 32 bit array
-    uint16_t length32 = lengthReal >> 2;
-    uint32_t buf32[length32];
-    if (!this->conv8to32(bufferReal, buf32, lengthReal)) {
-        PRINTF("ERROR CONVERSION \r\n");
-        return false;            // ERROR
+    // check, if there is already data in the flash (in the coordinates of this class, not of a subclass)
+    if (NRF52FlashStorage::findFirstNonBlank(p_location, length8) < length8) {
+        PRINTF("ERROR FLASH NOT EMPTY \r\n");
+        STORAGE_STATS_ADD(STATS_PATH.blankCheckFailures, 1);
+        return false;
+    }
+
+    STORAGE_STATS_ADD(STATS_PATH.writes, 1);
+    STORAGE_STATS_ADD(STATS_PATH.bytesWritten, length8);
+    return storeAsync(p_location, buffer, length8, callback, context) == FS_SUCCESS;
+}
+
+
+fs_ret_t NRF52FlashStorage::storeAsync(uint32_t p_location,
+                                   const unsigned char *buffer,
+                                   uint32_t length8,
+                                   FlashStorageCallback callback, void *context) {
+    // determine the real location aligned to 32bit (4Byte) values
+    uint8_t preLength = (uint8_t) (p_location % 4);
+    uint32_t locationReal = p_location - preLength;
+    // determine the required length in words, considering the preLength
+    uint32_t length32 = (length8 + preLength + 3) >> 2;
+
+    PRINTF("write start=0x%08x, address=0x%08x (offset=%08x, real=0x%08x)\r\n",
+           (uint32_t) config->p_start_addr,
+           ((uint32_t) config->p_start_addr) + locationReal,
+           p_location,
+           locationReal);
+
+    // the submitters lock a mutex, which is not allowed in interrupt context (e.g. a completion callback)
+    if (core_util_is_isr_active()) {
+        lastError = FS_ERR_INVALID_ARG;
+        return FS_ERR_INVALID_ARG;
+    }
+    fs_ops_mutex->lock();
+    if (fs_ops_count == STORAGE_ASYNC_OPS) {
+        fs_ops_mutex->unlock();
+        STORAGE_TRACE_EVENT(FLASH_TRACE_STORE_SUBMIT, locationReal, length32 << 2, FS_ERR_QUEUE_FULL);
+        PRINTF("    fstorage QUEUE FULL    \r\n");
+        lastError = FS_ERR_QUEUE_FULL;
+        return FS_ERR_QUEUE_FULL;
     }
 
+    // copy the data into the buffer of the operation, at the right location
+    // and fill the remaining bytes with 0xFF to not overwrite existing data in the memory
+    fs_async_op_t *op = &fs_ops[fs_ops_tail];
+    op->data[0] = 0xFFFFFFFF;
+    op->data[length32 - 1] = 0xFFFFFFFF;
+    memcpy((uint8_t *) op->data + preLength, buffer, length8);
+    op->callback = callback;
+    op->context = context;
+    op->location = locationReal;
+    op->length = length32 << 2;
+
     fs_ret_t ret;
+    if (fs_softdevice_enabled()) {
+        op->storage = this;
+        op->submitted = us_ticker_read();
+        op->words = length32;
+        core_util_critical_section_enter();
+        fs_ops_count++;
+        core_util_critical_section_exit();
 #ifdef NRF52
-    if (softdevice_handler_isEnabled()) {
-
-        fs_callback_flag = 1;
-        ret = fs_store(&fs_config,
-                       (fs_config.p_start_addr + (locationReal >> 2)),
-                       buf32,
+        ret = fs_store(config,
+                       (config->p_start_addr + (locationReal >> 2)),
+                       op->data,
                        length32);      //Write data to memory address 0x0003F000. Check it with command: nrfjprog --memrd 0x0003F000 --n 16
 #elif NRF52840_XXAA
-	if (softdevice_handler_is_enabled()) {
-
-		fs_callback_flag = 1;
-		ret = fs_store(&fs_config, (fs_config.p_start_addr + (locationReal >> 2)), buf32,
-		               length32, NULL);      //Write data to memory address 0x0003F000. Check it with command: nrfjprog --memrd 0x0003F000 --n 16
+        ret = fs_store(config, (config->p_start_addr + (locationReal >> 2)), op->data,
+                       length32, NULL);      //Write data to memory address 0x0003F000. Check it with command: nrfjprog --memrd 0x0003F000 --n 16
 #endif
-        while (fs_callback_flag == 1) /* do nothing */;
+        if (ret == FS_SUCCESS) {
+            fs_ops_tail = (uint8_t) ((fs_ops_tail + 1) % STORAGE_ASYNC_OPS);
+            STORAGE_STATS_ADD(stats.softdevice.wordsProgrammed, length32);
+        } else {
+            core_util_critical_section_enter();
+            fs_ops_count--;
+            core_util_critical_section_exit();
+        }
+        STORAGE_TRACE_EVENT(FLASH_TRACE_STORE_SUBMIT, locationReal, length32 << 2, ret);
+        fs_ops_mutex->unlock();
     } else {
-        ret = nosd_store(&fs_config,
-                         (uint32_t *) (fs_config.p_start_addr + (locationReal >> 2)),
-                         buf32,
+        // without softdevice the data is stored right away, waiting for NVMC READY
+        STORAGE_STATS_START(waitStart);
+        STORAGE_TRACE_EVENT(FLASH_TRACE_WAIT_BEGIN, locationReal, length32 << 2, FS_SUCCESS);
+        ret = nosd_store(config,
+                         (uint32_t *) (config->p_start_addr + (locationReal >> 2)),
+                         op->data,
                          length32);
+        STORAGE_TRACE_EVENT(FLASH_TRACE_WAIT_END, locationReal, length32 << 2, ret);
+        STORAGE_TRACE_EVENT(FLASH_TRACE_STORE_SUBMIT, locationReal, length32 << 2, ret);
+        STORAGE_STATS_WAIT(stats.nosd, waitStart);
+        if (ret == FS_SUCCESS) STORAGE_STATS_ADD(stats.nosd.wordsProgrammed, length32);
+        fs_ops_mutex->unlock();
+        if (ret == FS_SUCCESS && callback != NULL) {
+            callback(context, ret);
+        }
     }
 
-    if (ret != FS_SUCCESS) {
-        PRINTF("    fstorage WRITE ERROR    \r\n");
-        return false;
-    } else {
-        PRINTF("    fstorage WRITE successful    \r\n");
-    }
+    lastError = ret;
+    return ret;
+}
 
-    return ret == FS_SUCCESS;
+uint32_t NRF52FlashStorage::findFirstNonBlank(uint32_t p_location, uint32_t length8) {
+    const uint32_t size = (uint32_t) config->p_end_addr - (uint32_t) config->p_start_addr;
+    if (p_location >= size) {
+        return 0;
+    }
+    // everything after the end of the storage is not usable, so it is not blank
+    uint32_t length = size - p_location < length8 ? size - p_location : length8;
+    return scanBlank((const uint8_t *) config->p_start_addr + p_location, length);
 }
 
 uint32_t NRF52FlashStorage::getStartAddress() {
-    return (uint32_t) (fs_config.p_start_addr);
+    return (uint32_t) (config->p_start_addr);
 }
 
 uint32_t NRF52FlashStorage::getEndAddress() {
-    return (uint32_t) (fs_config.p_end_addr);
+    return (uint32_t) (config->p_end_addr);
 }
 
+uint32_t NRF52FlashStorage::getPageSize() {
+    return PAGE_SIZE_WORDS * sizeof(uint32_t);
+}
@@ -53,11 +53,91 @@ extern "C" {
 #define STORAGE_PAGES 4
 #endif
 
+// number of asynchronous operations that can be pending at the same time
+#ifndef STORAGE_ASYNC_OPS
+#define STORAGE_ASYNC_OPS 4
+#endif
+
+// size of the data buffer of an asynchronous operation, larger writes are split into chunks
+#ifndef STORAGE_ASYNC_BUFFER_WORDS
+#define STORAGE_ASYNC_BUFFER_WORDS 64
+#endif
+
+/*
+ * maximum number of words programmed in one burst without the softdevice,
+ * the NVMC stays write enabled for up to STORAGE_BURST_WORDS * 41 µs
+ */
+#ifndef STORAGE_BURST_WORDS
+#define STORAGE_BURST_WORDS 32
+#endif
+
+/*
+ * with the softdevice writes are split into chunks, that adapt to the flash timeslots
+ * between this size and STORAGE_ASYNC_BUFFER_WORDS
+ */
+#ifndef STORAGE_SD_CHUNK_MIN_WORDS
+#define STORAGE_SD_CHUNK_MIN_WORDS 4
+#endif
+
+// words a chunk grows by after a chunk that fit into the timeslots
+#ifndef STORAGE_SD_CHUNK_STEP_WORDS
+#define STORAGE_SD_CHUNK_STEP_WORDS 4
+#endif
+
+// radio time of a connection event, the flash gets the rest of the connection interval
+#ifndef STORAGE_SD_RADIO_RESERVE_US
+#define STORAGE_SD_RADIO_RESERVE_US 2500
+#endif
+
+// time to program one word (tWRITE)
+#ifndef STORAGE_WORD_WRITE_US
+#define STORAGE_WORD_WRITE_US 41
+#endif
+
+/*
+ * longest time a blocking operation waits for fstorage to complete an operation,
+ * 0 waits forever; the operation fails with FS_ERR_OPERATION_TIMEOUT
+ */
+#ifndef STORAGE_TIMEOUT_MS
+#define STORAGE_TIMEOUT_MS 1000
+#endif
+
+// retries of an operation fstorage refused with FS_ERR_QUEUE_FULL
+#ifndef STORAGE_RETRIES
+#define STORAGE_RETRIES 4
+#endif
+
+// delay before the first retry, it doubles with every retry
+#ifndef STORAGE_RETRY_BACKOFF_US
+#define STORAGE_RETRY_BACKOFF_US 250
+#endif
+
+/**
+ * How a blocking operation waits for the flash with the softdevice.
+ */
+enum FlashWaitStrategy {
+    FLASH_WAIT_SPIN = 0,            //!< busy loop, the lowest latency
+    FLASH_WAIT_SLEEP,               //!< sleep until the next event (sd_app_evt_wait()), the CPU is halted
+    FLASH_WAIT_SEMAPHORE            //!< block the thread on a semaphore, other threads run (sleep without RTOS)
+};
+
+// wait strategy of new storages
+#ifndef STORAGE_WAIT_STRATEGY
+#define STORAGE_WAIT_STRATEGY FLASH_WAIT_SPIN
+#endif
+
 #if defined (NRF52)
 #define PAGE_SIZE_WORDS 1024
 #endif
 #if defined (NRF52840_XXAA)
 #define PAGE_SIZE_WORDS 1024
+// the NVMC of the nRF52840 can erase a page partially (ERASEPAGEPARTIAL)
+#define STORAGE_PARTIAL_ERASE 1
+#endif
+
+// accumulated time of the partial erases that erases a page (tERASEPAGE)
+#ifndef STORAGE_ERASE_PAGE_MS
+#define STORAGE_ERASE_PAGE_MS 85
 #endif
 
 /**
@@ -68,9 +148,17 @@ class NRF52FlashStorage : public FlashStorage {
 public:
 
     /*!
-     * @brief   Constructor
+     * @brief   Constructor, the storage uses the STORAGE_PAGES registered by the library
+     */
+    NRF52FlashStorage();
+
+    /*!
+     * @brief   Constructor for a partition with its own fstorage registration,
+     *          see STORAGE_PARTITION()
+     *
+     * @param partition     fstorage configuration of the partition
      */
-    NRF52FlashStorage() {};
+    explicit NRF52FlashStorage(const fs_config_t &partition);
 
     /*!
      * @brief   Destructor
@@ -98,7 +186,7 @@ public:
      */
     bool readData(uint32_t p_location,
                   unsigned char *buffer,
-                  uint16_t length8);
+                  uint32_t length8);
 
     /*!
      * Erase a page in the key storage
@@ -118,7 +206,106 @@ public:
      */
     bool writeData(uint32_t p_location,
                    const unsigned char *buffer,
-                   uint16_t length8);
+                   uint32_t length8);
+
+    /*!
+     * Program data into the key storage without checking that the area is blank.
+     *
+     * @param p_location 	location (pointer) inside the configured data space (32 Bit)
+     * @param buffer		pointer to the buffer with the data (8 Bit)
+     * @param length8 		length of data elements to write (8 Bit)
+     *
+     * @return 			    true, if writing successful, else false
+     */
+    bool programData(uint32_t p_location,
+                     const unsigned char *buffer,
+                     uint32_t length8);
+
+    /*!
+     * Write data to the key storage without waiting for the flash operation to finish.
+     * The data is copied into one of STORAGE_ASYNC_OPS operation buffers, so the
+     * buffer can be reused right away. Without softdevice the data is stored
+     * before the call returns.
+     *
+     * @note    the callback is called from the fstorage event handler (interrupt context),
+     *          post to an EventQueue for anything else than signaling; it must not queue
+     *          another operation, the call fails with FS_ERR_INVALID_ARG in interrupt context
+     *
+     * @param p_location 	location (pointer) inside the configured data space (32 Bit)
+     * @param buffer		pointer to the buffer with the data (8 Bit)
+     * @param length8 		length of data elements to write (8 Bit), at most
+     *                      STORAGE_ASYNC_BUFFER_WORDS * 4 - p_location % 4
+     * @param callback		called when the operation is finished, may be NULL
+     * @param context		passed to the callback
+     *
+     * @return 			    true, if the operation has been queued, false if it failed or the queue is full
+     */
+    bool writeDataAsync(uint32_t p_location,
+                        const unsigned char *buffer,
+                        uint32_t length8,
+                        FlashStorageCallback callback,
+                        void *context);
+
+    /*!
+     * Erase pages in the key storage without waiting for the flash operation to finish.
+     * Without softdevice the pages are erased before the call returns.
+     *
+     * @note    the callback is called from the fstorage event handler (interrupt context)
+     *          and must not queue another operation, see writeDataAsync()
+     *
+     * @param page			first page to erase
+     * @param numPages		number of pages to erase
+     * @param callback		called when the operation is finished, may be NULL
+     * @param context		passed to the callback
+     *
+     * @return 			    true, if the operation has been queued, false if it failed or the queue is full
+     */
+    bool erasePageAsync(uint8_t page,
+                        uint8_t numPages,
+                        FlashStorageCallback callback,
+                        void *context);
+
+    /*!
+     * Wait with the wait strategy of the storage, until the condition is met or
+     * fstorage completes nothing for the timeout.
+     */
+    bool waitUntil(bool (*met)(void *), void *context);
+
+    /*!
+     * Erase a page in slices. On the nRF52840 without softdevice every slice is a
+     * partial erase of STORAGE_ERASE_SLICE_MS (ERASEPAGEPARTIALCFG), the CPU is
+     * stopped for that time only. The page is done, when the slices add up to
+     * STORAGE_ERASE_PAGE_MS and it reads blank. On the nRF52832 and with the
+     * softdevice the page is erased completely in the first slice.
+     *
+     * @param page			page to erase
+     * @param done			set, if the page is erased completely
+     *
+     * @return 			    true, if the slice succeeded, else false
+     */
+    bool eraseSlice(uint8_t page, bool &done);
+
+    /*!
+     * Find the first byte that is not blank (0xFF) in the key storage.
+     * The memory mapped flash is checked directly, a word at a time.
+     *
+     * @param p_location	location (pointer) inside the configured data space (32 Bit)
+     * @param length8 		length of the area to check (8 Bit)
+     *
+     * @return 			    offset of the first non-blank byte relative to p_location,
+     * 						length8 if the whole area is blank
+     */
+    uint32_t findFirstNonBlank(uint32_t p_location, uint32_t length8);
+
+    /*!
+     * Map an area of the key storage for direct read access, without copying it.
+     *
+     * @param p_location	location (pointer) inside the configured data space (32 Bit)
+     * @param length8 		length of the area to map (8 Bit)
+     *
+     * @return 			    pointer into the memory mapped flash, NULL if the area is outside the storage
+     */
+    const uint8_t *map(uint32_t p_location, uint32_t length8);
 
     /*!
      * Get the start address of the storage.
@@ -133,7 +320,72 @@ public:
      * @return  end address
      */
     uint32_t getEndAddress();
+
+    /*!
+     * Get the size of a flash page.
+     *
+     * @return  page size in bytes
+     */
+    uint32_t getPageSize();
   
+    /*!
+     * Set the maximum number of words programmed in one burst without the Softdevice.
+     * Write enable is turned on once per burst, so a longer burst has less overhead,
+     * but keeps the NVMC busy longer. A burst of 1 word toggles write enable for every word.
+     *
+     * @param words         maximum burst length in 32 bit words (default STORAGE_BURST_WORDS)
+     */
+    static void setStoreBurst(uint32_t words);
+
+    /*!
+     * Set how the blocking operations of this storage wait for the flash. Without
+     * the softdevice the NVMC halts the CPU during the operation, there is no wait.
+     *
+     * @param strategy      wait strategy (default STORAGE_WAIT_STRATEGY)
+     */
+    void setWaitStrategy(FlashWaitStrategy strategy);
+
+    /*!
+     * Get the wait strategy of this storage.
+     */
+    FlashWaitStrategy getWaitStrategy() const { return waitStrategy; }
+
+    /*!
+     * Set how long the blocking operations of this storage wait for fstorage. The
+     * time restarts with every operation fstorage completes, so it bounds the time
+     * without progress and not the length of an operation. When it expires the
+     * operation fails, getLastError() returns FS_ERR_OPERATION_TIMEOUT and the
+     * pending operations complete without the caller.
+     *
+     * @param ms            timeout in ms, 0 waits forever (default STORAGE_TIMEOUT_MS)
+     */
+    void setTimeout(uint32_t ms);
+
+    /*!
+     * Set the current BLE connection interval. With the softdevice the chunks of a
+     * write are limited to what fits into the interval next to the radio event
+     * (STORAGE_SD_RADIO_RESERVE_US), and a chunk that takes longer than one interval
+     * halves the chunk size. Update it on connection, parameter update and disconnection.
+     *
+     * @param intervalUs    connection interval in µs, 0 if there is no connection
+     */
+    static void setConnectionInterval(uint32_t intervalUs);
+
+    /*!
+     * Get the current chunk size of writes with the softdevice. It grows by
+     * STORAGE_SD_CHUNK_STEP_WORDS with every chunk that completes in time and
+     * halves when fstorage fails or a chunk misses the connection interval.
+     *
+     * @return  chunk size in 32 bit words
+     */
+    static uint32_t getChunkWords();
+
+    /*!
+     * The fstorage event handler of all registrations, the operations of all
+     * storages are completed in the order they have been queued.
+     */
+    static void eventHandler(fs_evt_t const *const evt, fs_ret_t result);
+
 protected:
 
     /*!
@@ -149,6 +401,21 @@ protected:
                                     const uint32_t *page_address,
                                     uint32_t num_pages);
 
+#ifdef STORAGE_PARTIAL_ERASE
+    /*!
+     * Erase a flash storage page partially without using the Softdevice.
+     *
+     * @param p_config      Pointer to Storage configuration
+     * @param page_address  address of the page to be erased
+     * @param duration_ms   duration of the partial erase in ms
+     *
+     * @return fs_ret_t     fstorage return value, = FS_SUCCESS if successful
+     */
+    static fs_ret_t nosd_erase_page_partial(const fs_config_t *p_config,
+                                            const uint32_t *page_address,
+                                            uint32_t duration_ms);
+#endif
+
     /*!
      * Store data into flash storage without using the Softdevice.
      *
@@ -163,6 +430,88 @@ protected:
                                uint32_t *p_dest,
                                uint32_t *p_src,
                                uint32_t size);
+
+    /*!
+     * Copy data from the memory mapped flash, without checking the bounds.
+     *
+     * @param p_location	location (pointer) inside the configured data space (32 Bit)
+     * @param buffer		pointer to the buffer, where the data will be filled in (8 Bit)
+     * @param length8 		length of data elements to read (8 Bit)
+     *
+     * @return 			    true
+     */
+    bool readMapped(uint32_t p_location,
+                    unsigned char *buffer,
+                    uint32_t length8);
+
+    /*!
+     * Check that the area is blank and store the data, without checking the bounds.
+     *
+     * @param p_location 	location (pointer) inside the configured data space (32 Bit)
+     * @param buffer		pointer to the buffer with the data (8 Bit)
+     * @param length8 		length of data elements to write (8 Bit)
+     *
+     * @return 			    true, if writing successful, else false
+     */
+    bool writeIfBlank(uint32_t p_location,
+                      const unsigned char *buffer,
+                      uint32_t length8);
+
+    /*!
+     * Store data in chunks of an operation buffer and wait for the chunks,
+     * without checking the bounds or that the area is blank.
+     *
+     * @param p_location 	location (pointer) inside the configured data space (32 Bit)
+     * @param buffer		pointer to the buffer with the data (8 Bit)
+     * @param length8 		length of data elements to write (8 Bit)
+     *
+     * @return 			    true, if writing successful, else false
+     */
+    bool programChunks(uint32_t p_location,
+                       const unsigned char *buffer,
+                       uint32_t length8);
+
+    /*!
+     * Queue the data to be stored, without any checks of the target area.
+     *
+     * @param p_location 	location (pointer) inside the configured data space (32 Bit)
+     * @param buffer		pointer to the buffer with the data (8 Bit)
+     * @param length8 		length of data elements to write (8 Bit), has to fit into an operation buffer
+     * @param callback		called when the operation is finished, may be NULL
+     * @param context		passed to the callback
+     *
+     * @return fs_ret_t     FS_SUCCESS, if the operation has been queued
+     */
+    fs_ret_t storeAsync(uint32_t p_location,
+                    const unsigned char *buffer,
+                    uint32_t length8,
+                    FlashStorageCallback callback,
+                    void *context);
+
+    /*!
+     * Account a completed fstorage operation and adapt the chunk size to it.
+     *
+     * @param us            time fstorage took for the operation, without the time queued behind others
+     * @param words         words stored, 0 for an erase
+     * @param result        result of the operation
+     */
+    void chunkComplete(uint32_t us, uint32_t words, fs_ret_t result);
+
+    /*!
+     * Get the largest chunk that fits into the current connection interval.
+     */
+    static uint32_t chunkLimitWords();
+
+    const fs_config_t *config;
+
+    uint16_t slicePage;             // page of the partial erase in progress, 0xFFFF if none
+    uint16_t sliceMs;               // accumulated duration of its partial erases
+    FlashWaitStrategy waitStrategy;
+    uint32_t timeoutMs;
+
+    static uint32_t storeBurstWords;
+    static volatile uint32_t sdChunkWords;
+    static uint32_t connectionIntervalUs;
 };
 
 #ifdef __cplusplus
@@ -0,0 +1,325 @@
+/*!
+ * @file
+ * @brief SimulatedFlashStorage.cpp
+ *
+ * Simulated NOR flash with nRF52 semantics.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#include <string.h>
+#include "SimulatedFlashStorage.h"
+
+#define PRINTF(...)
+//#define PRINTF printf
+
+// the projected device time, the simulated flash has no softdevice
+#define STORAGE_STATS_CLOCK_US() ((uint32_t) (flash.elapsedNs / 1000))
+
+SimulatedFlash::SimulatedFlash(uint32_t numPages, uint32_t *memory, uint32_t pageSizeWords)
+        : maxBlockWrites(SIMULATED_BLOCK_WRITES),
+          numPages(numPages), pageSizeWords(pageSizeWords),
+          memory(memory), ownsMemory(memory == NULL) {
+    timing.wordWriteNs = 41000;
+    timing.pageEraseNs = 85000000;
+    timing.wordReadNs = 16;
+
+    if (ownsMemory) {
+        this->memory = new uint32_t[numPages * pageSizeWords];
+        memset(this->memory, 0xFF, getSize());
+    }
+    blockWrites = new uint16_t[numPages * pageSizeWords / SIMULATED_BLOCK_SIZE_WORDS];
+    memset(blockWrites, 0, numPages * pageSizeWords / SIMULATED_BLOCK_SIZE_WORDS * sizeof(uint16_t));
+    partialEraseNs = new uint32_t[numPages];
+    memset(partialEraseNs, 0, numPages * sizeof(uint32_t));
+    resetCounters();
+}
+
+SimulatedFlash::~SimulatedFlash() {
+    if (ownsMemory) delete[] memory;
+    delete[] blockWrites;
+    delete[] partialEraseNs;
+}
+
+void SimulatedFlash::resetCounters() {
+    elapsedNs = 0;
+    storeOps = 0;
+    eraseOps = 0;
+    wordsWritten = 0;
+    pagesErased = 0;
+    eraseSlices = 0;
+    bytesRead = 0;
+    bitViolations = 0;
+    blockWriteViolations = 0;
+}
+
+fs_ret_t SimulatedFlash::program(uint32_t offset, const uint8_t *data, uint32_t length) {
+    if (data == NULL) {
+        return FS_ERR_NULL_ARG;
+    }
+    if (length == 0) {
+        return FS_ERR_INVALID_ARG;
+    }
+    if (offset > getSize() || length > getSize() - offset) {
+        return FS_ERR_INVALID_ADDR;
+    }
+
+    const uint32_t first = offset >> 2;
+    const uint32_t last = (offset + length - 1) >> 2;
+
+    // check the write limit of all affected blocks before touching the memory
+    for (uint32_t block = first / SIMULATED_BLOCK_SIZE_WORDS; block <= last / SIMULATED_BLOCK_SIZE_WORDS; block++) {
+        uint32_t begin = block * SIMULATED_BLOCK_SIZE_WORDS;
+        uint32_t end = begin + SIMULATED_BLOCK_SIZE_WORDS - 1;
+        uint32_t words = (last < end ? last : end) - (first > begin ? first : begin) + 1;
+        if (blockWrites[block] + words > maxBlockWrites) {
+            PRINTF("SIM nWRITE exceeded in block %u\r\n", block);
+            blockWriteViolations++;
+            return FS_ERR_INTERNAL;
+        }
+    }
+
+    PRINTF("SIM STORE 0x%08x (%u words)\r\n", offset, last - first + 1);
+    storeOps++;
+    for (uint32_t index = first; index <= last; index++) {
+        // pad partial words with 0xFF, programming a 1 bit leaves the cell untouched
+        uint32_t word = 0xFFFFFFFF;
+        for (uint8_t i = 0; i < 4; i++) {
+            uint32_t byte = (index << 2) + i;
+            if (byte >= offset && byte < offset + length) {
+                word &= ~((uint32_t) 0xFF << (i << 3)) | ((uint32_t) data[byte - offset] << (i << 3));
+            }
+        }
+        if (word & ~memory[index]) {
+            bitViolations++;
+        }
+        memory[index] &= word;
+        blockWrites[index / SIMULATED_BLOCK_SIZE_WORDS]++;
+        wordsWritten++;
+        elapsedNs += timing.wordWriteNs;
+    }
+
+    return FS_SUCCESS;
+}
+
+fs_ret_t SimulatedFlash::erase(uint32_t page, uint32_t numPages) {
+    if (numPages == 0) {
+        return FS_ERR_INVALID_ARG;
+    }
+    if (page >= this->numPages || numPages > this->numPages - page) {
+        return FS_ERR_INVALID_ADDR;
+    }
+
+    PRINTF("SIM erase page %u (%u pages)\r\n", page, numPages);
+    eraseOps++;
+    memset(memory + page * pageSizeWords, 0xFF, numPages * getPageSize());
+    const uint32_t blocksPerPage = pageSizeWords / SIMULATED_BLOCK_SIZE_WORDS;
+    memset(blockWrites + page * blocksPerPage, 0, numPages * blocksPerPage * sizeof(uint16_t));
+    memset(partialEraseNs + page, 0, numPages * sizeof(uint32_t));
+    pagesErased += numPages;
+    elapsedNs += (uint64_t) timing.pageEraseNs * numPages;
+
+    return FS_SUCCESS;
+}
+
+fs_ret_t SimulatedFlash::erasePartial(uint32_t page, uint32_t durationNs, bool &erased) {
+    erased = false;
+    if (durationNs == 0) {
+        return FS_ERR_INVALID_ARG;
+    }
+    if (page >= numPages) {
+        return FS_ERR_INVALID_ADDR;
+    }
+
+    PRINTF("SIM partial erase page %u (%u ns)\r\n", page, durationNs);
+    eraseSlices++;
+    elapsedNs += durationNs;
+    partialEraseNs[page] += durationNs;
+    if (partialEraseNs[page] >= timing.pageEraseNs) {
+        // the erase itself is already accounted by the slices
+        const uint64_t elapsed = elapsedNs;
+        const fs_ret_t ret = erase(page, 1);
+        elapsedNs = elapsed;
+        erased = ret == FS_SUCCESS;
+        return ret;
+    }
+
+    return FS_SUCCESS;
+}
+
+fs_ret_t SimulatedFlash::read(uint32_t offset, uint8_t *data, uint32_t length) {
+    if (data == NULL) {
+        return FS_ERR_NULL_ARG;
+    }
+    if (offset > getSize() || length > getSize() - offset) {
+        return FS_ERR_INVALID_ADDR;
+    }
+
+    memcpy(data, (const uint8_t *) memory + offset, length);
+    bytesRead += length;
+    elapsedNs += (uint64_t) timing.wordReadNs * ((length + 3) >> 2);
+
+    return FS_SUCCESS;
+}
+
+
+SimulatedFlashStorage::SimulatedFlashStorage(SimulatedFlash &flash,
+                                             uint32_t firstPage,
+                                             uint32_t numPages,
+                                             uint32_t baseAddress)
+        : flash(flash),
+          startOffset(firstPage * flash.getPageSize()),
+          size(numPages * flash.getPageSize()),
+          baseAddress(baseAddress) {}
+
+bool SimulatedFlashStorage::init() {
+    return startOffset + size <= flash.getSize();
+}
+
+bool SimulatedFlashStorage::readData(uint32_t p_location,
+                                     unsigned char *buffer,
+                                     uint32_t length8) {
+    if (buffer == NULL || length8 == 0) {
+        return false;
+    }
+    // like memory mapped flash, reads are possible beyond the end of the storage
+    STORAGE_TRACE_EVENT(FLASH_TRACE_READ, p_location, length8, FS_SUCCESS);
+    STORAGE_STATS_ADD(stats.nosd.reads, 1);
+    STORAGE_STATS_ADD(stats.nosd.bytesRead, length8);
+    return flash.read(startOffset + p_location, buffer, length8) == FS_SUCCESS;
+}
+
+bool SimulatedFlashStorage::erasePage(uint8_t page, uint8_t numPages) {
+    const uint32_t pageSize = flash.getPageSize();
+    if (numPages == 0 || (uint32_t) (page + numPages) * pageSize > size) {
+        PRINTF("    simulated ERASE ERROR    \r\n");
+        return false;
+    }
+    STORAGE_TRACE_EVENT(FLASH_TRACE_ERASE_BEGIN, page * pageSize, numPages * pageSize, FS_SUCCESS);
+    STORAGE_STATS_START(waitStart);
+    const fs_ret_t ret = flash.erase(startOffset / pageSize + page, numPages);
+    lastError = ret;
+    const bool erased = ret == FS_SUCCESS;
+    STORAGE_STATS_WAIT(stats.nosd, waitStart);
+    STORAGE_TRACE_EVENT(FLASH_TRACE_ERASE_END, page * pageSize, numPages * pageSize, ret);
+    if (erased) STORAGE_STATS_ADD(stats.nosd.erases, numPages);
+    return erased;
+}
+
+bool SimulatedFlashStorage::eraseSlice(uint8_t page, bool &done) {
+    const uint32_t pageSize = flash.getPageSize();
+    done = false;
+    if ((uint32_t) (page + 1) * pageSize > size) {
+        PRINTF("    simulated ERASE ERROR    \r\n");
+        return false;
+    }
+    STORAGE_TRACE_EVENT(FLASH_TRACE_WAIT_BEGIN, page * pageSize, pageSize, FS_SUCCESS);
+    STORAGE_STATS_START(sliceStart);
+    const fs_ret_t ret = flash.erasePartial(startOffset / pageSize + page, STORAGE_ERASE_SLICE_MS * 1000000, done);
+    lastError = ret;
+    STORAGE_STATS_SLICE(stats.nosd, sliceStart);
+    STORAGE_STATS_WAIT(stats.nosd, sliceStart);
+    STORAGE_TRACE_EVENT(FLASH_TRACE_WAIT_END, page * pageSize, pageSize, ret);
+    if (done) STORAGE_STATS_ADD(stats.nosd.erases, 1);
+    return ret == FS_SUCCESS;
+}
+
+bool SimulatedFlashStorage::writeData(uint32_t p_location,
+                                      const unsigned char *buffer,
+                                      uint32_t length8) {
+    if (buffer == NULL || length8 == 0) {
+        PRINTF("ERROR NULL  \r\n");
+        return false;
+    }
+
+    // check, if there is already data in the flash
+    if (!isErased(p_location, length8)) {
+        PRINTF("ERROR FLASH NOT EMPTY \r\n");
+        STORAGE_STATS_ADD(stats.nosd.blankCheckFailures, 1);
+        return false;
+    }
+
+    return programData(p_location, buffer, length8);
+}
+
+bool SimulatedFlashStorage::programData(uint32_t p_location,
+                                        const unsigned char *buffer,
+                                        uint32_t length8) {
+    if (buffer == NULL || length8 == 0) {
+        PRINTF("ERROR NULL  \r\n");
+        return false;
+    }
+
+    // the write is word aligned, so the padded words have to fit into the storage
+    const uint32_t endReal = (p_location + length8 + 3) & ~3U;
+    if (p_location >= size || length8 > size - p_location || endReal > size) {
+        PRINTF("    simulated WRITE ERROR (address)   \r\n");
+        return false;
+    }
+
+    STORAGE_STATS_ADD(stats.nosd.writes, 1);
+    STORAGE_STATS_ADD(stats.nosd.bytesWritten, length8);
+    STORAGE_TRACE_EVENT(FLASH_TRACE_WRITE_BEGIN, p_location, length8, FS_SUCCESS);
+    STORAGE_STATS_START(waitStart);
+    fs_ret_t ret = flash.program(startOffset + p_location, buffer, length8);
+    if (ret == FS_SUCCESS) STORAGE_STATS_ADD(stats.nosd.wordsProgrammed, (endReal - (p_location & ~3U)) >> 2);
+
+    // compare the data with the flash, like reading it from mapped flash
+    if (ret == FS_SUCCESS && verifyWrites) {
+        flash.elapsedNs += (uint64_t) flash.timing.wordReadNs * ((length8 + 3) >> 2);
+        if (!verifyMapped(flash.getMemory() + startOffset + p_location, getStartAddress() + p_location,
+                          buffer, length8)) {
+            PRINTF("    simulated VERIFY ERROR 0x%08x    \r\n", verifyFailure);
+            STORAGE_STATS_ADD(stats.nosd.verifyFailures, 1);
+            ret = FS_ERR_INTERNAL;
+        }
+    }
+    lastError = ret;
+    const bool programmed = ret == FS_SUCCESS;
+    STORAGE_STATS_WAIT(stats.nosd, waitStart);
+    STORAGE_TRACE_EVENT(FLASH_TRACE_WRITE_END, p_location, length8, ret);
+    return programmed;
+}
+
+uint32_t SimulatedFlashStorage::findFirstNonBlank(uint32_t p_location, uint32_t length8) {
+    if (p_location >= size) {
+        return 0;
+    }
+    // everything after the end of the storage is not usable, so it is not blank
+    uint32_t length = size - p_location < length8 ? size - p_location : length8;
+    return scanBlank(flash.getMemory() + startOffset + p_location, length);
+}
+
+const uint8_t *SimulatedFlashStorage::map(uint32_t p_location, uint32_t length8) {
+    if (p_location >= size || length8 > size - p_location) {
+        return NULL;
+    }
+    return flash.getMemory() + startOffset + p_location;
+}
+
+uint32_t SimulatedFlashStorage::getStartAddress() {
+    return baseAddress + startOffset;
+}
+
+uint32_t SimulatedFlashStorage::getEndAddress() {
+    return baseAddress + startOffset + size;
+}
+
+uint32_t SimulatedFlashStorage::getPageSize() {
+    return flash.getPageSize();
+}
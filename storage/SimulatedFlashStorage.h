@@ -0,0 +1,246 @@
+/*!
+ * @file
+ * @brief SimulatedFlashStorage.h
+ *
+ * Simulated NOR flash with nRF52 semantics, used to run the storage
+ * library and its tests on a host without a dev kit.
+ *
+ * @date   2026-10-15
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+#ifndef UBIRCH_MBED_NRF52_STORAGE_SIMULATEDFLASHSTORAGE_H
+#define UBIRCH_MBED_NRF52_STORAGE_SIMULATEDFLASHSTORAGE_H
+
+#include <stdint.h>
+#include "FlashStorage.h"
+
+#ifndef SIMULATED_PAGE_SIZE_WORDS
+#define SIMULATED_PAGE_SIZE_WORDS 1024
+#endif
+
+// nRF52832: a block of 128 words may be written 181 times between erases (nWRITE,BLOCK)
+#ifndef SIMULATED_BLOCK_SIZE_WORDS
+#define SIMULATED_BLOCK_SIZE_WORDS 128
+#endif
+#ifndef SIMULATED_BLOCK_WRITES
+#define SIMULATED_BLOCK_WRITES 181
+#endif
+
+/**
+ * Cost model of the simulated flash, defaults taken from the nRF52832 product specification.
+ */
+struct SimulatedFlashTiming {
+    uint32_t wordWriteNs;       //!< time to program one word (tWRITE, 41 µs)
+    uint32_t pageEraseNs;       //!< time to erase one page (tERASEPAGE, 85 ms)
+    uint32_t wordReadNs;        //!< time to read one word from mapped flash
+};
+
+/**
+ * A simulated NOR flash device.
+ *
+ * Bits can only be programmed from 1 to 0, erase works on whole pages and
+ * sets them to 0xFF and each block may only be written a limited number of
+ * times between erases. Every operation is accounted in the cost model so
+ * a host build can report the projected device latency.
+ */
+class SimulatedFlash {
+
+public:
+
+    /*!
+     * @brief   Constructor
+     *
+     * @param numPages      number of pages of the device
+     * @param memory        backing memory (RAM or a mapped file) of numPages * pageSizeWords words,
+     *                      or NULL to allocate (and erase) it
+     * @param pageSizeWords page size in 32 bit words
+     */
+    SimulatedFlash(uint32_t numPages,
+                   uint32_t *memory = NULL,
+                   uint32_t pageSizeWords = SIMULATED_PAGE_SIZE_WORDS);
+
+    /*!
+     * @brief   Destructor
+     */
+    ~SimulatedFlash();
+
+    /*!
+     * Program data into the flash. The data is padded with 0xFF to whole words,
+     * just like the NVMC only programs whole words.
+     *
+     * @param offset        byte offset from the start of the device
+     * @param data          pointer to the data
+     * @param length        length of the data in bytes
+     *
+     * @return fs_ret_t     FS_SUCCESS if successful
+     */
+    fs_ret_t program(uint32_t offset, const uint8_t *data, uint32_t length);
+
+    /*!
+     * Erase pages, all bytes will read 0xFF afterwards.
+     *
+     * @param page          first page to erase
+     * @param numPages      number of pages to erase
+     *
+     * @return fs_ret_t     FS_SUCCESS if successful
+     */
+    fs_ret_t erase(uint32_t page, uint32_t numPages);
+
+    /*!
+     * Erase a page partially, like ERASEPAGEPARTIAL of the nRF52840. The page
+     * is erased once the accumulated duration of its slices reaches the page
+     * erase time, until then its contents do not change.
+     *
+     * @param page          page to erase
+     * @param durationNs    duration of this slice
+     * @param erased        set, if the page is erased now
+     *
+     * @return fs_ret_t     FS_SUCCESS if successful
+     */
+    fs_ret_t erasePartial(uint32_t page, uint32_t durationNs, bool &erased);
+
+    /*!
+     * Read data from the flash.
+     *
+     * @param offset        byte offset from the start of the device
+     * @param data          pointer to the buffer to fill
+     * @param length        length of the data in bytes
+     *
+     * @return fs_ret_t     FS_SUCCESS if successful
+     */
+    fs_ret_t read(uint32_t offset, uint8_t *data, uint32_t length);
+
+    /*!
+     * Get direct access to the flash contents (read-only, like mapped flash).
+     */
+    const uint8_t *getMemory() const { return (const uint8_t *) memory; }
+
+    /*!
+     * Get the size of the device in bytes.
+     */
+    uint32_t getSize() const { return numPages * pageSizeWords * sizeof(uint32_t); }
+
+    /*!
+     * Get the page size in bytes.
+     */
+    uint32_t getPageSize() const { return pageSizeWords * sizeof(uint32_t); }
+
+    /*!
+     * Reset the operation counters and the accumulated time.
+     */
+    void resetCounters();
+
+    SimulatedFlashTiming timing;        //!< cost model, may be changed at any time
+    uint32_t maxBlockWrites;            //!< allowed word writes per block between erases
+
+    uint64_t elapsedNs;                 //!< projected device time of all operations
+    uint32_t storeOps;                  //!< number of program operations
+    uint32_t eraseOps;                  //!< number of erase operations
+    uint32_t wordsWritten;              //!< number of words programmed
+    uint32_t pagesErased;               //!< number of pages erased
+    uint32_t eraseSlices;               //!< number of partial erase operations
+    uint32_t bytesRead;                 //!< number of bytes read
+    uint32_t bitViolations;             //!< attempts to program a bit from 0 to 1
+    uint32_t blockWriteViolations;      //!< refused writes because of the nWRITE limit
+
+private:
+    uint32_t numPages;
+    uint32_t pageSizeWords;
+    uint32_t *memory;
+    bool ownsMemory;
+    uint16_t *blockWrites;
+    uint32_t *partialEraseNs;           // accumulated partial erase time per page
+
+    // not copyable
+    SimulatedFlash(const SimulatedFlash &);
+    SimulatedFlash &operator=(const SimulatedFlash &);
+};
+
+/**
+ * Flash storage on a simulated flash device.
+ *
+ * The storage uses a page range of the device. Like the memory mapped flash on
+ * the nRF52, reads are possible on the whole device, while writes and erases are
+ * restricted to the storage pages.
+ */
+class SimulatedFlashStorage : public FlashStorage {
+
+public:
+
+    /*!
+     * @brief   Constructor
+     *
+     * @param flash         the simulated device
+     * @param firstPage     first device page of the storage
+     * @param numPages      number of pages of the storage
+     * @param baseAddress   address reported for the start of the device
+     */
+    SimulatedFlashStorage(SimulatedFlash &flash,
+                          uint32_t firstPage,
+                          uint32_t numPages,
+                          uint32_t baseAddress = 0);
+
+    /*!
+     * @brief   Destructor
+     */
+    ~SimulatedFlashStorage() {};
+
+    bool init();
+
+    bool readData(uint32_t p_location,
+                  unsigned char *buffer,
+                  uint32_t length8);
+
+    bool erasePage(uint8_t page, uint8_t numPages);
+
+    /*!
+     * Erase a page in slices of STORAGE_ERASE_SLICE_MS of device time.
+     */
+    bool eraseSlice(uint8_t page, bool &done);
+
+    bool writeData(uint32_t p_location,
+                   const unsigned char *buffer,
+                   uint32_t length8);
+
+    bool programData(uint32_t p_location,
+                     const unsigned char *buffer,
+                     uint32_t length8);
+
+    uint32_t findFirstNonBlank(uint32_t p_location, uint32_t length8);
+
+    const uint8_t *map(uint32_t p_location, uint32_t length8);
+
+    uint32_t getStartAddress();
+
+    uint32_t getEndAddress();
+
+    uint32_t getPageSize();
+
+    /*!
+     * Get the simulated device of this storage.
+     */
+    SimulatedFlash &getFlash() { return flash; }
+
+protected:
+    SimulatedFlash &flash;
+    uint32_t startOffset;
+    uint32_t size;
+    uint32_t baseAddress;
+};
+
+#endif //UBIRCH_MBED_NRF52_STORAGE_SIMULATEDFLASHSTORAGE_H